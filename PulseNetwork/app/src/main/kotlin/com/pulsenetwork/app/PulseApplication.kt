@@ -1,7 +1,17 @@
 package com.pulsenetwork.app
 
 import android.app.Application
+import com.pulsenetwork.core.native.LLMInference
+import com.pulsenetwork.core.native.MemoryTrimLevel
+import com.pulsenetwork.data.governor.InferenceThrottleController
+import com.pulsenetwork.domain.governor.Governor
+import com.pulsenetwork.domain.governor.MemoryPressure
 import dagger.hilt.android.HiltAndroidApp
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.launch
+import javax.inject.Inject
 
 /**
  * Pulse Network Application
@@ -11,8 +21,36 @@ import dagger.hilt.android.HiltAndroidApp
 @HiltAndroidApp
 class PulseApplication : Application() {
 
+    @Inject
+    lateinit var governor: Governor
+
+    @Inject
+    lateinit var llmInference: LLMInference
+
+    @Inject
+    lateinit var throttleController: InferenceThrottleController
+
+    private val appScope = CoroutineScope(SupervisorJob() + Dispatchers.Default)
+
     override fun onCreate() {
         super.onCreate()
-        // 初始化将在后续实现
+        observeMemoryPressure()
+        throttleController.start(appScope)
+    }
+
+    /**
+     * 系统内存压力时淘汰空闲的常驻模型（LLM 与语音模型共用预算）
+     */
+    private fun observeMemoryPressure() {
+        appScope.launch {
+            governor.memoryPressureFlow().collect { pressure ->
+                val level = when (pressure) {
+                    MemoryPressure.MODERATE -> MemoryTrimLevel.MODERATE
+                    MemoryPressure.LOW -> MemoryTrimLevel.LOW
+                    MemoryPressure.CRITICAL -> MemoryTrimLevel.CRITICAL
+                }
+                llmInference.trimMemory(level)
+            }
+        }
     }
 }
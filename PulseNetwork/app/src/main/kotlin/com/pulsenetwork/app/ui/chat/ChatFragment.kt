@@ -181,6 +181,11 @@ class ChatFragment : Fragment() {
         binding.messageList.visibility = if (isEmpty) View.INVISIBLE else View.VISIBLE
     }
 
+    override fun onStop() {
+        super.onStop()
+        viewModel.flushConversation()
+    }
+
     override fun onDestroyView() {
         super.onDestroyView()
         _binding = null
@@ -1,14 +1,26 @@
 package com.pulsenetwork.app.ui.chat
 
+import android.content.Context
 import androidx.lifecycle.LiveData
 import androidx.lifecycle.MutableLiveData
 import androidx.lifecycle.ViewModel
 import androidx.lifecycle.viewModelScope
 import com.pulsenetwork.app.service.VoiceRecorderService
+import com.pulsenetwork.core.native.AnswerEvent
+import com.pulsenetwork.core.native.ChatTurn
 import com.pulsenetwork.core.native.LLMInference
 import com.pulsenetwork.core.native.SpeechRecognition
+import com.pulsenetwork.data.swarm.SemanticCacheService
 import dagger.hilt.android.lifecycle.HiltViewModel
+import dagger.hilt.android.qualifiers.ApplicationContext
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+import org.json.JSONArray
+import org.json.JSONObject
+import java.io.File
 import java.util.*
 import javax.inject.Inject
 
@@ -17,9 +29,11 @@ import javax.inject.Inject
  */
 @HiltViewModel
 class ChatViewModel @Inject constructor(
+    @ApplicationContext private val context: Context,
     private val llmInference: LLMInference,
     private val speechRecognition: SpeechRecognition,
-    private val voiceRecorderService: VoiceRecorderService
+    private val voiceRecorderService: VoiceRecorderService,
+    private val semanticCache: SemanticCacheService
 ) : ViewModel() {
 
     private val _messages = MutableLiveData<List<ChatMessage>>()
@@ -42,12 +56,24 @@ class ChatViewModel @Inject constructor(
 
     private val messageList = mutableListOf<ChatMessage>()
 
+    // 本进程中只在第一次需要时尝试恢复快照，之后上下文被清空就按消息记录重建
+    private var restoreAttempted = false
+
+    // 会话快照（KV cache）与消息记录，重启后恢复对话无需重新预填充
+    private val sessionFile = File(context.filesDir, "chat.session")
+    private val historyFile = File(context.filesDir, "chat_history.json")
+
+    // 快照包含整个 KV cache，不在每轮之后立即写：连续对话时推迟到空闲，离开界面时立即写
+    private var saveJob: Job? = null
+    private var conversationDirty = false
+
     init {
         _messages.value = emptyList()
         _networkStatus.value = NetworkStatus.Offline
         _isRecording.value = false
         checkModelStatus()
         observeRecordingState()
+        loadHistory()
     }
 
     private fun checkModelStatus() {
@@ -117,7 +143,7 @@ class ChatViewModel @Inject constructor(
                     val index = messageList.indexOfFirst { it.id == placeholderMessage.id }
                     if (index >= 0) {
                         messageList[index] = placeholderMessage.copy(
-                            content = "🎤 ${result.text}"
+                            content = "$VOICE_PREFIX${result.text}"
                         )
                         _messages.value = messageList.toList()
 
@@ -138,6 +164,12 @@ class ChatViewModel @Inject constructor(
 
     private fun generateResponse(prompt: String) {
         _isGenerating.value = true
+        // 生成期间写快照会等待原生会话锁，推迟到本轮结束
+        saveJob?.cancel()
+        // 本轮之前的对话（最后一条是本轮的用户发言）
+        val past = messageList.filterNot { it.isStreaming }.dropLast(1)
+            .filter { it.content.isNotBlank() }
+            .map { it.toTurn() }
 
         val aiMessage = ChatMessage(
             id = UUID.randomUUID().toString(),
@@ -149,14 +181,40 @@ class ChatViewModel @Inject constructor(
         addMessage(aiMessage)
 
         viewModelScope.launch {
-            llmInference.generateStream(prompt).collect { token ->
-                val index = messageList.indexOfFirst { it.id == aiMessage.id }
-                if (index >= 0) {
-                    val updated = messageList[index].copy(
-                        content = messageList[index].content + token
-                    )
-                    messageList[index] = updated
-                    _messages.value = messageList.toList()
+            val turn = prepareTurn(past, prompt)
+            if (turn == null) {
+                removeMessage(aiMessage.id)
+                _isGenerating.value = false
+                _error.value = "无法开始对话"
+                return@launch
+            }
+            // 先查回答缓存，同一上下文中的相同或相近问题不再逐 token 解码
+            llmInference.chatWithCache(turn, prompt).collect { event ->
+                when (event) {
+                    is AnswerEvent.Token -> {
+                        val index = messageList.indexOfFirst { it.id == aiMessage.id }
+                        if (index >= 0) {
+                            val updated = messageList[index].copy(
+                                content = messageList[index].content + event.text
+                            )
+                            messageList[index] = updated
+                            _messages.value = messageList.toList()
+                        }
+                    }
+                    is AnswerEvent.Done -> {
+                        val result = event.result
+                        semanticCache.recordLookup(result.fromCache)
+                        val answer = messageList.firstOrNull { it.id == aiMessage.id }?.content
+                        // 只分享不依赖之前对话的回答
+                        if (!result.fromCache && past.isEmpty() && !answer.isNullOrBlank()) {
+                            semanticCache.addToLocalCache(
+                                prompt, answer,
+                                queryVector = result.embedding,
+                                vectorModel = result.embedding?.let { llmInference.getModelInfo()?.name },
+                                nodeId = LOCAL_NODE_ID
+                            )
+                        }
+                    }
                 }
             }
 
@@ -166,6 +224,106 @@ class ChatViewModel @Inject constructor(
                 _messages.value = messageList.toList()
             }
             _isGenerating.value = false
+            conversationDirty = true
+            scheduleSave()
+        }
+    }
+
+    /**
+     * 离开聊天界面时调用，立即写入尚未保存的对话
+     */
+    fun flushConversation() {
+        if (!conversationDirty || _isGenerating.value == true) return
+        saveJob?.cancel()
+        saveJob = viewModelScope.launch { saveConversation() }
+    }
+
+    private fun scheduleSave() {
+        saveJob?.cancel()
+        saveJob = viewModelScope.launch {
+            delay(SAVE_DELAY_MS)
+            saveConversation()
+        }
+    }
+
+    /**
+     * 本轮需要追加到原生上下文的内容（按模型的对话模板格式化）
+     *
+     * 原生对话仍在进行时只追加本轮。单次 / 批量生成（例如工作流步骤）会结束原生对话，
+     * 此时先尝试恢复快照（仅限本进程第一次），否则以系统提示词重新开始，
+     * 已有对话随本轮一起预填充，过长时原生侧只保留最近的部分
+     * @return 无法开始对话时为 null
+     */
+    private suspend fun prepareTurn(past: List<ChatTurn>, prompt: String): String? {
+        val system = listOf(ChatTurn(ChatTurn.ROLE_SYSTEM, SYSTEM_PROMPT))
+        val user = ChatTurn(ChatTurn.ROLE_USER, prompt)
+
+        if (!llmInference.isChatActive()) {
+            val restored = !restoreAttempted && sessionFile.exists() &&
+                llmInference.restoreSession(sessionFile.path) && llmInference.isChatActive()
+            restoreAttempted = true
+            if (!restored) {
+                val prefix = llmInference.applyChatTemplate(system, addAssistant = false)
+                if (!llmInference.startChat(prefix)) return null
+                return suffixAfter(prefix, llmInference.applyChatTemplate(system + past + user, addAssistant = true))
+            }
+        }
+        restoreAttempted = true
+
+        val before = llmInference.applyChatTemplate(system + past, addAssistant = false)
+        val turn = suffixAfter(before, llmInference.applyChatTemplate(system + past + user, addAssistant = true))
+        // 上一轮回复的结束符由原生会话补入上下文，模板里结束符之后的换行需要补上
+        return if (past.lastOrNull()?.role == ChatTurn.ROLE_ASSISTANT && before.endsWith("\n")) "\n$turn" else turn
+    }
+
+    private fun loadHistory() {
+        viewModelScope.launch {
+            val restored = withContext(Dispatchers.IO) {
+                if (!historyFile.exists()) return@withContext emptyList()
+                try {
+                    val array = JSONArray(historyFile.readText())
+                    (0 until array.length()).map { i ->
+                        val obj = array.getJSONObject(i)
+                        ChatMessage(
+                            id = obj.getString("id"),
+                            content = obj.getString("content"),
+                            isUser = obj.getBoolean("isUser"),
+                            timestamp = obj.getLong("timestamp")
+                        )
+                    }
+                } catch (e: Exception) {
+                    emptyList()
+                }
+            }
+            if (restored.isNotEmpty() && messageList.isEmpty()) {
+                messageList.addAll(restored)
+                _messages.value = messageList.toList()
+            }
+        }
+    }
+
+    private suspend fun saveConversation() {
+        conversationDirty = false
+        val snapshot = messageList.filterNot { it.isStreaming }
+        // 单次生成结束了原生对话时上下文里是工作流的内容，不能当作这段对话的快照；
+        // 旧快照也可能缺少最近几轮，删掉后重启时从消息历史重建
+        if (llmInference.isChatActive()) {
+            llmInference.saveSession(sessionFile.path)
+        } else {
+            withContext(Dispatchers.IO) { sessionFile.delete() }
+        }
+        withContext(Dispatchers.IO) {
+            val array = JSONArray()
+            snapshot.forEach { message ->
+                array.put(
+                    JSONObject()
+                        .put("id", message.id)
+                        .put("content", message.content)
+                        .put("isUser", message.isUser)
+                        .put("timestamp", message.timestamp)
+                )
+            }
+            historyFile.writeText(array.toString())
         }
     }
 
@@ -187,6 +345,30 @@ class ChatViewModel @Inject constructor(
     fun clearError() {
         _error.value = ""
     }
+
+    companion object {
+        private const val SYSTEM_PROMPT = "你是 Pulse 助手，一个运行在用户手机上的本地 AI，回答简洁准确。"
+
+        // 最后一轮结束后空闲这么久才写快照
+        private const val SAVE_DELAY_MS = 15_000L
+
+        // 本机生成的缓存条目来源
+        private const val LOCAL_NODE_ID = "local"
+
+        // 语音消息在界面上带的前缀，不属于对话内容
+        private const val VOICE_PREFIX = "🎤 "
+
+        private fun ChatMessage.toTurn() = ChatTurn(
+            role = if (isUser) ChatTurn.ROLE_USER else ChatTurn.ROLE_ASSISTANT,
+            content = content.removePrefix(VOICE_PREFIX)
+        )
+
+        /**
+         * full 中 prefix 之后的部分；模板对历史的格式化通常是新格式化结果的前缀
+         */
+        private fun suffixAfter(prefix: String, full: String) =
+            full.substring(full.commonPrefixWith(prefix).length)
+    }
 }
 
 /**
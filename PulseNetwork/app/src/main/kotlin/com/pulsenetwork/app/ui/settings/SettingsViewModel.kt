@@ -4,8 +4,10 @@ import androidx.lifecycle.LiveData
 import androidx.lifecycle.MutableLiveData
 import androidx.lifecycle.ViewModel
 import androidx.lifecycle.viewModelScope
+import com.pulsenetwork.core.native.KvCacheType
 import com.pulsenetwork.core.native.LLMInference
 import com.pulsenetwork.core.native.LLMState
+import com.pulsenetwork.core.native.ModelLoadOptions
 import com.pulsenetwork.domain.governor.Governor
 import com.pulsenetwork.domain.governor.GovernorStatus
 import dagger.hilt.android.lifecycle.HiltViewModel
@@ -73,7 +75,14 @@ class SettingsViewModel @Inject constructor(
     fun loadModel(path: String) {
         viewModelScope.launch {
             _modelStatus.value = "加载中..."
-            val success = llmInference.loadModel(path)
+            // Q8_0 KV cache 的内存约为 F16 的一半，同样内存下上下文翻倍
+            val success = llmInference.loadModel(
+                path,
+                contextLength = 4096,
+                options = ModelLoadOptions(kvCacheType = KvCacheType.Q8_0)
+            ) { progress ->
+                _modelStatus.postValue("加载中... ${(progress * 100).toInt()}%")
+            }
             if (success) {
                 val info = llmInference.getModelInfo()
                 _modelStatus.value = "已加载: ${info?.name ?: "Unknown"}"
@@ -35,6 +35,7 @@ object TextUtils {
     /**
      * 计算文本的 token 估算值
      * 简单估算：英文约 4 字符 = 1 token，中文约 1.5 字符 = 1 token
+     * 模型已加载时应使用 LLMInference.countTokens 得到精确值
      */
     fun estimateTokens(text: String): Int {
         val chineseChars = text.count { it.code > 0x4E00 && it.code < 0x9FFF }
@@ -0,0 +1,139 @@
+/**
+ * 解码路径堆分配计数
+ *
+ * 用法（adb push 到设备上运行）：
+ *   pulse_alloc_bench [model.gguf] [n_gen=64]
+ *
+ * 替换全局 operator new 计数：
+ * - 采样链（不需要模型）：每 token 的分配次数必须为 0
+ * - 完整生成（给出模型时）：统计首个 token 之后每 token 的分配次数，包含 llama.cpp 内部分配
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+#include "llama.h"
+#include "llama_model.h"
+#include "sampler.h"
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+uint64_t allocations() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+struct SamplerCase {
+    const char* name;
+    pulse::SamplingParams params;
+};
+
+/**
+ * 合成 logits 上跑采样链，返回首个 token 之后每 token 的分配次数
+ */
+double sampler_allocations_per_token(const pulse::SamplingParams& params, int n_vocab, int n_tokens) {
+    std::mt19937 rng(42);
+    std::normal_distribution<float> dist(0.0f, 3.0f);
+    std::vector<std::vector<float>> logits(8, std::vector<float>(n_vocab));
+    for (auto& row : logits) {
+        for (auto& v : row) v = dist(rng);
+    }
+
+    pulse::Arena arena;
+    pulse::Sampler sampler(params, nullptr, &arena);
+    sampler.prime(std::vector<llama_token>(params.penalty_last_n, 1));
+
+    // 首个 token 建立缓冲区
+    sampler.accept(sampler.sample(logits[0].data(), n_vocab));
+
+    uint64_t before = allocations();
+    for (int i = 1; i < n_tokens; i++) {
+        llama_token token = sampler.sample(logits[i % logits.size()].data(), n_vocab);
+        sampler.accept(token);
+    }
+    return double(allocations() - before) / (n_tokens - 1);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+int main(int argc, char** argv) {
+    const char* model_path = argc > 1 ? argv[1] : nullptr;
+    const int n_gen = argc > 2 ? atoi(argv[2]) : 64;
+
+    SamplerCase cases[4];
+    cases[0].name = "greedy";
+    cases[0].params.temperature = 0.0f;
+    cases[1].name = "top-k/top-p";
+    cases[2].name = "penalties";
+    cases[2].params.repeat_penalty = 1.1f;
+    cases[2].params.frequency_penalty = 0.2f;
+    cases[3].name = "no truncation";
+    cases[3].params.top_k = 0;
+    cases[3].params.top_p = 1.0f;
+
+    bool ok = true;
+    printf("%-16s %14s\n", "sampler", "allocs/token");
+    for (const auto& c : cases) {
+        double per_token = sampler_allocations_per_token(c.params, 32000, 256);
+        printf("%-16s %14.2f\n", c.name, per_token);
+        ok = ok && per_token == 0.0;
+    }
+
+    if (model_path) {
+        pulse::LoadOptions options;
+        auto model = pulse::LlamaModel::load(model_path, options, nullptr);
+        if (!model) {
+            fprintf(stderr, "failed to load %s\n", model_path);
+            return 1;
+        }
+
+        const std::string prompt = "Write a short story about a lighthouse keeper.";
+        pulse::SamplingParams params;
+        params.seed = 42;
+
+        // 第一次请求让 arena 长到稳定大小，第二次才计数
+        for (int pass = 0; pass < 2; pass++) {
+            int pieces = 0;
+            uint64_t first = 0;
+            uint64_t last = 0;
+            auto result = model->session().generate(prompt, n_gen, params,
+                [&](const std::string&) {
+                    (pieces++ == 0 ? first : last) = allocations();
+                    return true;
+                });
+            if (pass == 0) continue;
+
+            auto stats = model->session().arena_stats();
+            printf("generate: %d tokens, %.2f allocs/token after the first (incl. llama.cpp), "
+                   "arena %zu KB high water, %llu block allocations\n",
+                   result.n_generated,
+                   pieces > 1 ? double(last - first) / (pieces - 1) : 0.0,
+                   stats.high_water >> 10,
+                   static_cast<unsigned long long>(stats.system_allocations));
+        }
+    }
+
+    printf(ok ? "sampler decode path: zero allocations per token\n"
+              : "sampler decode path: ALLOCATES per token\n");
+    return ok ? 0 : 1;
+}
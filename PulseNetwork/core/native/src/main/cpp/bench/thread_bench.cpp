@@ -0,0 +1,146 @@
+/**
+ * 推理线程数扫描基准
+ *
+ * 用法（adb push 到设备上运行）：
+ *   pulse_thread_bench <model.gguf> [n_prompt=128] [n_gen=64] [threads=1,2,4,6,8]
+ *
+ * 对每个线程数分别测量预填充和解码的 tokens/s；大小核设备上同时对比绑核与不绑核
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_topology.h"
+#include "llama.h"
+#include "llama_session.h"
+#include "thread_pool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int REPETITIONS = 3;
+
+struct Result {
+    double prefill_tps = 0.0;
+    double decode_tps = 0.0;
+};
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::vector<int> parse_list(const char* arg) {
+    std::vector<int> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int v = atoi(item.c_str());
+        if (v > 0) values.push_back(v);
+    }
+    return values;
+}
+
+bool run_once(llama_model* model, const pulse::ThreadConfig& config,
+              const std::vector<llama_token>& prompt, int n_gen, Result& out) {
+    auto pool = pulse::InferenceThreadPool::create(config);
+    if (!pool) return false;
+
+    auto cparams = llama_context_default_params();
+    cparams.n_ctx = static_cast<uint32_t>(prompt.size() + n_gen + 8);
+    cparams.n_batch = static_cast<uint32_t>(prompt.size());
+    cparams.n_threads = pool->decode_threads();
+    cparams.n_threads_batch = pool->prefill_threads();
+    llama_context* ctx = llama_new_context_with_model(model, cparams);
+    if (!ctx) return false;
+    pool->attach(ctx);
+
+    auto start = Clock::now();
+    bool ok = pulse::decode_tokens(ctx, prompt.data(), static_cast<int>(prompt.size()), 0);
+    out.prefill_tps = ok ? prompt.size() / seconds_since(start) : 0.0;
+
+    // 贪心解码，排除采样开销，只测前向
+    const int n_vocab = llama_n_vocab(model);
+    int n_past = static_cast<int>(prompt.size());
+    start = Clock::now();
+    for (int i = 0; ok && i < n_gen; i++) {
+        const float* logits = llama_get_logits_ith(ctx, -1);
+        llama_token token = static_cast<llama_token>(std::max_element(logits, logits + n_vocab) - logits);
+        ok = pulse::decode_tokens(ctx, &token, 1, n_past++);
+    }
+    out.decode_tps = ok ? n_gen / seconds_since(start) : 0.0;
+
+    llama_free(ctx);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <model.gguf> [n_prompt=128] [n_gen=64] [threads=1,2,4,6,8]\n", argv[0]);
+        return 1;
+    }
+    const char* model_path = argv[1];
+    const int n_prompt = argc > 2 ? atoi(argv[2]) : 128;
+    const int n_gen = argc > 3 ? atoi(argv[3]) : 64;
+    std::vector<int> thread_counts = parse_list(argc > 4 ? argv[4] : "1,2,4,6,8");
+
+    const auto& topo = pulse::CpuTopology::get();
+    printf("cpus: %d, performance:", topo.n_cpus);
+    for (int cpu : topo.performance) printf(" %d(%u MHz)", cpu, topo.max_freq_khz[cpu] / 1000);
+    printf(", efficiency:");
+    for (int cpu : topo.efficiency) printf(" %d(%u MHz)", cpu, topo.max_freq_khz[cpu] / 1000);
+    printf("\n");
+
+    llama_backend_init();
+    auto mparams = llama_model_default_params();
+    llama_model* model = llama_load_model_from_file(model_path, mparams);
+    if (!model) {
+        fprintf(stderr, "failed to load %s\n", model_path);
+        return 1;
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<llama_token> dist(0, llama_n_vocab(model) - 1);
+    std::vector<llama_token> prompt(n_prompt);
+    for (auto& token : prompt) token = dist(rng);
+
+    std::vector<bool> pin_modes{false};
+    if (topo.heterogeneous()) pin_modes.push_back(true);
+
+    printf("%8s %6s %14s %14s\n", "threads", "pinned", "prefill tok/s", "decode tok/s");
+    for (int threads : thread_counts) {
+        for (bool pin : pin_modes) {
+            pulse::ThreadConfig config;
+            config.decode_threads = threads;
+            config.prefill_threads = threads;
+            config.pin_to_performance_cores = pin;
+
+            Result sum;
+            int runs = 0;
+            for (int rep = 0; rep < REPETITIONS; rep++) {
+                Result r;
+                if (!run_once(model, config, prompt, n_gen, r)) break;
+                sum.prefill_tps += r.prefill_tps;
+                sum.decode_tps += r.decode_tps;
+                runs++;
+            }
+            if (runs == 0) {
+                printf("%8d %6s %14s %14s\n", threads, pin ? "yes" : "no", "failed", "failed");
+                continue;
+            }
+            printf("%8d %6s %14.2f %14.2f\n", threads, pin ? "yes" : "no",
+                   sum.prefill_tps / runs, sum.decode_tps / runs);
+        }
+    }
+
+    llama_free_model(model);
+    llama_backend_free();
+    return 0;
+}
@@ -0,0 +1,467 @@
+#include "aes_gcm.h"
+#include "aes_gcm_impl.h"
+
+#include <cstring>
+
+#if defined(PULSE_AES_ARMV8)
+#include <sys/auxv.h>
+#ifndef HWCAP_AES
+#define HWCAP_AES (1 << 3)
+#endif
+#ifndef HWCAP_PMULL
+#define HWCAP_PMULL (1 << 4)
+#endif
+#endif
+
+#if defined(PULSE_AES_NI)
+#include <cpuid.h>
+#endif
+
+namespace pulse {
+
+namespace {
+
+// GCM 每次处理的块数：先对这一段做 CTR，再趁数据还在 L1 里做 GHASH
+constexpr size_t SLICE_BLOCKS = 256;
+
+uint8_t xtime(uint8_t x) {
+    return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1b : 0));
+}
+
+uint32_t rotr32(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+uint32_t load_be32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+void store_be32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+uint64_t load_be64(const uint8_t* p) {
+    return (uint64_t(load_be32(p)) << 32) | load_be32(p + 4);
+}
+
+void store_be64(uint8_t* p, uint64_t v) {
+    store_be32(p, static_cast<uint32_t>(v >> 32));
+    store_be32(p + 4, static_cast<uint32_t>(v));
+}
+
+// volatile 写入，不会因为之后不再读取而被优化掉
+void wipe(void* data, size_t size) {
+    volatile uint8_t* p = static_cast<volatile uint8_t*>(data);
+    while (size--) *p++ = 0;
+}
+
+/**
+ * S 盒和 T 表，首次使用时由有限域运算生成
+ *
+ * 软件实现只在没有硬件 AES 的 CPU 上使用；查表实现的访存模式与数据有关，
+ * 这类设备上的缓存时序侧信道无法完全避免
+ */
+struct Tables {
+    uint8_t sbox[256];
+    uint32_t te[4][256];
+
+    Tables() {
+        // 遍历 GF(2^8) 的生成元 3 的幂，同时维护其逆元（1/3 的幂）
+        uint8_t p = 1, q = 1;
+        do {
+            p = static_cast<uint8_t>(p ^ xtime(p));
+            q ^= static_cast<uint8_t>(q << 1);
+            q ^= static_cast<uint8_t>(q << 2);
+            q ^= static_cast<uint8_t>(q << 4);
+            if (q & 0x80) q ^= 0x09;
+            uint8_t x = static_cast<uint8_t>(q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^ rotl8(q, 4));
+            sbox[p] = static_cast<uint8_t>(x ^ 0x63);
+        } while (p != 1);
+        sbox[0] = 0x63;
+
+        for (int i = 0; i < 256; i++) {
+            uint8_t s = sbox[i];
+            uint8_t s2 = xtime(s);
+            uint8_t s3 = static_cast<uint8_t>(s2 ^ s);
+            uint32_t word = (uint32_t(s2) << 24) | (uint32_t(s) << 16) | (uint32_t(s) << 8) | s3;
+            te[0][i] = word;
+            te[1][i] = rotr32(word, 8);
+            te[2][i] = rotr32(word, 16);
+            te[3][i] = rotr32(word, 24);
+        }
+    }
+
+    static uint8_t rotl8(uint8_t x, int n) {
+        return static_cast<uint8_t>((x << n) | (x >> (8 - n)));
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+uint32_t sub_word(uint32_t w) {
+    const uint8_t* s = tables().sbox;
+    return (uint32_t(s[w >> 24]) << 24) | (uint32_t(s[(w >> 16) & 0xff]) << 16) |
+           (uint32_t(s[(w >> 8) & 0xff]) << 8) | s[w & 0xff];
+}
+
+/**
+ * AES-256 密钥扩展（FIPS-197 5.2，Nk = 8）
+ */
+void expand_key(const uint8_t key[32], uint8_t round_keys[15 * 16]) {
+    uint32_t w[60];
+    for (int i = 0; i < 8; i++) w[i] = load_be32(key + 4 * i);
+
+    uint32_t rcon = 0x01;
+    for (int i = 8; i < 60; i++) {
+        uint32_t temp = w[i - 1];
+        if (i % 8 == 0) {
+            temp = sub_word((temp << 8) | (temp >> 24)) ^ (rcon << 24);
+            rcon = xtime(static_cast<uint8_t>(rcon));
+        } else if (i % 8 == 4) {
+            temp = sub_word(temp);
+        }
+        w[i] = w[i - 8] ^ temp;
+    }
+
+    for (int i = 0; i < 60; i++) store_be32(round_keys + 4 * i, w[i]);
+    wipe(w, sizeof(w));
+}
+
+/**
+ * GHASH 4 位查表（Shoup 方法）：table[i] = i * H，i 的 4 位按 GCM 位序
+ */
+void init_ghash_key(GhashKey& key) {
+    uint64_t vh = load_be64(key.h);
+    uint64_t vl = load_be64(key.h + 8);
+
+    key.table_hi[0] = 0;
+    key.table_lo[0] = 0;
+    key.table_hi[8] = vh;
+    key.table_lo[8] = vl;
+
+    for (int i = 4; i > 0; i >>= 1) {
+        uint64_t reduce = (vl & 1) ? 0xe100000000000000ULL : 0;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ reduce;
+        key.table_hi[i] = vh;
+        key.table_lo[i] = vl;
+    }
+
+    for (int i = 2; i <= 8; i *= 2) {
+        for (int j = 1; j < i; j++) {
+            key.table_hi[i + j] = key.table_hi[i] ^ key.table_hi[j];
+            key.table_lo[i + j] = key.table_lo[i] ^ key.table_lo[j];
+        }
+    }
+}
+
+// 右移 4 位时移出的低 4 位在约简多项式下的贡献
+constexpr uint64_t LAST4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+void ghash_multiply(const GhashKey& key, uint8_t x[16]) {
+    uint8_t lo = x[15] & 0x0f;
+    uint64_t zh = key.table_hi[lo];
+    uint64_t zl = key.table_lo[lo];
+
+    for (int i = 15; i >= 0; i--) {
+        lo = x[i] & 0x0f;
+        uint8_t hi = x[i] >> 4;
+
+        if (i != 15) {
+            uint8_t rem = zl & 0x0f;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (LAST4[rem] << 48);
+            zh ^= key.table_hi[lo];
+            zl ^= key.table_lo[lo];
+        }
+
+        uint8_t rem = zl & 0x0f;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (LAST4[rem] << 48);
+        zh ^= key.table_hi[hi];
+        zl ^= key.table_lo[hi];
+    }
+
+    store_be64(x, zh);
+    store_be64(x + 8, zl);
+}
+
+} // namespace
+
+// ========== 软件实现 ==========
+
+namespace aes_impl {
+
+namespace {
+
+void software_encrypt_block(const uint8_t* round_keys, const uint8_t in[16], uint8_t out[16]) {
+    const Tables& t = tables();
+    const uint8_t* rk = round_keys;
+
+    uint32_t s0 = load_be32(in) ^ load_be32(rk);
+    uint32_t s1 = load_be32(in + 4) ^ load_be32(rk + 4);
+    uint32_t s2 = load_be32(in + 8) ^ load_be32(rk + 8);
+    uint32_t s3 = load_be32(in + 12) ^ load_be32(rk + 12);
+
+    for (int round = 1; round < ROUNDS; round++) {
+        rk += 16;
+        uint32_t t0 = t.te[0][s0 >> 24] ^ t.te[1][(s1 >> 16) & 0xff] ^
+                      t.te[2][(s2 >> 8) & 0xff] ^ t.te[3][s3 & 0xff] ^ load_be32(rk);
+        uint32_t t1 = t.te[0][s1 >> 24] ^ t.te[1][(s2 >> 16) & 0xff] ^
+                      t.te[2][(s3 >> 8) & 0xff] ^ t.te[3][s0 & 0xff] ^ load_be32(rk + 4);
+        uint32_t t2 = t.te[0][s2 >> 24] ^ t.te[1][(s3 >> 16) & 0xff] ^
+                      t.te[2][(s0 >> 8) & 0xff] ^ t.te[3][s1 & 0xff] ^ load_be32(rk + 8);
+        uint32_t t3 = t.te[0][s3 >> 24] ^ t.te[1][(s0 >> 16) & 0xff] ^
+                      t.te[2][(s1 >> 8) & 0xff] ^ t.te[3][s2 & 0xff] ^ load_be32(rk + 12);
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    // 最后一轮没有 MixColumns
+    rk += 16;
+    const uint8_t* s = t.sbox;
+    uint32_t states[4] = {s0, s1, s2, s3};
+    for (int i = 0; i < 4; i++) {
+        uint32_t word = (uint32_t(s[states[i] >> 24]) << 24) |
+                        (uint32_t(s[(states[(i + 1) & 3] >> 16) & 0xff]) << 16) |
+                        (uint32_t(s[(states[(i + 2) & 3] >> 8) & 0xff]) << 8) |
+                        s[states[(i + 3) & 3] & 0xff];
+        store_be32(out + 4 * i, word ^ load_be32(rk + 4 * i));
+    }
+}
+
+} // namespace
+
+void software_ctr32(const uint8_t* round_keys, uint8_t counter[16],
+                    const uint8_t* in, uint8_t* out, size_t blocks) {
+    uint32_t n = load_be32(counter + 12);
+    uint8_t keystream[16];
+    for (size_t b = 0; b < blocks; b++) {
+        software_encrypt_block(round_keys, counter, keystream);
+        store_be32(counter + 12, ++n);
+        for (int i = 0; i < 16; i++) out[i] = in[i] ^ keystream[i];
+        in += 16;
+        out += 16;
+    }
+    wipe(keystream, sizeof(keystream));
+}
+
+void software_ghash(const GhashKey& key, uint8_t x[16], const uint8_t* data, size_t blocks) {
+    for (size_t b = 0; b < blocks; b++) {
+        for (int i = 0; i < 16; i++) x[i] ^= data[i];
+        ghash_multiply(key, x);
+        data += 16;
+    }
+}
+
+} // namespace aes_impl
+
+// ========== AesGcm ==========
+
+const char* backend_name(AesBackend backend) {
+    switch (backend) {
+        case AesBackend::ARMV8: return "armv8-ce";
+        case AesBackend::AES_NI: return "aes-ni";
+        case AesBackend::SOFTWARE: break;
+    }
+    return "software";
+}
+
+bool AesGcm::is_available(AesBackend backend) {
+    switch (backend) {
+        case AesBackend::SOFTWARE:
+            return true;
+        case AesBackend::ARMV8: {
+#if defined(PULSE_AES_ARMV8)
+            unsigned long hwcap = getauxval(AT_HWCAP);
+            return (hwcap & HWCAP_AES) && (hwcap & HWCAP_PMULL);
+#else
+            return false;
+#endif
+        }
+        case AesBackend::AES_NI: {
+#if defined(PULSE_AES_NI)
+            unsigned int eax, ebx, ecx, edx;
+            if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+            return (ecx & bit_AES) && (ecx & bit_PCLMUL) && (ecx & bit_SSSE3);
+#else
+            return false;
+#endif
+        }
+    }
+    return false;
+}
+
+AesBackend AesGcm::best_backend() {
+    static const AesBackend best = [] {
+        if (is_available(AesBackend::ARMV8)) return AesBackend::ARMV8;
+        if (is_available(AesBackend::AES_NI)) return AesBackend::AES_NI;
+        return AesBackend::SOFTWARE;
+    }();
+    return best;
+}
+
+AesGcm::AesGcm(const uint8_t key[KEY_BYTES])
+    : AesGcm(key, best_backend()) {}
+
+AesGcm::AesGcm(const uint8_t key[KEY_BYTES], AesBackend backend)
+    : backend_(is_available(backend) ? backend : AesBackend::SOFTWARE) {
+    expand_key(key, round_keys_);
+
+    // H = E_K(0^128)
+    uint8_t counter[16] = {};
+    std::memset(ghash_key_.h, 0, sizeof(ghash_key_.h));
+    ctr(counter, ghash_key_.h, sizeof(ghash_key_.h), ghash_key_.h);
+    init_ghash_key(ghash_key_);
+}
+
+AesGcm::~AesGcm() {
+    wipe(round_keys_, sizeof(round_keys_));
+    wipe(&ghash_key_, sizeof(ghash_key_));
+}
+
+void AesGcm::seal(const uint8_t nonce[NONCE_BYTES],
+                  const uint8_t* aad, size_t aad_length,
+                  const uint8_t* in, size_t length,
+                  uint8_t* out, uint8_t tag[TAG_BYTES]) const {
+    // 计数器从 J0 + 1 开始，J0 留给 tag
+    uint8_t counter[16];
+    std::memcpy(counter, nonce, NONCE_BYTES);
+    store_be32(counter + 12, 2);
+
+    // 分段交替 CTR 和 GHASH，每段的密文在 GHASH 时仍在缓存里
+    uint8_t x[16] = {};
+    ghash(x, aad, aad_length);
+    size_t offset = 0;
+    while (offset < length) {
+        size_t n = length - offset;
+        if (n > SLICE_BLOCKS * 16) n = SLICE_BLOCKS * 16;
+        ctr(counter, in + offset, n, out + offset);
+        ghash(x, out + offset, n);
+        offset += n;
+    }
+
+    finish_tag(nonce, x, aad_length, length, tag);
+}
+
+bool AesGcm::open(const uint8_t nonce[NONCE_BYTES],
+                  const uint8_t* aad, size_t aad_length,
+                  const uint8_t* in, size_t length,
+                  const uint8_t tag[TAG_BYTES],
+                  uint8_t* out) const {
+    uint8_t expected[TAG_BYTES];
+    compute_tag(nonce, aad, aad_length, in, length, expected);
+
+    // 常数时间比较
+    uint8_t diff = 0;
+    for (size_t i = 0; i < TAG_BYTES; i++) diff |= expected[i] ^ tag[i];
+    if (diff != 0) return false;
+
+    uint8_t counter[16];
+    std::memcpy(counter, nonce, NONCE_BYTES);
+    store_be32(counter + 12, 2);
+    ctr(counter, in, length, out);
+    return true;
+}
+
+// ========== 私有方法 ==========
+
+void AesGcm::compute_tag(const uint8_t nonce[NONCE_BYTES],
+                         const uint8_t* aad, size_t aad_length,
+                         const uint8_t* ciphertext, size_t length,
+                         uint8_t tag[TAG_BYTES]) const {
+    uint8_t x[16] = {};
+    ghash(x, aad, aad_length);
+    ghash(x, ciphertext, length);
+
+    finish_tag(nonce, x, aad_length, length, tag);
+}
+
+/**
+ * 追加长度块，tag = E_K(J0) xor GHASH
+ */
+void AesGcm::finish_tag(const uint8_t nonce[NONCE_BYTES], uint8_t x[16],
+                        size_t aad_length, size_t length, uint8_t tag[TAG_BYTES]) const {
+    uint8_t lengths[16];
+    store_be64(lengths, uint64_t(aad_length) * 8);
+    store_be64(lengths + 8, uint64_t(length) * 8);
+    ghash(x, lengths, sizeof(lengths));
+
+    uint8_t j0[16];
+    std::memcpy(j0, nonce, NONCE_BYTES);
+    store_be32(j0 + 12, 1);
+    ctr(j0, x, TAG_BYTES, tag);
+}
+
+void AesGcm::ctr(uint8_t counter[16], const uint8_t* in, size_t length, uint8_t* out) const {
+    size_t blocks = length / 16;
+    size_t tail = length % 16;
+
+    uint8_t last[16] = {};
+    if (tail) std::memcpy(last, in + blocks * 16, tail);
+
+    switch (backend_) {
+#if defined(PULSE_AES_ARMV8)
+        case AesBackend::ARMV8:
+            if (blocks) aes_impl::armv8_ctr32(round_keys_, counter, in, out, blocks);
+            if (tail) aes_impl::armv8_ctr32(round_keys_, counter, last, last, 1);
+            break;
+#endif
+#if defined(PULSE_AES_NI)
+        case AesBackend::AES_NI:
+            if (blocks) aes_impl::aesni_ctr32(round_keys_, counter, in, out, blocks);
+            if (tail) aes_impl::aesni_ctr32(round_keys_, counter, last, last, 1);
+            break;
+#endif
+        default:
+            if (blocks) aes_impl::software_ctr32(round_keys_, counter, in, out, blocks);
+            if (tail) aes_impl::software_ctr32(round_keys_, counter, last, last, 1);
+            break;
+    }
+
+    if (tail) {
+        std::memcpy(out + blocks * 16, last, tail);
+        wipe(last, sizeof(last));
+    }
+}
+
+void AesGcm::ghash(uint8_t x[16], const uint8_t* data, size_t length) const {
+    size_t blocks = length / 16;
+    size_t tail = length % 16;
+
+    // 不足一块的尾部补零
+    uint8_t last[16] = {};
+    if (tail) std::memcpy(last, data + blocks * 16, tail);
+
+    switch (backend_) {
+#if defined(PULSE_AES_ARMV8)
+        case AesBackend::ARMV8:
+            if (blocks) aes_impl::armv8_ghash(ghash_key_, x, data, blocks);
+            if (tail) aes_impl::armv8_ghash(ghash_key_, x, last, 1);
+            break;
+#endif
+#if defined(PULSE_AES_NI)
+        case AesBackend::AES_NI:
+            if (blocks) aes_impl::aesni_ghash(ghash_key_, x, data, blocks);
+            if (tail) aes_impl::aesni_ghash(ghash_key_, x, last, 1);
+            break;
+#endif
+        default:
+            if (blocks) aes_impl::software_ghash(ghash_key_, x, data, blocks);
+            if (tail) aes_impl::software_ghash(ghash_key_, x, last, 1);
+            break;
+    }
+}
+
+} // namespace pulse
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pulse {
+
+/**
+ * AES 实现，与 Kotlin 侧 AesGcmCipher.getBackend() 的返回值对应
+ */
+enum class AesBackend : int {
+    SOFTWARE = 0,  // 查表实现，任何 CPU 可用
+    ARMV8 = 1,     // ARMv8 Crypto Extensions（AESE/AESMC + PMULL）
+    AES_NI = 2     // x86 AES-NI + PCLMULQDQ
+};
+
+const char* backend_name(AesBackend backend);
+
+/**
+ * GHASH 密钥：H 以及软件实现用的 4 位查表
+ */
+struct GhashKey {
+    uint8_t h[16];
+    uint64_t table_hi[16];
+    uint64_t table_lo[16];
+};
+
+/**
+ * AES-256-GCM（96 位 nonce，128 位 tag）
+ *
+ * 构造时展开轮密钥并预计算 H，之后 seal / open 不分配内存，可以多线程同时调用。
+ * 默认选用当前 CPU 支持的最快实现；指定的硬件实现不可用时退回软件实现。
+ * 析构时清零密钥材料
+ */
+class AesGcm {
+public:
+    static constexpr size_t KEY_BYTES = 32;
+    static constexpr size_t NONCE_BYTES = 12;
+    static constexpr size_t TAG_BYTES = 16;
+
+    explicit AesGcm(const uint8_t key[KEY_BYTES]);
+    AesGcm(const uint8_t key[KEY_BYTES], AesBackend backend);
+    ~AesGcm();
+
+    AesGcm(const AesGcm&) = delete;
+    AesGcm& operator=(const AesGcm&) = delete;
+
+    /**
+     * 加密 length 字节，密文写入 out（可与 in 相同），tag 写入 tag
+     */
+    void seal(const uint8_t nonce[NONCE_BYTES],
+              const uint8_t* aad, size_t aad_length,
+              const uint8_t* in, size_t length,
+              uint8_t* out, uint8_t tag[TAG_BYTES]) const;
+
+    /**
+     * 先校验 tag 再解密；校验失败时返回 false，out 不被写入
+     */
+    bool open(const uint8_t nonce[NONCE_BYTES],
+              const uint8_t* aad, size_t aad_length,
+              const uint8_t* in, size_t length,
+              const uint8_t tag[TAG_BYTES],
+              uint8_t* out) const;
+
+    AesBackend backend() const { return backend_; }
+
+    /**
+     * 当前 CPU 上最快的可用实现
+     */
+    static AesBackend best_backend();
+    static bool is_available(AesBackend backend);
+
+private:
+    void compute_tag(const uint8_t nonce[NONCE_BYTES],
+                     const uint8_t* aad, size_t aad_length,
+                     const uint8_t* ciphertext, size_t length,
+                     uint8_t tag[TAG_BYTES]) const;
+    void finish_tag(const uint8_t nonce[NONCE_BYTES], uint8_t x[16],
+                    size_t aad_length, size_t length, uint8_t tag[TAG_BYTES]) const;
+    void ctr(uint8_t counter[16], const uint8_t* in, size_t length, uint8_t* out) const;
+    void ghash(uint8_t x[16], const uint8_t* data, size_t length) const;
+
+    alignas(16) uint8_t round_keys_[15 * 16];
+    GhashKey ghash_key_;
+    AesBackend backend_;
+};
+
+} // namespace pulse
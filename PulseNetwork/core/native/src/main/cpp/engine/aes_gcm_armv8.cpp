@@ -0,0 +1,142 @@
+#include "aes_gcm_impl.h"
+
+#if defined(PULSE_AES_ARMV8)
+
+#include <arm_neon.h>
+
+/**
+ * ARMv8 Crypto Extensions 实现（本文件以 -march=armv8-a+crypto 编译）
+ */
+namespace pulse::aes_impl {
+
+namespace {
+
+// CTR 每轮并行的块数，让 AESE/AESMC 的流水线保持满载
+constexpr size_t LANES = 8;
+
+/**
+ * 未约简的 256 位乘积，拆成 lo / mid / hi 三部分分别累加
+ */
+struct Product {
+    uint64x2_t lo;
+    uint64x2_t mid;
+    uint64x2_t hi;
+};
+
+/**
+ * 输入都是 vrbitq_u8 逐字节位反转后的表示：此时第 i 位就是 x^i 的系数，
+ * 可以直接用 PMULL 做普通的无进位乘法
+ */
+inline void clmul_accumulate(uint64x2_t a, uint64x2_t b, Product& p) {
+    poly64_t a0 = vgetq_lane_u64(a, 0);
+    poly64_t a1 = vgetq_lane_u64(a, 1);
+    poly64_t b0 = vgetq_lane_u64(b, 0);
+    poly64_t b1 = vgetq_lane_u64(b, 1);
+
+    p.lo = veorq_u64(p.lo, vreinterpretq_u64_p128(vmull_p64(a0, b0)));
+    p.hi = veorq_u64(p.hi, vreinterpretq_u64_p128(vmull_p64(a1, b1)));
+    p.mid = veorq_u64(p.mid, vreinterpretq_u64_p128(vmull_p64(a0, b1)));
+    p.mid = veorq_u64(p.mid, vreinterpretq_u64_p128(vmull_p64(a1, b0)));
+}
+
+/**
+ * 按 x^128 = x^7 + x^2 + x + 1 分两次折叠高位
+ */
+inline uint64x2_t reduce(const Product& p) {
+    // 乘积 p3:p2:p1:p0（每个 64 位）
+    uint64_t p0 = vgetq_lane_u64(p.lo, 0);
+    uint64_t p1 = vgetq_lane_u64(p.lo, 1) ^ vgetq_lane_u64(p.mid, 0);
+    uint64_t p2 = vgetq_lane_u64(p.hi, 0) ^ vgetq_lane_u64(p.mid, 1);
+    uint64_t p3 = vgetq_lane_u64(p.hi, 1);
+
+    const poly64_t reduction = 0x87;
+    uint64x2_t fold3 = vreinterpretq_u64_p128(vmull_p64(p3, reduction));
+    p1 ^= vgetq_lane_u64(fold3, 0);
+    p2 ^= vgetq_lane_u64(fold3, 1);
+    uint64x2_t fold2 = vreinterpretq_u64_p128(vmull_p64(p2, reduction));
+    p0 ^= vgetq_lane_u64(fold2, 0);
+    p1 ^= vgetq_lane_u64(fold2, 1);
+
+    return vcombine_u64(vcreate_u64(p0), vcreate_u64(p1));
+}
+
+inline Product zero_product() {
+    const uint64x2_t zero = vdupq_n_u64(0);
+    return {zero, zero, zero};
+}
+
+inline uint64x2_t gf_multiply(uint64x2_t a, uint64x2_t b) {
+    Product p = zero_product();
+    clmul_accumulate(a, b, p);
+    return reduce(p);
+}
+
+inline uint64x2_t load_reflected(const uint8_t* p) {
+    return vreinterpretq_u64_u8(vrbitq_u8(vld1q_u8(p)));
+}
+
+inline void store_reflected(uint8_t* p, uint64x2_t v) {
+    vst1q_u8(p, vrbitq_u8(vreinterpretq_u8_u64(v)));
+}
+
+} // namespace
+
+void armv8_ctr32(const uint8_t* round_keys, uint8_t counter[16],
+                 const uint8_t* in, uint8_t* out, size_t blocks) {
+    uint8x16_t rk[ROUNDS + 1];
+    for (int i = 0; i <= ROUNDS; i++) rk[i] = vld1q_u8(round_keys + 16 * i);
+
+    const uint32x4_t base = vreinterpretq_u32_u8(vld1q_u8(counter));
+    uint32_t n = __builtin_bswap32(vgetq_lane_u32(base, 3));
+
+    while (blocks > 0) {
+        size_t count = blocks < LANES ? blocks : LANES;
+        uint8x16_t s[LANES];
+        for (size_t j = 0; j < count; j++) {
+            s[j] = vreinterpretq_u8_u32(vsetq_lane_u32(__builtin_bswap32(n++), base, 3));
+        }
+        // AESE = AddRoundKey + SubBytes + ShiftRows，AESMC = MixColumns
+        for (int r = 0; r < ROUNDS - 1; r++) {
+            for (size_t j = 0; j < count; j++) s[j] = vaesmcq_u8(vaeseq_u8(s[j], rk[r]));
+        }
+        for (size_t j = 0; j < count; j++) {
+            s[j] = veorq_u8(vaeseq_u8(s[j], rk[ROUNDS - 1]), rk[ROUNDS]);
+            vst1q_u8(out + 16 * j, veorq_u8(vld1q_u8(in + 16 * j), s[j]));
+        }
+        in += 16 * count;
+        out += 16 * count;
+        blocks -= count;
+    }
+
+    vst1q_u8(counter, vreinterpretq_u8_u32(vsetq_lane_u32(__builtin_bswap32(n), base, 3)));
+}
+
+void armv8_ghash(const GhashKey& key, uint8_t x[16], const uint8_t* data, size_t blocks) {
+    const uint64x2_t h = load_reflected(key.h);
+    uint64x2_t acc = load_reflected(x);
+
+    // 每 4 块只约简一次：acc' = (acc + b0)·H^4 + b1·H^3 + b2·H^2 + b3·H
+    if (blocks >= 4) {
+        const uint64x2_t h2 = gf_multiply(h, h);
+        const uint64x2_t h3 = gf_multiply(h2, h);
+        const uint64x2_t h4 = gf_multiply(h3, h);
+        for (; blocks >= 4; blocks -= 4, data += 64) {
+            Product p = zero_product();
+            clmul_accumulate(veorq_u64(acc, load_reflected(data)), h4, p);
+            clmul_accumulate(load_reflected(data + 16), h3, p);
+            clmul_accumulate(load_reflected(data + 32), h2, p);
+            clmul_accumulate(load_reflected(data + 48), h, p);
+            acc = reduce(p);
+        }
+    }
+
+    for (; blocks > 0; blocks--, data += 16) {
+        acc = gf_multiply(veorq_u64(acc, load_reflected(data)), h);
+    }
+
+    store_reflected(x, acc);
+}
+
+} // namespace pulse::aes_impl
+
+#endif // PULSE_AES_ARMV8
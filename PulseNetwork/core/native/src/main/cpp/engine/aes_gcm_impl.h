@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "aes_gcm.h"
+
+#if defined(__aarch64__)
+#define PULSE_AES_ARMV8 1
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PULSE_AES_NI 1
+#endif
+
+/**
+ * AES-GCM 各实现的内部接口（仅供 aes_gcm*.cpp 使用）
+ *
+ * 硬件实现各自放在单独的源文件里，只有这些文件带 -march / -maes 编译，
+ * 运行时检测到 CPU 支持后才会被调用，其他代码不会被编译器混入新指令。
+ * 轮密钥统一按 FIPS-197 字节序存放（15 x 16 字节），三种实现共用；
+ * ctr32 只递增计数器块末尾 32 位（GCM 的 inc32）
+ */
+namespace pulse::aes_impl {
+
+constexpr int ROUNDS = 14;
+
+void software_ctr32(const uint8_t* round_keys, uint8_t counter[16],
+                    const uint8_t* in, uint8_t* out, size_t blocks);
+void software_ghash(const GhashKey& key, uint8_t x[16], const uint8_t* data, size_t blocks);
+
+#if defined(PULSE_AES_ARMV8)
+void armv8_ctr32(const uint8_t* round_keys, uint8_t counter[16],
+                 const uint8_t* in, uint8_t* out, size_t blocks);
+void armv8_ghash(const GhashKey& key, uint8_t x[16], const uint8_t* data, size_t blocks);
+#endif
+
+#if defined(PULSE_AES_NI)
+void aesni_ctr32(const uint8_t* round_keys, uint8_t counter[16],
+                 const uint8_t* in, uint8_t* out, size_t blocks);
+void aesni_ghash(const GhashKey& key, uint8_t x[16], const uint8_t* data, size_t blocks);
+#endif
+
+} // namespace pulse::aes_impl
@@ -0,0 +1,137 @@
+#include "aes_gcm_impl.h"
+
+#if defined(PULSE_AES_NI)
+
+#include <immintrin.h>
+
+/**
+ * AES-NI + PCLMULQDQ 实现（本文件以 -maes -mpclmul -mssse3 编译）
+ */
+namespace pulse::aes_impl {
+
+namespace {
+
+// CTR 每轮并行的块数，让 AESENC 的流水线保持满载
+constexpr size_t LANES = 8;
+
+inline __m128i byte_reverse(__m128i x) {
+    const __m128i mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    return _mm_shuffle_epi8(x, mask);
+}
+
+/**
+ * 无进位乘法，256 位乘积累加到 hi:lo（未约简，多个乘积可以先累加再一起约简）
+ */
+inline void clmul_accumulate(__m128i a, __m128i b, __m128i& lo, __m128i& hi) {
+    __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+    lo = _mm_xor_si128(lo, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x00), _mm_slli_si128(mid, 8)));
+    hi = _mm_xor_si128(hi, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x11), _mm_srli_si128(mid, 8)));
+}
+
+/**
+ * 约简到 GF(2^128)，输入输出均为字节反转后的表示
+ * （Intel《Carry-Less Multiplication and Its Usage for Computing the GCM Mode》算法 5）
+ */
+inline __m128i reduce(__m128i lo, __m128i hi) {
+    // 256 位乘积整体左移 1 位（GCM 的位反转约定）
+    __m128i lo_carry = _mm_srli_epi32(lo, 31);
+    __m128i hi_carry = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i cross = _mm_srli_si128(lo_carry, 12);
+    hi_carry = _mm_slli_si128(hi_carry, 4);
+    lo_carry = _mm_slli_si128(lo_carry, 4);
+    lo = _mm_or_si128(lo, lo_carry);
+    hi = _mm_or_si128(hi, hi_carry);
+    hi = _mm_or_si128(hi, cross);
+
+    // 模 x^128 + x^7 + x^2 + x + 1 约简
+    __m128i t = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)),
+                              _mm_slli_epi32(lo, 25));
+    __m128i t_hi = _mm_srli_si128(t, 4);
+    t = _mm_slli_si128(t, 12);
+    lo = _mm_xor_si128(lo, t);
+    __m128i u = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)),
+                              _mm_srli_epi32(lo, 7));
+    u = _mm_xor_si128(u, t_hi);
+    lo = _mm_xor_si128(lo, u);
+    return _mm_xor_si128(hi, lo);
+}
+
+inline __m128i gf_multiply(__m128i a, __m128i b) {
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    clmul_accumulate(a, b, lo, hi);
+    return reduce(lo, hi);
+}
+
+inline __m128i load_block(const uint8_t* p) {
+    return byte_reverse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+} // namespace
+
+void aesni_ctr32(const uint8_t* round_keys, uint8_t counter[16],
+                 const uint8_t* in, uint8_t* out, size_t blocks) {
+    __m128i rk[ROUNDS + 1];
+    for (int i = 0; i <= ROUNDS; i++) {
+        rk[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys + 16 * i));
+    }
+
+    // 字节反转后计数器位于最低的 32 位 lane，_mm_add_epi32 即 inc32
+    const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+    __m128i ctr = byte_reverse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(counter)));
+
+    while (blocks > 0) {
+        size_t n = blocks < LANES ? blocks : LANES;
+        __m128i s[LANES];
+        for (size_t j = 0; j < n; j++) {
+            s[j] = _mm_xor_si128(byte_reverse(ctr), rk[0]);
+            ctr = _mm_add_epi32(ctr, one);
+        }
+        for (int r = 1; r < ROUNDS; r++) {
+            for (size_t j = 0; j < n; j++) s[j] = _mm_aesenc_si128(s[j], rk[r]);
+        }
+        for (size_t j = 0; j < n; j++) {
+            s[j] = _mm_aesenclast_si128(s[j], rk[ROUNDS]);
+            __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16 * j));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * j), _mm_xor_si128(data, s[j]));
+        }
+        in += 16 * n;
+        out += 16 * n;
+        blocks -= n;
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(counter), byte_reverse(ctr));
+}
+
+void aesni_ghash(const GhashKey& key, uint8_t x[16], const uint8_t* data, size_t blocks) {
+    const __m128i h = load_block(key.h);
+    __m128i acc = load_block(x);
+
+    // 每 4 块只约简一次：acc' = (acc + b0)·H^4 + b1·H^3 + b2·H^2 + b3·H
+    if (blocks >= 4) {
+        const __m128i h2 = gf_multiply(h, h);
+        const __m128i h3 = gf_multiply(h2, h);
+        const __m128i h4 = gf_multiply(h3, h);
+        for (; blocks >= 4; blocks -= 4, data += 64) {
+            __m128i lo = _mm_setzero_si128();
+            __m128i hi = _mm_setzero_si128();
+            clmul_accumulate(_mm_xor_si128(acc, load_block(data)), h4, lo, hi);
+            clmul_accumulate(load_block(data + 16), h3, lo, hi);
+            clmul_accumulate(load_block(data + 32), h2, lo, hi);
+            clmul_accumulate(load_block(data + 48), h, lo, hi);
+            acc = reduce(lo, hi);
+        }
+    }
+
+    for (; blocks > 0; blocks--, data += 16) {
+        acc = gf_multiply(_mm_xor_si128(acc, load_block(data)), h);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(x), byte_reverse(acc));
+}
+
+} // namespace pulse::aes_impl
+
+#endif // PULSE_AES_NI
@@ -0,0 +1,86 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace pulse {
+
+namespace {
+
+size_t align_up(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+} // namespace
+
+Arena::Arena(size_t initial_bytes) {
+    if (initial_bytes > 0) add_block(initial_bytes);
+}
+
+Arena::~Arena() {
+    release_blocks();
+}
+
+void* Arena::allocate(size_t bytes, size_t align) {
+    if (bytes == 0) bytes = 1;
+
+    while (current_ < blocks_.size()) {
+        const Block& block = blocks_[current_];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+        size_t start = align_up(base + offset_, align) - base;
+        if (start + bytes <= block.size) {
+            offset_ = start + bytes;
+            used_ += bytes;
+            high_water_ = std::max(high_water_, used_);
+            return block.data + start;
+        }
+        // 当前块放不下，后面还有块（上次请求遗留）就继续用
+        current_++;
+        offset_ = 0;
+    }
+
+    add_block(bytes + align);
+    current_ = blocks_.size() - 1;
+    offset_ = 0;
+    return allocate(bytes, align);
+}
+
+void Arena::reset() {
+    if (blocks_.size() > 1) {
+        // 合并为一个块，下一次同规模的请求只用一块，不再申请
+        size_t total = 0;
+        for (const Block& block : blocks_) total += block.size;
+        release_blocks();
+        add_block(std::max(total, high_water_));
+    }
+    current_ = 0;
+    offset_ = 0;
+    used_ = 0;
+}
+
+Arena::Stats Arena::stats() const {
+    Stats stats;
+    stats.used = used_;
+    stats.high_water = high_water_;
+    for (const Block& block : blocks_) stats.capacity += block.size;
+    stats.system_allocations = system_allocations_;
+    return stats;
+}
+
+// ========== 私有方法 ==========
+
+void Arena::add_block(size_t min_bytes) {
+    // 至少翻倍增长，减少一次请求内的申请次数
+    size_t size = std::max(min_bytes, blocks_.empty() ? size_t(0) : blocks_.back().size * 2);
+    auto* data = static_cast<uint8_t*>(std::malloc(size));
+    if (!data) throw std::bad_alloc();
+    blocks_.push_back(Block{data, size});
+    system_allocations_++;
+}
+
+void Arena::release_blocks() {
+    for (const Block& block : blocks_) std::free(block.data);
+    blocks_.clear();
+}
+
+} // namespace pulse
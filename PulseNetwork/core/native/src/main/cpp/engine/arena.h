@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace pulse {
+
+/**
+ * 按请求复用的线性分配器
+ *
+ * 一次请求内的临时内存（采样候选、概率分布、惩罚窗口等）都从这里按顺序切分，
+ * 释放是空操作，请求结束后 reset 一次性回收。reset 时若本次用到了多个块，
+ * 合并成一个足够大的块，之后同样规模的请求不再向系统申请内存
+ */
+class Arena {
+public:
+    struct Stats {
+        size_t used = 0;              // 当前请求已分配字节数
+        size_t high_water = 0;        // 历史单次请求最大用量
+        size_t capacity = 0;          // 已持有的块总容量
+        uint64_t system_allocations = 0;  // 向系统申请块的次数
+    };
+
+    explicit Arena(size_t initial_bytes = 256 << 10);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocate_array(size_t n) {
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * 回收本次请求的全部分配，之前返回的指针全部失效
+     */
+    void reset();
+
+    Stats stats() const;
+
+private:
+    struct Block {
+        uint8_t* data;
+        size_t size;
+    };
+
+    void add_block(size_t min_bytes);
+    void release_blocks();
+
+    std::vector<Block> blocks_;
+    size_t current_ = 0;   // 当前块下标
+    size_t offset_ = 0;    // 当前块内偏移
+    size_t used_ = 0;
+    size_t high_water_ = 0;
+    uint64_t system_allocations_ = 0;
+};
+
+/**
+ * STL 分配器适配，arena 为空时退化为全局 new/delete
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    explicit ArenaAllocator(Arena* arena) noexcept : arena_(arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(size_t n) {
+        if (arena_) return arena_->allocate_array<T>(n);
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        if (!arena_) ::operator delete(p);
+    }
+
+    Arena* arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena(); }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena_ != other.arena(); }
+
+private:
+    Arena* arena_ = nullptr;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace pulse
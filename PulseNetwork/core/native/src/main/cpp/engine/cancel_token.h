@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace pulse {
+
+/**
+ * 单次推理请求的取消令牌
+ *
+ * 取消标志和截止时间都是原子量，可以在任意线程设置；
+ * 解码循环在每个 token 之间、预填充在每个分块之间检查，
+ * ggml 计算图内部则通过 abort_callback 检查，取消后最多再跑完一个计算节点
+ */
+class CancelToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+    /**
+     * 设置相对当前时刻的超时，<= 0 表示不限时
+     */
+    void set_timeout_ms(int64_t timeout_ms) {
+        int64_t deadline = 0;
+        if (timeout_ms > 0) {
+            auto at = Clock::now() + std::chrono::milliseconds(timeout_ms);
+            deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(at.time_since_epoch()).count();
+        }
+        deadline_ns_.store(deadline, std::memory_order_relaxed);
+    }
+
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+    bool expired() const {
+        int64_t deadline = deadline_ns_.load(std::memory_order_relaxed);
+        if (deadline == 0) return false;
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+        return now >= deadline;
+    }
+
+    bool should_stop() const { return cancelled() || expired(); }
+
+private:
+    std::atomic<bool> cancelled_{false};
+    std::atomic<int64_t> deadline_ns_{0};
+};
+
+} // namespace pulse
@@ -0,0 +1,90 @@
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+
+namespace pulse {
+
+namespace {
+
+constexpr int MAX_DECODE_THREADS = 4;
+
+uint32_t read_max_freq(const std::string& root, int cpu) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/cpu%d/cpufreq/cpuinfo_max_freq", root.c_str(), cpu);
+    FILE* fp = fopen(path, "r");
+    if (!fp) return 0;
+    unsigned long freq = 0;
+    if (fscanf(fp, "%lu", &freq) != 1) freq = 0;
+    fclose(fp);
+    return static_cast<uint32_t>(freq);
+}
+
+int count_cpus(const std::string& root) {
+    // "possible" 形如 "0-7"，包含当前离线的核
+    FILE* fp = fopen((root + "/possible").c_str(), "r");
+    if (fp) {
+        int first = 0, last = -1;
+        int n = fscanf(fp, "%d-%d", &first, &last);
+        fclose(fp);
+        if (n == 2 && last >= first) return last + 1;
+        if (n == 1) return first + 1;
+    }
+    long n = sysconf(_SC_NPROCESSORS_CONF);
+    return n > 0 ? static_cast<int>(n) : 1;
+}
+
+} // namespace
+
+const CpuTopology& CpuTopology::get() {
+    static const CpuTopology topology = detect();
+    return topology;
+}
+
+CpuTopology CpuTopology::detect(const std::string& sysfs_root) {
+    CpuTopology topo;
+    topo.n_cpus = count_cpus(sysfs_root);
+    topo.max_freq_khz.resize(topo.n_cpus);
+
+    uint32_t min_freq = UINT32_MAX;
+    for (int cpu = 0; cpu < topo.n_cpus; cpu++) {
+        uint32_t freq = read_max_freq(sysfs_root, cpu);
+        topo.max_freq_khz[cpu] = freq;
+        if (freq > 0) min_freq = std::min(min_freq, freq);
+    }
+
+    for (int cpu = 0; cpu < topo.n_cpus; cpu++) {
+        uint32_t freq = topo.max_freq_khz[cpu];
+        if (freq == 0) continue;  // 读不到频率（离线或无 cpufreq），不参与调度
+        if (freq > min_freq) {
+            topo.performance.push_back(cpu);
+        } else {
+            topo.efficiency.push_back(cpu);
+        }
+    }
+
+    // 同构 CPU：没有更快的核，最低档就是全部
+    if (topo.performance.empty()) {
+        topo.performance.swap(topo.efficiency);
+    }
+    // 完全读不到 cpufreq（如部分模拟器），按同构处理
+    if (topo.performance.empty()) {
+        for (int cpu = 0; cpu < topo.n_cpus; cpu++) topo.performance.push_back(cpu);
+    }
+
+    std::stable_sort(topo.performance.begin(), topo.performance.end(), [&topo](int a, int b) {
+        return topo.max_freq_khz[a] > topo.max_freq_khz[b];
+    });
+    return topo;
+}
+
+int CpuTopology::recommended_prefill_threads() const {
+    return std::max(1, static_cast<int>(performance.size()));
+}
+
+int CpuTopology::recommended_decode_threads() const {
+    return std::max(1, std::min(MAX_DECODE_THREADS, static_cast<int>(performance.size())));
+}
+
+} // namespace pulse
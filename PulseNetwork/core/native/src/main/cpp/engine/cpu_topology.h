@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pulse {
+
+/**
+ * CPU 拓扑
+ *
+ * 按 cpufreq 的 cpuinfo_max_freq 区分大小核：最高频率最低的一档是小核，
+ * 其余（大核、超大核）都算性能核。所有核频率相同时全部视为性能核
+ */
+struct CpuTopology {
+    int n_cpus = 0;
+    std::vector<int> performance;        // 性能核编号，按最高频率降序
+    std::vector<int> efficiency;         // 小核编号
+    std::vector<uint32_t> max_freq_khz;  // 按 CPU 编号索引，读取失败为 0
+
+    /**
+     * 进程内只探测一次
+     */
+    static const CpuTopology& get();
+
+    /**
+     * 从 sysfs 探测（sysfs_root 可替换，便于测试）
+     */
+    static CpuTopology detect(const std::string& sysfs_root = "/sys/devices/system/cpu");
+
+    bool heterogeneous() const { return !performance.empty() && !efficiency.empty(); }
+
+    /**
+     * 预填充是计算密集型，用满所有性能核
+     */
+    int recommended_prefill_threads() const;
+
+    /**
+     * 解码受内存带宽限制，超过 4 个线程基本不再提速，反而增加同步开销
+     */
+    int recommended_decode_threads() const;
+};
+
+} // namespace pulse
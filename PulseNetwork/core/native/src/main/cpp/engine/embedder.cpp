@@ -0,0 +1,112 @@
+#include "embedder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <android/log.h>
+
+#include "throttle.h"
+
+#define LOG_TAG "PulseNative"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace pulse {
+
+namespace {
+
+bool abort_callback(void* data) {
+    const CancelToken* cancel = static_cast<const CancelToken*>(data);
+    return cancel && cancel->should_stop();
+}
+
+} // namespace
+
+std::unique_ptr<Embedder> Embedder::create(llama_model* model, int n_threads, int n_ctx) {
+    auto cparams = llama_context_default_params();
+    cparams.embeddings = true;
+    cparams.pooling_type = LLAMA_POOLING_TYPE_MEAN;
+    // 池化要求整段文本在同一个 ubatch 内
+    cparams.n_ctx = n_ctx;
+    cparams.n_batch = n_ctx;
+    cparams.n_ubatch = n_ctx;
+    cparams.n_seq_max = 1;
+    // 不挂接推理线程池：嵌入可能与对话解码并发，共享线程池不安全
+    cparams.n_threads = n_threads;
+    cparams.n_threads_batch = n_threads;
+
+    std::unique_ptr<Embedder> embedder(new Embedder());
+    embedder->model_ = model;
+    embedder->ctx_ = llama_new_context_with_model(model, cparams);
+    if (!embedder->ctx_) {
+        LOGE("Failed to create embedding context");
+        return nullptr;
+    }
+    embedder->n_threads_ = n_threads;
+    embedder->dim_ = llama_n_embd(model);
+    embedder->n_ctx_ = static_cast<int>(llama_n_ctx(embedder->ctx_));
+    embedder->batch_ = llama_batch_init(embedder->n_ctx_, 0, 1);
+    return embedder;
+}
+
+Embedder::~Embedder() {
+    if (batch_.token) llama_batch_free(batch_);
+    if (ctx_) llama_free(ctx_);
+}
+
+bool Embedder::embed(const std::string& text, std::vector<float>& out, const CancelToken* cancel) {
+    std::vector<llama_token> tokens(text.size() + 2);
+    int n = llama_tokenize(model_, text.data(), static_cast<int32_t>(text.size()),
+                           tokens.data(), static_cast<int32_t>(tokens.size()), true, false);
+    if (n < 0) {
+        tokens.resize(-n);
+        n = llama_tokenize(model_, text.data(), static_cast<int32_t>(text.size()),
+                           tokens.data(), static_cast<int32_t>(tokens.size()), true, false);
+    }
+    if (n <= 0) return false;
+    n = std::min(n, n_ctx_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cancel && cancel->should_stop()) return false;
+    int cap = Throttle::instance().max_threads();
+    int threads = cap > 0 ? std::min(n_threads_, cap) : n_threads_;
+    llama_set_n_threads(ctx_, threads, threads);
+    llama_kv_cache_clear(ctx_);
+
+    // 每个位置都要输出，均值池化覆盖整段文本
+    batch_.n_tokens = n;
+    for (int i = 0; i < n; i++) {
+        batch_.token[i] = tokens[i];
+        batch_.pos[i] = i;
+        batch_.n_seq_id[i] = 1;
+        batch_.seq_id[i][0] = 0;
+        batch_.logits[i] = true;
+    }
+    llama_set_abort_callback(ctx_, &abort_callback, const_cast<CancelToken*>(cancel));
+    int rc = llama_decode(ctx_, batch_);
+    llama_set_abort_callback(ctx_, nullptr, nullptr);
+    if (rc != 0) {
+        // abort_callback 中止时也会返回非 0，不算错误
+        if (!cancel || !cancel->should_stop()) LOGE("Embedding decode failed (%d tokens)", n);
+        return false;
+    }
+
+    const float* pooled = llama_get_embeddings_seq(ctx_, 0);
+    if (!pooled) {
+        LOGE("Model returned no pooled embedding");
+        return false;
+    }
+
+    double norm = 0.0;
+    for (int i = 0; i < dim_; i++) norm += double(pooled[i]) * pooled[i];
+    if (norm <= 0.0) return false;
+    const float inv = static_cast<float>(1.0 / std::sqrt(norm));
+    out.resize(dim_);
+    for (int i = 0; i < dim_; i++) out[i] = pooled[i] * inv;
+    return true;
+}
+
+size_t Embedder::memory_bytes() const {
+    return llama_state_get_size(ctx_);
+}
+
+} // namespace pulse
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cancel_token.h"
+#include "llama.h"
+
+namespace pulse {
+
+/**
+ * 文本嵌入
+ *
+ * 在同一份权重上另建一个开启 embeddings、按均值池化的小上下文，
+ * 不占用对话会话的 KV cache，对话进行中也能计算嵌入。
+ * 生成式模型的池化向量不是专门训练的句向量，相似度阈值需按模型校准
+ */
+class Embedder {
+public:
+    static constexpr int DEFAULT_N_CTX = 512;
+
+    /**
+     * @return 上下文创建失败时返回 nullptr
+     */
+    static std::unique_ptr<Embedder> create(llama_model* model, int n_threads, int n_ctx = DEFAULT_N_CTX);
+
+    ~Embedder();
+
+    Embedder(const Embedder&) = delete;
+    Embedder& operator=(const Embedder&) = delete;
+
+    /**
+     * 计算 L2 归一化的嵌入向量，超出上下文的文本截掉结尾
+     *
+     * 线程数受 Throttle 的 max_threads 限制；cancel 在计算图内部检查
+     * @return 分词或解码失败、被取消或超时时返回 false
+     */
+    bool embed(const std::string& text, std::vector<float>& out, const CancelToken* cancel = nullptr);
+
+    int dimension() const { return dim_; }
+    size_t memory_bytes() const;
+
+private:
+    Embedder() = default;
+
+    llama_model* model_ = nullptr;
+    llama_context* ctx_ = nullptr;
+    int dim_ = 0;
+    int n_ctx_ = 0;
+    int n_threads_ = 0;
+    std::mutex mutex_;
+    llama_batch batch_{};
+};
+
+} // namespace pulse
@@ -0,0 +1,204 @@
+#include "json_grammar.h"
+
+namespace pulse {
+
+namespace {
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+bool is_hex(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+} // namespace
+
+bool JsonGrammar::accepts(const std::string& piece) const {
+    JsonGrammar probe = *this;
+    for (char c : piece) {
+        if (!probe.feed(c)) return false;
+    }
+    return true;
+}
+
+bool JsonGrammar::advance(const std::string& piece) {
+    JsonGrammar next = *this;
+    for (char c : piece) {
+        if (!next.feed(c)) return false;
+    }
+    *this = next;
+    return true;
+}
+
+// ========== 私有方法 ==========
+
+bool JsonGrammar::feed(char c) {
+    switch (state_) {
+        case State::START:
+            if (is_space(c)) return true;
+            if (c != '{' && c != '[') return false;
+            return feed_value_start(c);
+
+        case State::VALUE:
+            if (is_space(c)) return true;
+            return feed_value_start(c);
+
+        case State::ARRAY_FIRST:
+            if (is_space(c)) return true;
+            if (c == ']') return close_value();
+            return feed_value_start(c);
+
+        case State::OBJECT_FIRST:
+        case State::OBJECT_KEY:
+            if (is_space(c)) return true;
+            if (c == '}' && state_ == State::OBJECT_FIRST) return close_value();
+            if (c != '"') return false;
+            state_ = State::STRING;
+            string_is_key_ = true;
+            return true;
+
+        case State::COLON:
+            if (is_space(c)) return true;
+            if (c != ':') return false;
+            state_ = State::VALUE;
+            return true;
+
+        case State::AFTER_VALUE: {
+            if (is_space(c)) return true;
+            char top = stack_[depth_ - 1];
+            if (c == ',') {
+                state_ = top == '{' ? State::OBJECT_KEY : State::VALUE;
+                return true;
+            }
+            if ((c == '}' && top == '{') || (c == ']' && top == '[')) return close_value();
+            return false;
+        }
+
+        case State::STRING:
+            if (c == '"') {
+                if (string_is_key_) {
+                    state_ = State::COLON;
+                } else {
+                    state_ = depth_ == 0 ? State::DONE : State::AFTER_VALUE;
+                }
+                return true;
+            }
+            if (c == '\\') {
+                state_ = State::STRING_ESCAPE;
+                return true;
+            }
+            // 字符串内不允许未转义的控制字符
+            return static_cast<unsigned char>(c) >= 0x20;
+
+        case State::STRING_ESCAPE:
+            if (c == 'u') {
+                state_ = State::STRING_UNICODE;
+                unicode_left_ = 4;
+                return true;
+            }
+            if (c == '"' || c == '\\' || c == '/' || c == 'b' ||
+                c == 'f' || c == 'n' || c == 'r' || c == 't') {
+                state_ = State::STRING;
+                return true;
+            }
+            return false;
+
+        case State::STRING_UNICODE:
+            if (!is_hex(c)) return false;
+            if (--unicode_left_ == 0) state_ = State::STRING;
+            return true;
+
+        case State::NUMBER:
+            switch (number_phase_) {
+                case NumberPhase::SIGN:
+                    if (c == '0') { number_phase_ = NumberPhase::LEADING_ZERO; return true; }
+                    if (is_digit(c)) { number_phase_ = NumberPhase::INT; return true; }
+                    return false;
+                case NumberPhase::DOT:
+                    if (is_digit(c)) { number_phase_ = NumberPhase::FRAC; return true; }
+                    return false;
+                case NumberPhase::EXP:
+                    if (c == '+' || c == '-') { number_phase_ = NumberPhase::EXP_SIGN; return true; }
+                    if (is_digit(c)) { number_phase_ = NumberPhase::EXP_DIGITS; return true; }
+                    return false;
+                case NumberPhase::EXP_SIGN:
+                    if (is_digit(c)) { number_phase_ = NumberPhase::EXP_DIGITS; return true; }
+                    return false;
+                case NumberPhase::INT:
+                    if (is_digit(c)) return true;
+                    // fallthrough
+                case NumberPhase::LEADING_ZERO:
+                    if (c == '.') { number_phase_ = NumberPhase::DOT; return true; }
+                    if (c == 'e' || c == 'E') { number_phase_ = NumberPhase::EXP; return true; }
+                    break;
+                case NumberPhase::FRAC:
+                    if (is_digit(c)) return true;
+                    if (c == 'e' || c == 'E') { number_phase_ = NumberPhase::EXP; return true; }
+                    break;
+                case NumberPhase::EXP_DIGITS:
+                    if (is_digit(c)) return true;
+                    break;
+            }
+            // 数字在一个完整阶段结束，当前字符交给后续状态处理（顶层必是容器，depth_ > 0）
+            state_ = State::AFTER_VALUE;
+            return feed(c);
+
+        case State::LITERAL:
+            if (*literal_rest_ != c) return false;
+            if (*++literal_rest_ == '\0') {
+                state_ = depth_ == 0 ? State::DONE : State::AFTER_VALUE;
+            }
+            return true;
+
+        case State::DONE:
+            return is_space(c);
+    }
+    return false;
+}
+
+bool JsonGrammar::feed_value_start(char c) {
+    switch (c) {
+        case '{':
+        case '[':
+            if (depth_ >= MAX_DEPTH) return false;
+            stack_[depth_++] = c;
+            state_ = c == '{' ? State::OBJECT_FIRST : State::ARRAY_FIRST;
+            return true;
+        case '"':
+            state_ = State::STRING;
+            string_is_key_ = false;
+            return true;
+        case '-':
+            state_ = State::NUMBER;
+            number_phase_ = NumberPhase::SIGN;
+            return true;
+        case '0':
+            state_ = State::NUMBER;
+            number_phase_ = NumberPhase::LEADING_ZERO;
+            return true;
+        case 't':
+            state_ = State::LITERAL;
+            literal_rest_ = "rue";
+            return true;
+        case 'f':
+            state_ = State::LITERAL;
+            literal_rest_ = "alse";
+            return true;
+        case 'n':
+            state_ = State::LITERAL;
+            literal_rest_ = "ull";
+            return true;
+        default:
+            if (!is_digit(c)) return false;
+            state_ = State::NUMBER;
+            number_phase_ = NumberPhase::INT;
+            return true;
+    }
+}
+
+bool JsonGrammar::close_value() {
+    depth_--;
+    state_ = depth_ == 0 ? State::DONE : State::AFTER_VALUE;
+    return true;
+}
+
+} // namespace pulse
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace pulse {
+
+/**
+ * JSON 输出约束
+ *
+ * 逐字节推进的下推自动机，判断一段文本能否作为合法 JSON 的前缀继续下去。
+ * 状态是定长的平凡可复制结构，检查候选 token 时直接复制一份试探，不分配内存。
+ *
+ * 顶层只接受对象或数组；顶层值闭合后 done() 为 true，生成应就此结束
+ */
+class JsonGrammar {
+public:
+    static constexpr int MAX_DEPTH = 64;
+
+    /**
+     * 当前状态下追加 piece 后仍是合法前缀
+     */
+    bool accepts(const std::string& piece) const;
+
+    /**
+     * 推进状态，piece 不合法时返回 false 且状态不变
+     */
+    bool advance(const std::string& piece);
+
+    bool done() const { return state_ == State::DONE; }
+
+    void reset() { *this = JsonGrammar(); }
+
+private:
+    enum class State : uint8_t {
+        START,          // 等待顶层 { 或 [
+        VALUE,          // 等待一个值
+        ARRAY_FIRST,    // [ 之后：值或 ]
+        OBJECT_FIRST,   // { 之后：键或 }
+        OBJECT_KEY,     // , 之后：键
+        COLON,          // 键之后：:
+        AFTER_VALUE,    // 值之后：, 或闭合括号
+        STRING,
+        STRING_ESCAPE,
+        STRING_UNICODE,
+        NUMBER,
+        LITERAL,
+        DONE
+    };
+
+    // 数字内部阶段
+    enum class NumberPhase : uint8_t {
+        SIGN,           // 读到 -，需要数字
+        LEADING_ZERO,   // 整数部分为 0，之后只能是 . / e / 结束
+        INT,
+        DOT,            // 读到 .，需要数字
+        FRAC,
+        EXP,            // 读到 e/E，需要符号或数字
+        EXP_SIGN,       // 读到指数符号，需要数字
+        EXP_DIGITS
+    };
+
+    bool feed(char c);
+    bool feed_value_start(char c);
+    bool close_value();
+    static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    State state_ = State::START;
+    bool string_is_key_ = false;
+    NumberPhase number_phase_ = NumberPhase::INT;
+    uint8_t unicode_left_ = 0;
+    const char* literal_rest_ = nullptr;  // 指向 "true" / "false" / "null" 的剩余部分
+    int depth_ = 0;
+    char stack_[MAX_DEPTH] = {};          // '{' 或 '['
+};
+
+} // namespace pulse
@@ -0,0 +1,172 @@
+#include "llama_model.h"
+
+#include <mutex>
+#include <sys/stat.h>
+#include <android/log.h>
+
+#define LOG_TAG "PulseNative"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace pulse {
+
+namespace {
+
+// 加载前无法得知 KV 维度，按小模型 f16 KV 的典型值粗估
+constexpr uint64_t KV_BYTES_PER_TOKEN_ESTIMATE = 128ull << 10;
+
+// 嵌入上下文的计算缓冲区（n_ubatch = n_ctx，每个位置都输出），同样粗估
+constexpr uint64_t EMBEDDER_COMPUTE_BYTES_ESTIMATE = 32ull << 20;
+
+ggml_type to_ggml_type(KvCacheType type) {
+    switch (type) {
+        case KvCacheType::Q8_0: return GGML_TYPE_Q8_0;
+        case KvCacheType::Q4_0: return GGML_TYPE_Q4_0;
+        default: return GGML_TYPE_F16;
+    }
+}
+
+// 每 32 个元素的块：f16 64 字节，Q8_0 34 字节，Q4_0 18 字节
+uint64_t kv_bytes_per_token(KvCacheType type) {
+    switch (type) {
+        case KvCacheType::Q8_0: return KV_BYTES_PER_TOKEN_ESTIMATE * 34 / 64;
+        case KvCacheType::Q4_0: return KV_BYTES_PER_TOKEN_ESTIMATE * 18 / 64;
+        default: return KV_BYTES_PER_TOKEN_ESTIMATE;
+    }
+}
+
+void ensure_backend() {
+    static std::once_flag once;
+    std::call_once(once, [] { llama_backend_init(); });
+}
+
+struct ProgressStage {
+    const LlamaModel::ProgressFn* fn;
+    float base;
+    float scale;
+
+    bool report(float stage_progress) const {
+        return !*fn || (*fn)(base + stage_progress * scale);
+    }
+};
+
+} // namespace
+
+std::shared_ptr<LlamaModel> LlamaModel::load(const std::string& path,
+                                             const LoadOptions& options,
+                                             const ProgressFn& on_progress) {
+    ensure_backend();
+
+    ModelFile file;
+    bool has_layout = options.use_mmap && file.open(path);
+    bool eager = has_layout && options.prefetch == PrefetchMode::EAGER;
+
+    ProgressStage stage{&on_progress, 0.0f, eager ? 0.5f : 1.0f};
+
+    auto mparams = llama_model_default_params();
+    mparams.use_mmap = options.use_mmap;
+    mparams.use_mlock = options.use_mlock;
+    mparams.progress_callback = [](float progress, void* user_data) {
+        return static_cast<ProgressStage*>(user_data)->report(progress);
+    };
+    mparams.progress_callback_user_data = &stage;
+
+    std::shared_ptr<LlamaModel> result(new LlamaModel());
+    result->path_ = path;
+    result->model_ = llama_load_model_from_file(path.c_str(), mparams);
+    if (!result->model_) {
+        LOGE("Failed to load model: %s", path.c_str());
+        return nullptr;
+    }
+
+    if (has_layout) {
+        if (!file.apply_hints(options.prefetch)) {
+            LOGI("Model mapping not found, skipping madvise hints");
+        } else if (eager) {
+            stage.base = 0.5f;
+            stage.scale = 0.5f;
+            bool completed = file.prefetch([&stage](uint64_t done, uint64_t total) {
+                return stage.report(total > 0 ? float(done) / float(total) : 1.0f);
+            });
+            if (!completed) {
+                LOGI("Model prefetch cancelled");
+                return nullptr;
+            }
+        }
+    }
+
+    result->threads_ = InferenceThreadPool::create(options.threads);
+    if (!result->threads_) return nullptr;
+
+    auto cparams = llama_context_default_params();
+    cparams.n_ctx = options.n_ctx;
+    cparams.n_threads = result->threads_->decode_threads();
+    cparams.n_threads_batch = result->threads_->prefill_threads();
+    // 批量生成时多条序列共享 KV cache
+    cparams.n_seq_max = MAX_BATCH_SEQUENCES;
+    cparams.type_k = to_ggml_type(options.kv_cache);
+    cparams.type_v = to_ggml_type(options.kv_cache);
+    // llama.cpp 只在 flash attention 下支持量化的 V cache
+    if (options.kv_cache != KvCacheType::F16) cparams.flash_attn = true;
+
+    result->ctx_ = llama_new_context_with_model(result->model_, cparams);
+    if (!result->ctx_) {
+        LOGE("Failed to create context");
+        return nullptr;
+    }
+    result->threads_->attach(result->ctx_);
+
+    result->n_ctx_ = static_cast<int>(llama_n_ctx(result->ctx_));
+    result->kv_cache_ = options.kv_cache;
+    result->embeddings_ = options.embeddings;
+    // 嵌入只服务于回答索引的相似查询，第一次需要时才创建，不需要的模型不多占一个上下文
+    LlamaSession::EmbedderFn embedder;
+    if (options.embeddings) {
+        LlamaModel* self = result.get();
+        embedder = [self] { return self->embedder(); };
+    }
+    result->session_.reset(new LlamaSession(result->model_, result->ctx_, result->threads_.get(),
+                                            std::move(embedder)));
+    result->memory_bytes_ = llama_model_size(result->model_) + llama_state_get_size(result->ctx_);
+
+    stage.base = 1.0f;
+    stage.scale = 0.0f;
+    stage.report(0.0f);
+
+    LOGI("Model loaded: %zu tensor regions, %.1f MB resident",
+         file.regions().size(), result->memory_bytes_ / (1024.0 * 1024.0));
+    return result;
+}
+
+uint64_t LlamaModel::estimate_bytes(const std::string& path, int n_ctx, KvCacheType kv_cache, bool embeddings) {
+    struct stat st {};
+    uint64_t file_bytes = stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+    uint64_t bytes = file_bytes + static_cast<uint64_t>(n_ctx) * kv_bytes_per_token(kv_cache);
+    // 嵌入器按需创建，但预留在加载时就算上，创建时不会超出注册表的预算
+    if (embeddings) {
+        bytes += static_cast<uint64_t>(Embedder::DEFAULT_N_CTX) * kv_bytes_per_token(KvCacheType::F16) +
+                 EMBEDDER_COMPUTE_BYTES_ESTIMATE;
+    }
+    return bytes;
+}
+
+Embedder* LlamaModel::embedder() const {
+    if (!embeddings_) return nullptr;
+    std::call_once(embedder_once_, [this] {
+        // 创建失败时退化为精确匹配，之后不再重试
+        embedder_ = Embedder::create(model_, threads_->prefill_threads());
+        if (embedder_) memory_bytes_ += embedder_->memory_bytes();
+    });
+    return embedder_.get();
+}
+
+LlamaModel::~LlamaModel() {
+    session_.reset();
+    embedder_.reset();
+    if (ctx_) llama_free(ctx_);
+    threads_.reset();  // 上下文释放之后线程池才能销毁
+    if (model_) llama_free_model(model_);
+    LOGI("Model released: %s", path_.c_str());
+}
+
+} // namespace pulse
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "embedder.h"
+#include "llama.h"
+#include "llama_session.h"
+#include "model_file.h"
+#include "model_registry.h"
+#include "thread_pool.h"
+
+namespace pulse {
+
+/**
+ * KV cache 精度，与 Kotlin 侧 KvCacheType 的 ordinal 对应
+ *
+ * 量化后 KV 内存约为 f16 的 1/2（Q8_0）或 1/4（Q4_0），同样内存可容纳更长的上下文
+ */
+enum class KvCacheType : int {
+    F16 = 0,
+    Q8_0 = 1,
+    Q4_0 = 2
+};
+
+/**
+ * 模型加载参数
+ */
+struct LoadOptions {
+    int n_ctx = 2048;
+    KvCacheType kv_cache = KvCacheType::F16;
+    ThreadConfig threads;
+    bool use_mmap = true;
+    bool use_mlock = false;
+    PrefetchMode prefetch = PrefetchMode::EAGER;
+    bool embeddings = true;  // 允许按需创建嵌入上下文，草稿模型不需要
+};
+
+/**
+ * 已加载的 llama 模型及其推理上下文
+ */
+class LlamaModel : public ResidentModel {
+public:
+    // 加载进度 [0, 1]，返回 false 取消加载
+    using ProgressFn = std::function<bool(float)>;
+
+    /**
+     * 加载 GGUF 模型
+     *
+     * 权重通过 mmap 由页缓存支撑；解析 GGUF 头部后按张量区域施加 madvise 提示，
+     * EAGER 模式下再逐张量预取，进度分两段：llama 加载 [0, 0.5)，预取 [0.5, 1]
+     */
+    static std::shared_ptr<LlamaModel> load(const std::string& path,
+                                            const LoadOptions& options,
+                                            const ProgressFn& on_progress);
+
+    /**
+     * 加载前预估内存占用（文件大小 + KV cache，允许嵌入时再加上嵌入上下文），供注册表提前腾空间
+     */
+    static uint64_t estimate_bytes(const std::string& path, int n_ctx, KvCacheType kv_cache,
+                                   bool embeddings = true);
+
+    ~LlamaModel() override;
+
+    ModelKind kind() const override { return ModelKind::LLAMA; }
+    uint64_t memory_bytes() const override { return memory_bytes_.load(std::memory_order_relaxed); }
+
+    llama_model* model() const { return model_; }
+    llama_context* context() const { return ctx_; }
+    const std::string& path() const { return path_; }
+    int n_ctx() const { return n_ctx_; }
+    KvCacheType kv_cache() const { return kv_cache_; }
+    LlamaSession& session() const { return *session_; }
+
+    /**
+     * 嵌入器在第一次调用时创建（另一个上下文），之后计入 memory_bytes
+     * @return 加载时关闭了嵌入或创建失败时为空
+     */
+    Embedder* embedder() const;
+
+private:
+    LlamaModel() = default;
+
+    llama_model* model_ = nullptr;
+    llama_context* ctx_ = nullptr;
+    std::string path_;
+    int n_ctx_ = 0;
+    KvCacheType kv_cache_ = KvCacheType::F16;
+    mutable std::atomic<uint64_t> memory_bytes_{0};  // 嵌入器创建后增加
+    bool embeddings_ = false;
+    std::unique_ptr<InferenceThreadPool> threads_;
+    mutable std::once_flag embedder_once_;
+    mutable std::unique_ptr<Embedder> embedder_;
+    std::unique_ptr<LlamaSession> session_;
+};
+
+} // namespace pulse
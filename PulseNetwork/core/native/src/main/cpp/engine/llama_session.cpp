@@ -0,0 +1,1046 @@
+#include "llama_session.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <android/log.h>
+
+#include "llama_model.h"
+#include "throttle.h"
+
+#define LOG_TAG "PulseNative"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace pulse {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+void batch_add(llama_batch& batch, llama_token token, llama_pos pos, llama_seq_id seq, bool logits) {
+    int i = batch.n_tokens++;
+    batch.token[i] = token;
+    batch.pos[i] = pos;
+    batch.n_seq_id[i] = 1;
+    batch.seq_id[i][0] = seq;
+    batch.logits[i] = logits;
+}
+
+/**
+ * 超长提示词截掉中间，保留开头约四分之一（BOS、模板头和系统提示词）和其余的结尾（问题与助手前缀）
+ */
+void truncate_middle(std::vector<llama_token>& tokens, int max_tokens) {
+    if (max_tokens <= 0) {
+        tokens.clear();
+        return;
+    }
+    if (static_cast<int>(tokens.size()) <= max_tokens) return;
+    const int head = std::max(1, max_tokens / 4);
+    const int tail = max_tokens - head;
+    tokens.erase(tokens.begin() + head, tokens.end() - tail);
+}
+
+constexpr uint64_t FNV_OFFSET = 1469598103934665603ull;
+
+/**
+ * token 序列的 FNV-1a 64 位哈希，可链式累加，用作对话回答索引的上下文指纹
+ */
+uint64_t context_hash(const llama_token* tokens, size_t n, uint64_t h = FNV_OFFSET) {
+    for (size_t i = 0; i < n; i++) {
+        auto v = static_cast<uint32_t>(tokens[i]);
+        for (int b = 0; b < 4; b++) {
+            h ^= (v >> (b * 8)) & 0xff;
+            h *= 1099511628211ull;
+        }
+    }
+    return h;
+}
+
+/**
+ * 对话回答索引的精确键：问题原文加上下文哈希（覆盖已写入的 token 和本轮输入），
+ * 系统提示词或之前的对话不同时不会命中
+ */
+std::string answer_key(const std::string& question, uint64_t hash) {
+    char prefix[17];
+    snprintf(prefix, sizeof(prefix), "%016llx", static_cast<unsigned long long>(hash));
+    return std::string(prefix) + question;
+}
+
+constexpr uint32_t SESSION_MAGIC = 0x53455350;  // "PSES"
+constexpr uint32_t SESSION_VERSION = 1;
+
+/**
+ * 会话快照文件头
+ *
+ * 布局：SessionFileHeader | tokens[n_tokens] | llama_state_seq 数据（seq 0）
+ * 采样器每次生成重新构建，其惩罚窗口由 tokens 重建，无需单独保存
+ */
+struct SessionFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t model_params;   // 与 n_vocab 一起粗略识别模型
+    int32_t n_vocab;
+    int32_t n_tokens;
+    int32_t n_keep;
+    int32_t pending;
+    uint32_t chat_active;
+    uint32_t reserved;
+    uint64_t state_bytes;
+};
+
+/**
+ * 只读映射的快照文件
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat st {};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data_ = static_cast<const uint8_t*>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+                // 整个文件只顺序读一遍；advice 是枚举值而不是位标志，需分两次设置
+                madvise(addr, size_, MADV_SEQUENTIAL);
+                madvise(addr, size_, MADV_WILLNEED);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * 按 UTF-8 字符边界切分输出
+ *
+ * 单个 token 可能只是多字节字符（中文、emoji）的一部分，
+ * 凑齐完整字符后再交给回调，避免 Java 侧收到非法 UTF-8
+ */
+class Utf8Emitter {
+public:
+    explicit Utf8Emitter(const LlamaSession::TokenFn& fn) : fn_(fn) {
+        // 缓冲区按请求预留，解码循环中不再扩容
+        pending_.reserve(PIECE_RESERVE);
+        out_.reserve(PIECE_RESERVE);
+        piece_.reserve(PIECE_RESERVE);
+    }
+
+    /**
+     * 供 token_to_piece 写入的复用缓冲区
+     */
+    std::string& piece() { return piece_; }
+
+    bool push(const std::string& piece) {
+        pending_ += piece;
+        size_t complete = complete_prefix(pending_);
+        if (complete == 0) return true;
+        out_.assign(pending_, 0, complete);
+        pending_.erase(0, complete);
+        return !fn_ || fn_(out_);
+    }
+
+    void flush() {
+        if (!pending_.empty() && fn_) fn_(pending_);
+        pending_.clear();
+    }
+
+private:
+    static size_t complete_prefix(const std::string& s) {
+        // 从末尾回看最多 4 个字节，找到最后一个字符的首字节
+        size_t n = s.size();
+        for (size_t back = 1; back <= std::min<size_t>(4, n); back++) {
+            auto c = static_cast<unsigned char>(s[n - back]);
+            if ((c & 0xC0) == 0x80) continue;  // 续字节
+            size_t len = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : 4;
+            return back >= len ? n : n - back;
+        }
+        return n;
+    }
+
+    static constexpr size_t PIECE_RESERVE = 128;
+
+    const LlamaSession::TokenFn& fn_;
+    std::string pending_;
+    std::string out_;
+    std::string piece_;
+};
+
+} // namespace
+
+bool decode_tokens(llama_context* ctx, const llama_token* tokens, int n_tokens, int pos0,
+                   const CancelToken* cancel) {
+    int n_batch = static_cast<int>(llama_n_batch(ctx));
+    int max_batch = Throttle::instance().max_batch();
+    if (max_batch > 0) n_batch = std::min(n_batch, max_batch);
+    for (int i = 0; i < n_tokens; i += n_batch) {
+        if (cancel && cancel->should_stop()) return false;
+        int n = std::min(n_batch, n_tokens - i);
+        llama_batch batch = llama_batch_get_one(const_cast<llama_token*>(tokens + i), n, pos0 + i, 0);
+        if (llama_decode(ctx, batch) != 0) {
+            // abort_callback 中止时也会返回非 0，不算错误
+            if (!cancel || !cancel->should_stop()) LOGE("llama_decode failed at pos %d", pos0 + i);
+            return false;
+        }
+    }
+    return true;
+}
+
+LlamaSession::LlamaSession(llama_model* model, llama_context* ctx, const InferenceThreadPool* threads,
+                           EmbedderFn embedder)
+        : model_(model), ctx_(ctx), threads_(threads), embedder_(std::move(embedder)) {
+    // 嵌入维度即模型的 n_embd，不必为此创建嵌入器
+    if (embedder_) semantic_index_.set_dimension(llama_n_embd(model_));
+    llama_set_abort_callback(ctx_, &LlamaSession::abort_callback, this);
+    // 解码循环中追加 token 不扩容
+    tokens_.reserve(llama_n_ctx(ctx_));
+}
+
+std::vector<llama_token> LlamaSession::tokenize(const std::string& text, bool add_special) const {
+    std::vector<llama_token> tokens(text.size() + 2);
+    int n = llama_tokenize(model_, text.data(), static_cast<int32_t>(text.size()),
+                           tokens.data(), static_cast<int32_t>(tokens.size()), add_special, true);
+    if (n < 0) {
+        tokens.resize(-n);
+        n = llama_tokenize(model_, text.data(), static_cast<int32_t>(text.size()),
+                           tokens.data(), static_cast<int32_t>(tokens.size()), add_special, true);
+    }
+    tokens.resize(std::max(n, 0));
+    return tokens;
+}
+
+std::string LlamaSession::token_to_piece(llama_token token) const {
+    std::string piece;
+    token_to_piece(token, piece);
+    return piece;
+}
+
+void LlamaSession::token_to_piece(llama_token token, std::string& out) const {
+    char buf[64];
+    int n = llama_token_to_piece(model_, token, buf, sizeof(buf), false);
+    if (n >= 0) {
+        out.assign(buf, n);
+        return;
+    }
+
+    out.resize(-n);
+    n = llama_token_to_piece(model_, token, &out[0], static_cast<int32_t>(out.size()), false);
+    out.resize(std::max(n, 0));
+}
+
+std::vector<llama_token> LlamaSession::tokenize_cached(const std::string& text, bool add_special) const {
+    return token_cache_.get(text, add_special, [this](const std::string& t, bool special) {
+        return tokenize(t, special);
+    });
+}
+
+int LlamaSession::count_tokens(const std::string& text) const {
+    return static_cast<int>(tokenize_cached(text, false).size());
+}
+
+std::string LlamaSession::detokenize(const std::vector<llama_token>& tokens) const {
+    const int n_vocab = llama_n_vocab(model_);
+    std::string text;
+    for (llama_token token : tokens) {
+        if (token >= 0 && token < n_vocab) text += token_to_piece(token);
+    }
+    return text;
+}
+
+bool LlamaSession::apply_chat_template(const std::vector<ChatTurn>& turns, bool add_assistant,
+                                       std::string& out) const {
+    std::vector<llama_chat_message> messages;
+    messages.reserve(turns.size());
+    size_t total = 0;
+    for (const auto& turn : turns) {
+        messages.push_back({turn.role.c_str(), turn.content.c_str()});
+        total += turn.role.size() + turn.content.size();
+    }
+
+    // 模板标记通常不超过内容的四分之一，放不下时按返回的长度重试
+    out.resize(total + total / 4 + 256);
+    int32_t n = llama_chat_apply_template(model_, nullptr, messages.data(), messages.size(), add_assistant,
+                                          &out[0], static_cast<int32_t>(out.size()));
+    if (n > static_cast<int32_t>(out.size())) {
+        out.resize(n);
+        n = llama_chat_apply_template(model_, nullptr, messages.data(), messages.size(), add_assistant,
+                                      &out[0], static_cast<int32_t>(out.size()));
+    }
+    if (n < 0) {
+        out.clear();
+        return false;
+    }
+    out.resize(n);
+    return true;
+}
+
+GenerateResult LlamaSession::generate(const std::string& prompt,
+                                      int max_tokens,
+                                      const SamplingParams& params,
+                                      const TokenFn& on_token,
+                                      const CancelToken* cancel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    GenerateResult result;
+
+    // 等待会话锁期间可能已被取消或超时
+    if (cancel && cancel->should_stop()) {
+        result.stop_reason = cancel->cancelled() ? StopReason::CANCELLED : StopReason::TIMEOUT;
+        return result;
+    }
+    cancel_.store(cancel);
+
+    std::vector<llama_token> tokens = tokenize(prompt, true);
+    const int n_ctx = static_cast<int>(llama_n_ctx(ctx_));
+    max_tokens = std::max(1, std::min(max_tokens, n_ctx / 2));
+
+    // 超长提示词截掉中间，为生成留出空间
+    const int max_prompt = n_ctx - max_tokens;
+    if (static_cast<int>(tokens.size()) > max_prompt) {
+        LOGI("Prompt truncated: %zu -> %d tokens", tokens.size(), max_prompt);
+        truncate_middle(tokens, max_prompt);
+    }
+    if (tokens.empty()) {
+        cancel_.store(nullptr);
+        result.ok = false;
+        result.stop_reason = StopReason::FAILED;
+        return result;
+    }
+    result.n_prompt = static_cast<int>(tokens.size());
+
+    arena_.reset();
+    Sampler sampler(params, params.grammar != GrammarMode::NONE ? &vocab() : nullptr, &arena_);
+    sampler.prime(tokens);
+    Utf8Emitter emitter(on_token);
+    auto emit = [&](llama_token token) {
+        if (llama_token_is_eog(model_, token)) return true;
+        token_to_piece(token, emitter.piece());
+        return emitter.push(emitter.piece());
+    };
+
+    // 单次生成会结束当前的多轮对话
+    llama_kv_cache_clear(ctx_);
+    tokens_.clear();
+    pending_ = -1;
+    n_keep_ = 0;
+    chat_active_ = false;
+    apply_throttle();
+
+    // 惩罚和语法约束依赖已确认的输出，草稿阶段无法提前算出同样的分布，只走普通解码
+    std::shared_ptr<LlamaModel> draft = draft_.lock();
+    std::unique_lock<std::mutex> draft_lock;
+    if (draft && static_cast<int>(tokens.size()) > 1 && !sampler.has_history_constraints()) {
+        draft_lock = draft->session().lock_for_draft();
+    }
+    if (draft_lock.owns_lock()) {
+        SpeculativeStats run;
+        SpeculativeDecoder decoder(ctx_, draft->context(), n_draft_);
+        SpeculativeResult spec = decoder.generate(tokens, max_tokens, sampler, emit, run, cancel);
+        result.n_generated = spec.n_generated;
+        result.prefill_ms = spec.prefill_ms;
+        result.decode_ms = run.decode_ms;
+        if (!spec.ok) {
+            LOGE("Speculative decoding failed after %d tokens", spec.n_generated);
+            result.ok = false;
+            result.stop_reason = StopReason::FAILED;
+        }
+        // 解码器不维护 tokens_，清空 KV 保持 seq 0 与 tokens_ 一致
+        llama_kv_cache_clear(ctx_);
+        draft_lock.unlock();
+
+        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+        stats_.drafted += run.drafted;
+        stats_.accepted += run.accepted;
+        stats_.generated += run.generated;
+        stats_.target_passes += run.target_passes;
+        stats_.decode_ms += run.decode_ms;
+    } else {
+        auto start = Clock::now();
+        bool prefilled = append_tokens(tokens.data(), result.n_prompt, cancel);
+        result.prefill_ms = elapsed_ms(start);
+
+        bool failed = !prefilled || !decode_loop(sampler, max_tokens, emit, cancel, result);
+        if (failed && !(cancel && cancel->should_stop())) {
+            result.ok = false;
+            result.stop_reason = StopReason::FAILED;
+        }
+    }
+    cancel_.store(nullptr);
+
+    if (cancel && cancel->should_stop() && result.ok) {
+        result.stop_reason = cancel->cancelled() ? StopReason::CANCELLED : StopReason::TIMEOUT;
+        LOGI("Generation %s after %d tokens",
+             result.stop_reason == StopReason::CANCELLED ? "cancelled" : "timed out", result.n_generated);
+    }
+
+    emitter.flush();
+    return result;
+}
+
+/**
+ * 批量生成中的一条序列
+ */
+struct LlamaSession::BatchSequence {
+    BatchSequence(size_t index, std::vector<llama_token> prompt,
+                  const SamplingParams& params, const Vocab* vocab, Arena* arena)
+            : index(index), prompt(std::move(prompt)), sampler(params, vocab, arena) {}
+
+    size_t index;                      // 在 prompts 中的位置
+    std::vector<llama_token> prompt;
+    Sampler sampler;
+    llama_pos n_past = 0;
+    llama_token next = -1;             // 已采样、尚未写入 KV 的 token
+    int32_t logits_index = -1;         // 本批次中该序列输出 logits 的位置
+    int n_generated = 0;
+    bool done = false;
+};
+
+GenerateResult LlamaSession::generate_batch(const std::vector<std::string>& prompts,
+                                            int max_tokens,
+                                            const SamplingParams& params,
+                                            std::vector<std::string>& outputs,
+                                            const CancelToken* cancel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    GenerateResult result;
+    outputs.assign(prompts.size(), std::string());
+
+    if (cancel && cancel->should_stop()) {
+        result.stop_reason = cancel->cancelled() ? StopReason::CANCELLED : StopReason::TIMEOUT;
+        return result;
+    }
+    cancel_.store(cancel);
+
+    const int n_ctx = static_cast<int>(llama_n_ctx(ctx_));
+    const int n_seq = std::max(1, std::min(MAX_BATCH_SEQUENCES, static_cast<int>(llama_n_seq_max(ctx_))));
+    max_tokens = std::max(1, std::min(max_tokens, n_ctx / 2));
+    const int max_prompt = n_ctx - max_tokens;
+
+    std::vector<std::vector<llama_token>> tokenized;
+    tokenized.reserve(prompts.size());
+    for (const auto& prompt : prompts) {
+        std::vector<llama_token> tokens = tokenize(prompt, true);
+        if (static_cast<int>(tokens.size()) > max_prompt) {
+            LOGI("Batch prompt truncated: %zu -> %d tokens", tokens.size(), max_prompt);
+            truncate_middle(tokens, max_prompt);
+        }
+        tokenized.push_back(std::move(tokens));
+    }
+
+    // 批量生成同样结束当前的多轮对话
+    llama_kv_cache_clear(ctx_);
+    tokens_.clear();
+    pending_ = -1;
+    n_keep_ = 0;
+    chat_active_ = false;
+    apply_throttle();
+    const Vocab* grammar_vocab = params.grammar != GrammarMode::NONE ? &vocab() : nullptr;
+
+    bool failed = false;
+    size_t next = 0;
+    while (next < tokenized.size() && !failed) {
+        if (cancel && cancel->should_stop()) break;
+
+        // 按 KV 容量装入尽量多的序列，每条预留完整的 max_tokens
+        arena_.reset();
+        std::vector<BatchSequence> group;
+        group.reserve(n_seq);
+        int used = 0;
+        while (next < tokenized.size() && static_cast<int>(group.size()) < n_seq) {
+            const int need = static_cast<int>(tokenized[next].size()) + max_tokens;
+            if (!group.empty() && used + need > n_ctx) break;
+            if (!tokenized[next].empty()) {
+                used += need;
+                result.n_prompt += static_cast<int>(tokenized[next].size());
+                group.emplace_back(next, std::move(tokenized[next]), params, grammar_vocab, &arena_);
+            }
+            next++;
+        }
+
+        failed = !decode_group(group, max_tokens, outputs, cancel, result);
+        llama_kv_cache_clear(ctx_);
+    }
+    cancel_.store(nullptr);
+
+    if (failed && !(cancel && cancel->should_stop())) {
+        result.ok = false;
+        result.stop_reason = StopReason::FAILED;
+    } else if (cancel && cancel->should_stop()) {
+        result.stop_reason = cancel->cancelled() ? StopReason::CANCELLED : StopReason::TIMEOUT;
+    }
+    LOGI("Batch of %zu prompts: %d tokens generated", prompts.size(), result.n_generated);
+    return result;
+}
+
+bool LlamaSession::start_chat(const std::string& system_prompt, const CancelToken* cancel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancel_.store(cancel);
+    bool ok = reset_chat(system_prompt, cancel);
+    cancel_.store(nullptr);
+    return ok;
+}
+
+GenerateResult LlamaSession::chat(const std::string& text,
+                                  int max_tokens,
+                                  const SamplingParams& params,
+                                  const TokenFn& on_token,
+                                  const CancelToken* cancel,
+                                  SemanticLookup* lookup) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    GenerateResult result;
+
+    if (cancel && cancel->should_stop()) {
+        result.stop_reason = cancel->cancelled() ? StopReason::CANCELLED : StopReason::TIMEOUT;
+        return result;
+    }
+    cancel_.store(cancel);
+
+    if (!chat_active_ && !reset_chat("", cancel)) {
+        cancel_.store(nullptr);
+        result.ok = false;
+        result.stop_reason = StopReason::FAILED;
+        return result;
+    }
+
+    const int n_ctx = static_cast<int>(llama_n_ctx(ctx_));
+    max_tokens = std::max(1, std::min(max_tokens, (n_ctx - n_keep_) / 2));
+
+    // 上一轮以结束符收尾时该 token 还没写入 KV，补在本轮开头
+    std::vector<llama_token> input;
+    const llama_token previous_pending = pending_;
+    if (pending_ >= 0) input.push_back(pending_);
+    pending_ = -1;
+    std::vector<llama_token> text_tokens = tokenize(text, false);
+    input.insert(input.end(), text_tokens.begin(), text_tokens.end());
+
+    const int max_input = n_ctx - n_keep_ - max_tokens;
+    if (static_cast<int>(input.size()) > max_input) {
+        LOGI("Chat turn truncated: %zu -> %d tokens", input.size(), max_input);
+        input.erase(input.begin(), input.end() - max_input);
+    }
+    if (input.empty()) {
+        cancel_.store(nullptr);
+        result.ok = false;
+        result.stop_reason = StopReason::FAILED;
+        return result;
+    }
+    result.n_prompt = static_cast<int>(input.size());
+
+    arena_.reset();
+    Sampler sampler(params, params.grammar != GrammarMode::NONE ? &vocab() : nullptr, &arena_);
+    Utf8Emitter emitter(on_token);
+    // 未命中时收集回答写入索引，预留一次避免逐 token 扩容
+    std::string answer;
+    if (lookup) answer.reserve(static_cast<size_t>(max_tokens) * 4);
+    auto emit = [&](llama_token token) {
+        if (llama_token_is_eog(model_, token)) return true;
+        token_to_piece(token, emitter.piece());
+        if (lookup) answer += emitter.piece();
+        return emitter.push(emitter.piece());
+    };
+
+    apply_throttle();
+
+    // 为新内容和回复一次腾出空间，生成过程中通常不必再平移；
+    // 腾不出空间时不改动上下文，本轮失败，结束符留给下一轮
+    if (!shift_context(result.n_prompt + max_tokens)) {
+        LOGE("Chat turn does not fit: %d + %d tokens after %d kept", result.n_prompt, max_tokens, n_keep_);
+        pending_ = previous_pending;
+        cancel_.store(nullptr);
+        result.ok = false;
+        result.stop_reason = StopReason::FAILED;
+        return result;
+    }
+
+    // 命中：不必预填充就能给出回答，写入上下文放到输出之后
+    std::string key;
+    uint64_t scope = 0;
+    if (lookup) {
+        // scope 只含本轮之前的上下文（包括补在开头的结束符），相似问题在同一 scope 内比较
+        const size_t n_carried = input.size() > text_tokens.size() ? 1 : 0;
+        scope = context_hash(input.data(), n_carried, context_hash(tokens_.data(), tokens_.size()));
+        key = answer_key(lookup->key, context_hash(input.data() + n_carried, input.size() - n_carried, scope));
+
+        // 同一 scope 内没有可比较的条目时不做嵌入，嵌入推迟到回答写入索引时
+        bool hit = semantic_index_.find_exact(key, answer);
+        Embedder* embedder = nullptr;
+        if (hit) {
+            lookup->similarity = 1.0f;
+        } else if (embedder_ && lookup->threshold > 0.0f && semantic_index_.has_vectors(scope) &&
+                   (embedder = embedder_()) && embedder->embed(lookup->key, lookup->embedding, cancel)) {
+            SemanticMatch match = semantic_index_.find_nearest(
+                scope, lookup->embedding.data(), static_cast<int>(lookup->embedding.size()), lookup->threshold);
+            if (match.found) {
+                hit = true;
+                lookup->similarity = match.similarity;
+                answer = std::move(match.answer);
+            }
+        }
+
+        if (hit) {
+            lookup->from_cache = true;
+            LOGI("Answer cache hit (similarity %.3f)", lookup->similarity);
+            emitter.push(answer);
+            emitter.flush();
+            bool ok = append_tokens(input.data(), result.n_prompt, cancel) &&
+                      append_answer(answer, max_tokens, cancel);
+            cancel_.store(nullptr);
+            if (!ok) {
+                // 回答已输出，上下文不完整时下一轮重新开始对话
+                LOGE("Failed to fold cached answer into context");
+                chat_active_ = false;
+            }
+            return result;
+        }
+    }
+
+    auto start = Clock::now();
+    bool prefilled = append_tokens(input.data(), result.n_prompt, cancel);
+    result.prefill_ms = elapsed_ms(start);
+
+    // 惩罚窗口覆盖之前的对话
+    sampler.prime(tokens_);
+
+    bool failed = !prefilled || !decode_loop(sampler, max_tokens, emit, cancel, result);
+    if (failed && !(cancel && cancel->should_stop())) {
+        result.ok = false;
+        result.stop_reason = StopReason::FAILED;
+    }
+    cancel_.store(nullptr);
+
+    if (cancel && cancel->should_stop() && result.ok) {
+        result.stop_reason = cancel->cancelled() ? StopReason::CANCELLED : StopReason::TIMEOUT;
+        LOGI("Chat turn %s after %d tokens",
+             result.stop_reason == StopReason::CANCELLED ? "cancelled" : "timed out", result.n_generated);
+    }
+
+    // 只缓存以结束符正常收尾的回答，被截断或中断的不写入
+    if (lookup && result.ok && result.stop_reason == StopReason::FINISHED &&
+        pending_ >= 0 && llama_token_is_eog(model_, pending_)) {
+        if (embedder_ && lookup->threshold > 0.0f && lookup->embedding.empty()) {
+            if (Embedder* embedder = embedder_()) embedder->embed(lookup->key, lookup->embedding, cancel);
+        }
+        semantic_index_.add(key, scope, lookup->embedding.empty() ? nullptr : lookup->embedding.data(),
+                            static_cast<int>(lookup->embedding.size()), answer);
+    }
+
+    emitter.flush();
+    return result;
+}
+
+bool LlamaSession::save_state(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto start = Clock::now();
+
+    SessionFileHeader header{};
+    header.magic = SESSION_MAGIC;
+    header.version = SESSION_VERSION;
+    header.model_params = llama_model_n_params(model_);
+    header.n_vocab = llama_n_vocab(model_);
+    header.n_tokens = static_cast<int32_t>(tokens_.size());
+    header.n_keep = n_keep_;
+    header.pending = pending_;
+    header.chat_active = chat_active_ ? 1 : 0;
+
+    std::vector<uint8_t> state(llama_state_seq_get_size(ctx_, 0));
+    header.state_bytes = llama_state_seq_get_data(ctx_, state.data(), state.size(), 0);
+    if (header.state_bytes == 0 && !tokens_.empty()) {
+        LOGE("Failed to read session state");
+        return false;
+    }
+
+    std::string tmp_path = path + ".tmp";
+    FILE* fp = fopen(tmp_path.c_str(), "wb");
+    if (!fp) {
+        LOGE("Cannot write session file: %s", tmp_path.c_str());
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(tokens_.data(), sizeof(llama_token), tokens_.size(), fp) == tokens_.size() &&
+              fwrite(state.data(), 1, header.state_bytes, fp) == header.state_bytes;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to write session file: %s", path.c_str());
+        unlink(tmp_path.c_str());
+        return false;
+    }
+
+    LOGI("Session saved: %d tokens, %.1f MB in %.0f ms", header.n_tokens,
+         header.state_bytes / (1024.0 * 1024.0), elapsed_ms(start));
+    return true;
+}
+
+bool LlamaSession::load_state(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto start = Clock::now();
+
+    MappedFile file(path);
+    if (!file.data() || file.size() < sizeof(SessionFileHeader)) {
+        LOGE("Cannot read session file: %s", path.c_str());
+        return false;
+    }
+
+    // 头部字段全部校验通过之后才改动上下文，损坏的文件不会清掉当前对话
+    SessionFileHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != SESSION_MAGIC || header.version != SESSION_VERSION || header.n_tokens < 0 ||
+        header.n_keep < 0 || header.n_keep > header.n_tokens) {
+        LOGE("Invalid session file: %s", path.c_str());
+        return false;
+    }
+    const size_t tokens_bytes = static_cast<size_t>(header.n_tokens) * sizeof(llama_token);
+    if (header.state_bytes > file.size() || file.size() != sizeof(header) + tokens_bytes + header.state_bytes) {
+        LOGE("Truncated session file: %s", path.c_str());
+        return false;
+    }
+    const int32_t n_vocab = llama_n_vocab(model_);
+    if (header.n_vocab != n_vocab || header.model_params != llama_model_n_params(model_) ||
+        header.n_tokens > static_cast<int32_t>(llama_n_ctx(ctx_))) {
+        LOGE("Session file belongs to another model or a larger context");
+        return false;
+    }
+    if (header.chat_active == 0) {
+        // 单次生成留下的上下文不是对话，按对话续写会丢掉系统提示词和历史
+        LOGE("Session file holds no active chat: %s", path.c_str());
+        return false;
+    }
+    if (header.pending < -1 || header.pending >= n_vocab) {
+        LOGE("Invalid pending token %d in session file", header.pending);
+        return false;
+    }
+    const uint8_t* tokens_data = file.data() + sizeof(header);
+    for (int32_t i = 0; i < header.n_tokens; i++) {
+        llama_token token;
+        memcpy(&token, tokens_data + i * sizeof(llama_token), sizeof(token));
+        if (token < 0 || token >= n_vocab) {
+            LOGE("Invalid token %d at %d in session file", token, i);
+            return false;
+        }
+    }
+
+    // 状态写入失败时上下文可能只恢复了一部分，统一从空上下文开始
+    llama_kv_cache_clear(ctx_);
+    tokens_.clear();
+    chat_active_ = false;
+    pending_ = -1;
+    n_keep_ = 0;
+
+    const uint8_t* state_data = tokens_data + tokens_bytes;
+    if (header.state_bytes > 0 &&
+        llama_state_seq_set_data(ctx_, state_data, header.state_bytes, 0) == 0) {
+        LOGE("Failed to restore session state (KV cache type mismatch?)");
+        llama_kv_cache_clear(ctx_);
+        return false;
+    }
+
+    tokens_.resize(header.n_tokens);
+    memcpy(tokens_.data(), tokens_data, tokens_bytes);
+    n_keep_ = header.n_keep;
+    pending_ = header.pending;
+    chat_active_ = true;
+
+    LOGI("Session restored: %d tokens in %.0f ms", header.n_tokens, elapsed_ms(start));
+    return true;
+}
+
+bool LlamaSession::set_draft(const std::shared_ptr<LlamaModel>& draft, int n_draft) {
+    if (!draft || draft->model() == model_) return false;
+
+    if (llama_n_vocab(draft->model()) != llama_n_vocab(model_)) {
+        LOGE("Draft model vocab mismatch: %d vs %d",
+             llama_n_vocab(draft->model()), llama_n_vocab(model_));
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    draft_ = draft;
+    n_draft_ = std::max(1, n_draft);
+    return true;
+}
+
+void LlamaSession::clear_draft() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    draft_.reset();
+    n_draft_ = 0;
+}
+
+std::unique_lock<std::mutex> LlamaSession::lock_for_draft() {
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (lock.owns_lock()) {
+        llama_kv_cache_clear(ctx_);
+        tokens_.clear();
+        pending_ = -1;
+        n_keep_ = 0;
+        chat_active_ = false;
+    }
+    return lock;
+}
+
+Arena::Stats LlamaSession::arena_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return arena_.stats();
+}
+
+SpeculativeStats LlamaSession::speculative_stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+// ========== 私有方法 ==========
+
+bool LlamaSession::reset_chat(const std::string& system_prompt, const CancelToken* cancel) {
+    llama_kv_cache_clear(ctx_);
+    tokens_.clear();
+    pending_ = -1;
+    n_keep_ = 0;
+    chat_active_ = false;
+    apply_throttle();
+
+    std::vector<llama_token> prefix = tokenize_cached(system_prompt, true);
+    // 保留前缀过长会让滑动窗口所剩无几，超出部分只保留开头
+    const int max_keep = static_cast<int>(llama_n_ctx(ctx_)) / 4;
+    if (static_cast<int>(prefix.size()) > max_keep) {
+        LOGI("System prompt truncated: %zu -> %d tokens", prefix.size(), max_keep);
+        prefix.resize(max_keep);
+    }
+    if (!prefix.empty() && !append_tokens(prefix.data(), static_cast<int>(prefix.size()), cancel)) {
+        return false;
+    }
+
+    n_keep_ = static_cast<int>(tokens_.size());
+    chat_active_ = true;
+    return true;
+}
+
+bool LlamaSession::append_answer(const std::string& answer, int max_tokens, const CancelToken* cancel) {
+    std::vector<llama_token> tokens = tokenize(answer, false);
+    // 只占用为回复预留的空间，超长的缓存回答在上下文中截断
+    if (static_cast<int>(tokens.size()) > max_tokens) tokens.resize(max_tokens);
+    if (!tokens.empty() && (!shift_context(static_cast<int>(tokens.size()) + 1) ||
+                            !append_tokens(tokens.data(), static_cast<int>(tokens.size()), cancel))) {
+        return false;
+    }
+    // 与正常生成一样，结束符留到下一轮开头写入
+    llama_token eot = llama_token_eot(model_);
+    pending_ = eot >= 0 ? eot : llama_token_eos(model_);
+    return true;
+}
+
+bool LlamaSession::append_tokens(const llama_token* tokens, int n_tokens, const CancelToken* cancel) {
+    const int n_past = static_cast<int>(tokens_.size());
+    if (!decode_tokens(ctx_, tokens, n_tokens, n_past, cancel)) {
+        // 部分分块可能已写入，回滚保证 tokens_ 与 KV cache 一致
+        llama_kv_cache_seq_rm(ctx_, 0, n_past, -1);
+        return false;
+    }
+    tokens_.insert(tokens_.end(), tokens, tokens + n_tokens);
+    return true;
+}
+
+bool LlamaSession::shift_context(int n_needed) {
+    const int n_ctx = static_cast<int>(llama_n_ctx(ctx_));
+    const int n_past = static_cast<int>(tokens_.size());
+    if (n_past + n_needed <= n_ctx) return true;
+
+    // 一次至少丢弃窗口的一半，避免每个 token 都触发平移
+    const int n_window = n_past - n_keep_;
+    const int n_discard = std::max(n_past + n_needed - n_ctx, n_window / 2);
+    if (n_discard > n_window) return false;
+
+    llama_kv_cache_seq_rm(ctx_, 0, n_keep_, n_keep_ + n_discard);
+    llama_kv_cache_seq_add(ctx_, 0, n_keep_ + n_discard, n_past, -n_discard);
+    tokens_.erase(tokens_.begin() + n_keep_, tokens_.begin() + n_keep_ + n_discard);
+
+    LOGI("Context shifted: kept %d + %d tokens, discarded %d",
+         n_keep_, n_window - n_discard, n_discard);
+    return true;
+}
+
+bool LlamaSession::decode_loop(Sampler& sampler,
+                               int max_tokens,
+                               const SpeculativeDecoder::EmitFn& emit,
+                               const CancelToken* cancel,
+                               GenerateResult& result) {
+    const int n_ctx = static_cast<int>(llama_n_ctx(ctx_));
+    const int n_vocab = llama_n_vocab(model_);
+    auto start = Clock::now();
+    bool failed = false;
+
+    while (result.n_generated < max_tokens) {
+        if (cancel && cancel->should_stop()) break;
+        // 单次生成写满即停；多轮对话滑动窗口继续
+        if (static_cast<int>(tokens_.size()) >= n_ctx && !(chat_active_ && shift_context(1))) break;
+        apply_throttle();
+
+        llama_token token = sampler.sample(llama_get_logits_ith(ctx_, -1), n_vocab);
+        sampler.accept(token);
+        result.n_generated++;
+        if (!emit(token) || llama_token_is_eog(model_, token) || sampler.grammar_done()) {
+            pending_ = token;
+            break;
+        }
+
+        if (!append_tokens(&token, 1, cancel)) {
+            failed = true;
+            break;
+        }
+        Throttle::instance().pause_between_tokens();
+    }
+
+    result.decode_ms = elapsed_ms(start);
+    return !failed;
+}
+
+bool LlamaSession::decode_group(std::vector<BatchSequence>& group,
+                                int max_tokens,
+                                std::vector<std::string>& outputs,
+                                const CancelToken* cancel,
+                                GenerateResult& result) {
+    if (group.empty()) return true;
+    const int n_vocab = llama_n_vocab(model_);
+    int n_batch = static_cast<int>(llama_n_batch(ctx_));
+    const int max_batch = Throttle::instance().max_batch();
+    if (max_batch > 0) n_batch = std::min(n_batch, max_batch);
+    // 解码步骤每条序列占一个位置
+    n_batch = std::max(n_batch, static_cast<int>(group.size()));
+
+    llama_batch batch = llama_batch_init(n_batch, 0, 1);
+    std::string piece;
+
+    // 从本批次的 logits 中为序列采样下一个 token
+    auto take = [&](BatchSequence& seq) {
+        llama_token token = seq.sampler.sample(llama_get_logits_ith(ctx_, seq.logits_index), n_vocab);
+        seq.sampler.accept(token);
+        seq.n_generated++;
+        result.n_generated++;
+        if (llama_token_is_eog(model_, token)) {
+            seq.done = true;
+            return;
+        }
+        token_to_piece(token, piece);
+        outputs[seq.index] += piece;
+        seq.done = seq.sampler.grammar_done() || seq.n_generated >= max_tokens;
+        seq.next = token;
+    };
+
+    bool failed = false;
+    std::vector<size_t> sampled_here;
+    auto flush = [&]() {
+        if (batch.n_tokens == 0) return true;
+        if (llama_decode(ctx_, batch) != 0) return false;
+        for (size_t s : sampled_here) take(group[s]);
+        sampled_here.clear();
+        batch.n_tokens = 0;
+        return true;
+    };
+
+    // 预填充：所有序列的提示词拼进同一批次，按 n_batch 分块，每条只为最后一个 token 输出 logits
+    auto start = Clock::now();
+    batch.n_tokens = 0;
+    for (size_t s = 0; s < group.size() && !failed; s++) {
+        BatchSequence& seq = group[s];
+        seq.sampler.prime(seq.prompt);
+        const int n_prompt = static_cast<int>(seq.prompt.size());
+        for (int i = 0; i < n_prompt; i++) {
+            const bool last = i + 1 == n_prompt;
+            batch_add(batch, seq.prompt[i], i, static_cast<llama_seq_id>(s), last);
+            if (last) {
+                seq.logits_index = batch.n_tokens - 1;
+                sampled_here.push_back(s);
+            }
+            if (batch.n_tokens == n_batch && !flush()) {
+                failed = true;
+                break;
+            }
+        }
+        seq.n_past = n_prompt;
+    }
+    if (!failed && !flush()) failed = true;
+    result.prefill_ms += elapsed_ms(start);
+
+    // 逐步解码：每步把所有未结束序列的上一个 token 放进同一批次
+    start = Clock::now();
+    while (!failed) {
+        if (cancel && cancel->should_stop()) break;
+        batch.n_tokens = 0;
+        for (size_t s = 0; s < group.size(); s++) {
+            BatchSequence& seq = group[s];
+            if (seq.done) continue;
+            batch_add(batch, seq.next, seq.n_past++, static_cast<llama_seq_id>(s), true);
+            seq.logits_index = batch.n_tokens - 1;
+            sampled_here.push_back(s);
+        }
+        if (batch.n_tokens == 0) break;
+
+        apply_throttle();
+        if (!flush()) {
+            failed = true;
+            break;
+        }
+        Throttle::instance().pause_between_tokens();
+    }
+    result.decode_ms += elapsed_ms(start);
+
+    llama_batch_free(batch);
+    if (failed && !(cancel && cancel->should_stop())) LOGE("Batched decode failed");
+    return !failed;
+}
+
+void LlamaSession::apply_throttle() {
+    const Throttle& throttle = Throttle::instance();
+    uint32_t version = throttle.version();
+    if (version == throttle_version_ || !threads_) return;
+    throttle_version_ = version;
+
+    int decode = threads_->decode_threads();
+    int prefill = threads_->prefill_threads();
+    int cap = throttle.max_threads();
+    if (cap > 0) {
+        decode = std::min(decode, cap);
+        prefill = std::min(prefill, cap);
+    }
+    // 线程池中多出的线程在本轮计算中空闲
+    llama_set_n_threads(ctx_, decode, prefill);
+}
+
+bool LlamaSession::abort_callback(void* data) {
+    const CancelToken* cancel = static_cast<LlamaSession*>(data)->cancel_.load(std::memory_order_relaxed);
+    return cancel && cancel->should_stop();
+}
+
+const Vocab& LlamaSession::vocab() {
+    if (vocab_.pieces.empty()) {
+        const int n_vocab = llama_n_vocab(model_);
+        vocab_.pieces.resize(n_vocab);
+        vocab_.is_eog.resize(n_vocab);
+        for (int i = 0; i < n_vocab; i++) {
+            vocab_.pieces[i] = token_to_piece(i);
+            vocab_.is_eog[i] = llama_token_is_eog(model_, i) ? 1 : 0;
+        }
+    }
+    return vocab_;
+}
+
+} // namespace pulse
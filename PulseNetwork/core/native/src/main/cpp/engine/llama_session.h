@@ -0,0 +1,312 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+#include "cancel_token.h"
+#include "llama.h"
+#include "sampler.h"
+#include "embedder.h"
+#include "semantic_index.h"
+#include "speculative.h"
+#include "thread_pool.h"
+#include "token_cache.h"
+
+namespace pulse {
+
+class LlamaModel;
+
+/**
+ * 生成结束原因
+ */
+enum class StopReason : int {
+    FINISHED = 0,   // 遇到结束符、达到 max_tokens 或回调要求停止
+    CANCELLED = 1,  // 取消令牌被触发
+    TIMEOUT = 2,    // 超过截止时间
+    FAILED = 3      // 分词或解码出错
+};
+
+/**
+ * 单次生成结果
+ */
+struct GenerateResult {
+    bool ok = true;
+    StopReason stop_reason = StopReason::FINISHED;
+    int n_prompt = 0;
+    int n_generated = 0;
+    double prefill_ms = 0.0;
+    double decode_ms = 0.0;
+};
+
+/**
+ * 对话轮次的回答缓存查询（先查缓存再解码）
+ */
+struct SemanticLookup {
+    std::string key;               // 用户问题原文，与对话上下文一起构成索引键
+    float threshold = 0.0f;        // 相似问题的余弦相似度下限，<= 0 时只做精确匹配
+
+    // 输出
+    bool from_cache = false;
+    float similarity = 0.0f;       // 命中条目的相似度，精确命中为 1
+    std::vector<float> embedding;  // 问题的归一化嵌入，只在做了相似查询或回答写入索引时计算，否则为空
+};
+
+/**
+ * 对话消息，role 为 system / user / assistant
+ */
+struct ChatTurn {
+    std::string role;
+    std::string content;
+};
+
+/**
+ * 批量生成时同时解码的序列数上限，上下文按此设置 n_seq_max
+ */
+constexpr int MAX_BATCH_SEQUENCES = 8;
+
+/**
+ * 按 n_batch（限流时取 max_batch）分块把 tokens 写入 seq 0 的 KV cache，只为最后一个 token 计算 logits
+ * 每个分块之前检查取消令牌，被取消时返回 false
+ */
+bool decode_tokens(llama_context* ctx, const llama_token* tokens, int n_tokens, int pos0,
+                   const CancelToken* cancel = nullptr);
+
+/**
+ * 推理会话
+ *
+ * 与 llama_context 一一对应，负责分词、预填充和解码循环；
+ * 挂载草稿模型后自动切换为推测解码。
+ *
+ * 两种用法：
+ * - generate：单次生成，每次清空 KV cache 重新预填充
+ * - start_chat + chat：多轮对话，KV cache 跨轮保留，每轮只预填充新内容；
+ *   上下文写满时保留系统提示词和最近的窗口，丢弃中间部分并平移 KV 位置
+ */
+class LlamaSession {
+public:
+    // 每产出一段完整的 UTF-8 文本回调一次，返回 false 停止生成
+    using TokenFn = std::function<bool(const std::string& piece)>;
+    // 按需取得嵌入器，第一次调用时才创建；创建失败时返回 nullptr
+    using EmbedderFn = std::function<Embedder*()>;
+
+    /**
+     * @param threads 上下文挂载的线程池，用于在限流时计算线程上限
+     * @param embedder 回答索引的相似问题查询用，只在阈值 > 0 时调用；为空时只做精确匹配
+     */
+    LlamaSession(llama_model* model, llama_context* ctx, const InferenceThreadPool* threads,
+                 EmbedderFn embedder = nullptr);
+
+    std::vector<llama_token> tokenize(const std::string& text, bool add_special) const;
+    std::string token_to_piece(llama_token token) const;
+
+    /**
+     * 写入调用方复用的缓冲区，容量足够时不申请内存
+     */
+    void token_to_piece(llama_token token, std::string& out) const;
+
+    /**
+     * 请求级临时内存的统计，用于验证解码循环无堆分配
+     */
+    Arena::Stats arena_stats() const;
+
+    /**
+     * 经 LRU 缓存的分词，反复出现的模板片段只分词一次
+     * 只读词表，不等待进行中的生成
+     */
+    std::vector<llama_token> tokenize_cached(const std::string& text, bool add_special) const;
+
+    /**
+     * 精确 token 数（不含 BOS），用于提示词预算
+     */
+    int count_tokens(const std::string& text) const;
+
+    /**
+     * token 序列还原为文本，越界的 id 被跳过
+     */
+    std::string detokenize(const std::vector<llama_token>& tokens) const;
+
+    /**
+     * @param cancel 可为空；触发后在一个 token（预填充时一个计算节点）之内返回
+     */
+    GenerateResult generate(const std::string& prompt,
+                            int max_tokens,
+                            const SamplingParams& params,
+                            const TokenFn& on_token,
+                            const CancelToken* cancel = nullptr);
+
+    /**
+     * 批量生成：每个提示词是一条独立序列，放进同一批次解码，
+     * 每步一次前向得到所有序列的下一个 token
+     *
+     * 序列共享 KV cache，按 n_ctx 和 MAX_BATCH_SEQUENCES 分组依次处理；
+     * 与单次 generate 一样会结束当前对话，且不走推测解码
+     * @param outputs 与 prompts 一一对应的生成文本
+     */
+    GenerateResult generate_batch(const std::vector<std::string>& prompts,
+                                  int max_tokens,
+                                  const SamplingParams& params,
+                                  std::vector<std::string>& outputs,
+                                  const CancelToken* cancel = nullptr);
+
+    /**
+     * 开始多轮对话：清空 KV cache 并预填充系统提示词
+     *
+     * 系统提示词（含 BOS）在之后的上下文滑动中始终保留
+     */
+    bool start_chat(const std::string& system_prompt, const CancelToken* cancel = nullptr);
+
+    /**
+     * 是否处于多轮对话中；单次 / 批量生成会结束对话，之后需重新 start_chat
+     */
+    bool chat_active() const { return chat_active_.load(); }
+
+    /**
+     * 按模型自带的对话模板（GGUF 中的 tokenizer.chat_template）格式化消息，
+     * 模型未带模板时 llama.cpp 按 ChatML 处理
+     * @param add_assistant 末尾追加助手回复的前缀
+     * @return 模板不受支持时返回 false
+     */
+    bool apply_chat_template(const std::vector<ChatTurn>& turns, bool add_assistant, std::string& out) const;
+
+    /**
+     * 在当前对话之后追加一轮并生成回复，未开始对话时以空系统提示词开始
+     *
+     * 多轮对话只走普通解码；单次 generate 会结束当前对话
+     *
+     * 传入 lookup 时先查回答索引，键为问题原文加上下文哈希，
+     * 只有系统提示词、之前的对话和本轮输入都相同时才命中；
+     * 精确未命中且 threshold > 0 时，再在上下文相同的条目中按问题嵌入找相似问题。
+     * 未命中正常解码，以结束符收尾的回答连同问题嵌入写入索引。
+     * 命中时回答先输出，再以批量预填充写入上下文，保持后续对话连贯
+     * @param text 已按模型对话模板格式化的新内容（用户发言及助手前缀）
+     */
+    GenerateResult chat(const std::string& text,
+                        int max_tokens,
+                        const SamplingParams& params,
+                        const TokenFn& on_token,
+                        const CancelToken* cancel = nullptr,
+                        SemanticLookup* lookup = nullptr);
+
+    /**
+     * 对话回答索引，键包含本会话的上下文，不从外部导入
+     */
+    SemanticIndex& semantic_index() { return semantic_index_; }
+
+    /**
+     * 把当前上下文（KV cache、已评估的 token 和对话状态）写入快照文件
+     *
+     * 先写临时文件再原子替换，写入中途失败不会破坏旧快照
+     */
+    bool save_state(const std::string& path);
+
+    /**
+     * 从快照文件恢复上下文，之后可直接 chat 续写，无需重新预填充
+     *
+     * 通过 mmap 读取，KV 数据从页缓存直接拷入上下文；
+     * 快照来自其他模型或更大的上下文、或保存时没有进行中的对话时返回 false
+     */
+    bool load_state(const std::string& path);
+
+    /**
+     * 挂载草稿模型（需与主模型共享词表）
+     * 只弱引用草稿模型，被注册表淘汰后自动回退为普通解码
+     */
+    bool set_draft(const std::shared_ptr<LlamaModel>& draft, int n_draft);
+    void clear_draft();
+
+    /**
+     * 本会话的上下文被其他会话借作草稿时调用，持锁期间调用方独占 context()
+     *
+     * 拿到锁时清空本会话的上下文和对话状态；本会话正在生成（例如草稿模型同时被激活为主模型）时
+     * 不等待，返回未持有的锁，调用方改走普通解码，互相借作草稿的两个会话也不会死锁
+     */
+    std::unique_lock<std::mutex> lock_for_draft();
+
+    SpeculativeStats speculative_stats() const;
+
+private:
+    /**
+     * 全词表 token 文本，首次启用语法约束时构建（需持有 mutex_）
+     */
+    const Vocab& vocab();
+
+    /**
+     * ggml 计算图每个节点之后回调，返回 true 中止本次 llama_decode
+     */
+    static bool abort_callback(void* data);
+
+    /**
+     * 限流参数变化后重新设置线程数（需持有 mutex_）
+     */
+    void apply_throttle();
+
+    /**
+     * 把 tokens 追加到 KV cache 末尾，失败时回滚到追加之前（需持有 mutex_）
+     */
+    bool append_tokens(const llama_token* tokens, int n_tokens, const CancelToken* cancel);
+
+    /**
+     * 保证还能追加 n_needed 个 token：丢弃保留前缀之后最旧的部分，
+     * 其余 token 的 KV 位置整体前移，无需重新计算（需持有 mutex_）
+     * @return 即使丢弃整个窗口也放不下时返回 false
+     */
+    bool shift_context(int n_needed);
+
+    /**
+     * 逐 token 采样、输出并写入 KV，直到结束符、max_tokens 或取消（需持有 mutex_）
+     * @return 解码出错时返回 false
+     */
+    bool decode_loop(Sampler& sampler,
+                     int max_tokens,
+                     const SpeculativeDecoder::EmitFn& emit,
+                     const CancelToken* cancel,
+                     GenerateResult& result);
+
+    bool reset_chat(const std::string& system_prompt, const CancelToken* cancel);
+
+    struct BatchSequence;
+
+    /**
+     * 一组序列的批量预填充与逐步解码（需持有 mutex_）
+     * @return 解码出错时返回 false
+     */
+    bool decode_group(std::vector<BatchSequence>& group,
+                      int max_tokens,
+                      std::vector<std::string>& outputs,
+                      const CancelToken* cancel,
+                      GenerateResult& result);
+
+    /**
+     * 把缓存的回答写入上下文并以结束符收尾（需持有 mutex_）
+     */
+    bool append_answer(const std::string& answer, int max_tokens, const CancelToken* cancel);
+
+    llama_model* model_;
+    llama_context* ctx_;
+    const InferenceThreadPool* threads_;
+    EmbedderFn embedder_;
+    mutable TokenCache token_cache_;
+    SemanticIndex semantic_index_;
+    uint32_t throttle_version_ = 0;
+    Vocab vocab_;
+    std::atomic<const CancelToken*> cancel_{nullptr};  // 当前生成的取消令牌
+
+    mutable std::mutex mutex_;
+    Arena arena_;                      // 请求级临时内存，每次生成开始时 reset
+    std::vector<llama_token> tokens_;  // seq 0 的 KV cache 中已有的 token
+    int n_keep_ = 0;                   // 上下文滑动时保留的前缀长度
+    std::atomic<bool> chat_active_{false};  // 无锁读取，生成期间也能查询
+    llama_token pending_ = -1;         // 上一轮最后采样但尚未写入 KV 的 token
+    std::weak_ptr<LlamaModel> draft_;
+    int n_draft_ = 0;
+
+    mutable std::mutex stats_mutex_;
+    SpeculativeStats stats_;
+};
+
+} // namespace pulse
@@ -0,0 +1,292 @@
+#include "model_file.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pulse {
+
+namespace {
+
+constexpr uint32_t GGUF_MAGIC = 0x46554747;  // "GGUF"
+constexpr uint64_t GGUF_DEFAULT_ALIGNMENT = 32;
+
+// GGUF 元数据值类型
+enum GgufType : uint32_t {
+    GGUF_UINT8 = 0, GGUF_INT8 = 1, GGUF_UINT16 = 2, GGUF_INT16 = 3,
+    GGUF_UINT32 = 4, GGUF_INT32 = 5, GGUF_FLOAT32 = 6, GGUF_BOOL = 7,
+    GGUF_STRING = 8, GGUF_ARRAY = 9, GGUF_UINT64 = 10, GGUF_INT64 = 11,
+    GGUF_FLOAT64 = 12
+};
+
+size_t scalar_size(uint32_t type) {
+    switch (type) {
+        case GGUF_UINT8: case GGUF_INT8: case GGUF_BOOL: return 1;
+        case GGUF_UINT16: case GGUF_INT16: return 2;
+        case GGUF_UINT32: case GGUF_INT32: case GGUF_FLOAT32: return 4;
+        case GGUF_UINT64: case GGUF_INT64: case GGUF_FLOAT64: return 8;
+        default: return 0;
+    }
+}
+
+/**
+ * 带越界检查的只读游标
+ */
+struct Cursor {
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+
+    template <typename T>
+    T read() {
+        T value{};
+        if (sizeof(T) > size - pos) {
+            ok = false;
+            return value;
+        }
+        memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string read_string() {
+        uint64_t len = read<uint64_t>();
+        if (!ok || len > size - pos) {
+            ok = false;
+            return {};
+        }
+        std::string s(reinterpret_cast<const char*>(data + pos), len);
+        pos += len;
+        return s;
+    }
+
+    void skip(uint64_t n) {
+        if (n > size - pos) {
+            ok = false;
+            return;
+        }
+        pos += n;
+    }
+
+    void skip_value(uint32_t type) {
+        if (type == GGUF_STRING) {
+            skip(read<uint64_t>());
+        } else if (type == GGUF_ARRAY) {
+            uint32_t elem_type = read<uint32_t>();
+            uint64_t count = read<uint64_t>();
+            if (elem_type == GGUF_STRING || elem_type == GGUF_ARRAY) {
+                for (uint64_t i = 0; i < count && ok; i++) skip_value(elem_type);
+            } else if (size_t sz = scalar_size(elem_type)) {
+                if (count > UINT64_MAX / sz) {
+                    ok = false;
+                    return;
+                }
+                skip(count * sz);
+            } else {
+                ok = false;
+            }
+        } else if (size_t sz = scalar_size(type)) {
+            skip(sz);
+        } else {
+            ok = false;
+        }
+    }
+};
+
+bool is_random_access(const std::string& name) {
+    // 词嵌入表每个 token 只读一行，顺序预读纯属浪费
+    return name.rfind("token_embd", 0) == 0;
+}
+
+uintptr_t page_floor(uintptr_t addr, uintptr_t page) { return addr & ~(page - 1); }
+uintptr_t page_ceil(uintptr_t addr, uintptr_t page) { return (addr + page - 1) & ~(page - 1); }
+
+} // namespace
+
+bool ModelFile::open(const std::string& path) {
+    path_ = path;
+    regions_.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    file_size_ = static_cast<uint64_t>(st.st_size);
+
+    // 只映射用于解析头部，解析完立即解除映射
+    void* addr = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return false;
+
+    madvise(addr, file_size_, MADV_SEQUENTIAL);
+    bool ok = parse(static_cast<const uint8_t*>(addr), file_size_);
+    munmap(addr, file_size_);
+    return ok;
+}
+
+bool ModelFile::parse(const uint8_t* data, size_t size) {
+    Cursor c{data, size};
+
+    if (c.read<uint32_t>() != GGUF_MAGIC) return false;
+    uint32_t version = c.read<uint32_t>();
+    if (version < 2) return false;  // v1 使用 32 位计数，已不再支持
+
+    uint64_t n_tensors = c.read<uint64_t>();
+    uint64_t n_kv = c.read<uint64_t>();
+    uint64_t alignment = GGUF_DEFAULT_ALIGNMENT;
+
+    for (uint64_t i = 0; i < n_kv && c.ok; i++) {
+        std::string key = c.read_string();
+        uint32_t type = c.read<uint32_t>();
+        if (key == "general.alignment" && type == GGUF_UINT32) {
+            alignment = c.read<uint32_t>();
+        } else {
+            c.skip_value(type);
+        }
+    }
+    if (!c.ok || alignment == 0) return false;
+
+    regions_.reserve(n_tensors);
+    for (uint64_t i = 0; i < n_tensors && c.ok; i++) {
+        TensorRegion region;
+        region.name = c.read_string();
+        uint32_t n_dims = c.read<uint32_t>();
+        c.skip(uint64_t(n_dims) * sizeof(uint64_t));  // n_dims 为 u32，乘积不会溢出
+        c.read<uint32_t>();  // ggml_type
+        region.offset = c.read<uint64_t>();
+        region.size = 0;
+        regions_.push_back(std::move(region));
+    }
+    if (!c.ok) return false;
+
+    data_offset_ = (c.pos + alignment - 1) / alignment * alignment;
+
+    // 张量大小由相邻偏移推出，无需维护 ggml 量化类型表
+    std::sort(regions_.begin(), regions_.end(),
+              [](const TensorRegion& a, const TensorRegion& b) { return a.offset < b.offset; });
+    for (size_t i = 0; i < regions_.size(); i++) {
+        regions_[i].offset += data_offset_;
+        uint64_t end = i + 1 < regions_.size()
+                       ? regions_[i + 1].offset + data_offset_
+                       : file_size_;
+        if (end < regions_[i].offset || end > file_size_) return false;
+        regions_[i].size = end - regions_[i].offset;
+    }
+    return true;
+}
+
+bool ModelFile::find_mapping(Mapping* mapping) const {
+    char resolved[PATH_MAX];
+    if (!realpath(path_.c_str(), resolved)) return false;
+
+    FILE* fp = fopen("/proc/self/maps", "r");
+    if (!fp) return false;
+
+    // madvise 会把一个映射拆成多行，按 start - offset 相同且首尾相接合并
+    Mapping best{0, 0, 0};
+    Mapping current{0, 0, 0};
+    char line[PATH_MAX + 128];
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long start, end, offset;
+        char perms[8];
+        int name_pos = 0;
+        if (sscanf(line, "%lx-%lx %7s %lx %*s %*s %n", &start, &end, perms, &offset, &name_pos) < 4) {
+            continue;
+        }
+        if (name_pos == 0 || start < offset) continue;
+
+        char* name = line + name_pos;
+        name[strcspn(name, "\n")] = '\0';
+        if (strcmp(name, resolved) != 0) continue;
+
+        uintptr_t base = start - offset;
+        uint64_t file_end = offset + (end - start);
+        if (current.end != 0 && current.base == base && current.end == offset) {
+            current.end = file_end;
+        } else {
+            current = {base, offset, file_end};
+        }
+
+        // 头部解析的映射已解除，剩下的最大映射就是 llama.cpp 的权重映射
+        if (current.end - current.begin > best.end - best.begin) best = current;
+    }
+    fclose(fp);
+
+    if (best.end == 0) return false;
+    *mapping = best;
+    return true;
+}
+
+bool ModelFile::apply_hints(PrefetchMode mode) const {
+    Mapping mapping{};
+    if (!find_mapping(&mapping)) return false;
+
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t map_begin = mapping.base + mapping.begin;
+    const uintptr_t map_end = mapping.base + mapping.end;
+
+    for (const auto& region : regions_) {
+        if (region.size == 0) continue;
+        uintptr_t begin = std::max(page_floor(mapping.base + region.offset, page), map_begin);
+        uintptr_t end = std::min(page_ceil(mapping.base + region.offset + region.size, page), map_end);
+        if (begin >= end) continue;
+
+        int advice;
+        if (is_random_access(region.name)) {
+            advice = MADV_RANDOM;
+        } else {
+            advice = mode == PrefetchMode::EAGER ? MADV_WILLNEED : MADV_NORMAL;
+        }
+        madvise(reinterpret_cast<void*>(begin), end - begin, advice);
+    }
+    return true;
+}
+
+bool ModelFile::prefetch(const ProgressFn& on_progress) const {
+    Mapping mapping{};
+    if (!find_mapping(&mapping)) return false;
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(mapping.base);
+
+    const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    constexpr uint64_t REPORT_STEP = 16ull << 20;  // 每 16MB 回报一次进度
+
+    uint64_t total = 0;
+    for (const auto& region : regions_) {
+        if (!is_random_access(region.name)) total += region.size;
+    }
+
+    uint64_t done = 0;
+    uint64_t next_report = REPORT_STEP;
+    volatile uint8_t sink = 0;
+
+    for (const auto& region : regions_) {
+        if (is_random_access(region.name)) continue;
+
+        // 未映射的片段（llama.cpp 已解除）不触页
+        uint64_t begin = std::max(region.offset, mapping.begin);
+        uint64_t end = std::min(region.offset + region.size, mapping.end);
+        for (uint64_t off = begin; off < end; off += page) {
+            sink = sink + base[off];
+        }
+        done += region.size;
+
+        if (done >= next_report || done == total) {
+            next_report = done + REPORT_STEP;
+            if (on_progress && !on_progress(done, total)) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace pulse
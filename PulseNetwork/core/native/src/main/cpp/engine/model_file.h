@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pulse {
+
+/**
+ * 预取模式
+ *
+ * 与 Kotlin 侧 PrefetchMode 的 ordinal 一一对应
+ */
+enum class PrefetchMode : int {
+    EAGER = 0,  // 加载时按张量顺序预读所有权重页，首 token 无缺页
+    LAZY = 1    // 只设置访问提示，权重页在首次使用时才换入
+};
+
+/**
+ * GGUF 文件中的一个张量数据区
+ */
+struct TensorRegion {
+    std::string name;
+    uint64_t offset;  // 相对文件起始的绝对偏移
+    uint64_t size;
+};
+
+/**
+ * GGUF 模型文件
+ *
+ * 只解析头部得到每个张量的数据区，不持有权重内存：
+ * - 权重由 llama.cpp 自己 mmap（页缓存支撑，不会常驻两份）
+ * - 这里按张量区域对 llama.cpp 的映射施加 madvise 提示并可选地预取
+ */
+class ModelFile {
+public:
+    // 进度回调：已处理字节数 / 总字节数
+    using ProgressFn = std::function<bool(uint64_t done, uint64_t total)>;
+
+    ModelFile() = default;
+    ModelFile(const ModelFile&) = delete;
+    ModelFile& operator=(const ModelFile&) = delete;
+
+    /**
+     * 打开并解析 GGUF 头部
+     * @return 文件不存在或不是合法 GGUF 时返回 false
+     */
+    bool open(const std::string& path);
+
+    const std::string& path() const { return path_; }
+    uint64_t file_size() const { return file_size_; }
+    uint64_t data_offset() const { return data_offset_; }
+    const std::vector<TensorRegion>& regions() const { return regions_; }
+
+    /**
+     * 对本进程中该文件的现有映射（llama.cpp 的 mmap）施加逐张量访问提示
+     *
+     * - token_embd 等按行随机查表的张量：MADV_RANDOM，关闭无用的预读
+     * - 其余逐层顺序使用的权重：EAGER 时 MADV_WILLNEED，LAZY 时 MADV_NORMAL
+     *
+     * @return 找不到映射（例如未启用 mmap）时返回 false
+     */
+    bool apply_hints(PrefetchMode mode) const;
+
+    /**
+     * 按文件顺序逐张量触页，把权重预读进页缓存
+     * 回调返回 false 时中止
+     */
+    bool prefetch(const ProgressFn& on_progress) const;
+
+private:
+    bool parse(const uint8_t* data, size_t size);
+    /**
+     * llama.cpp 加载后会解除首尾未用的片段，剩下的映射偏移不为 0，
+     * 所以用 base 表示文件偏移 0 对应的地址，[begin, end) 为实际映射的文件区间
+     */
+    struct Mapping {
+        uintptr_t base;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    bool find_mapping(Mapping* mapping) const;
+
+    std::string path_;
+    uint64_t file_size_ = 0;
+    uint64_t data_offset_ = 0;
+    std::vector<TensorRegion> regions_;
+};
+
+} // namespace pulse
@@ -0,0 +1,250 @@
+#include "model_registry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace pulse {
+
+namespace {
+
+// 加载新模型时为系统保留的余量
+constexpr uint64_t SYSTEM_HEADROOM_BYTES = 256ull << 20;
+
+uint64_t read_meminfo_kb(const char* field) {
+    FILE* fp = fopen("/proc/meminfo", "r");
+    if (!fp) return 0;
+
+    char line[256];
+    char name[64];
+    unsigned long long value = 0;
+    uint64_t result = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%63[^:]: %llu kB", name, &value) == 2 && strcmp(name, field) == 0) {
+            result = value;
+            break;
+        }
+    }
+    fclose(fp);
+    return result;
+}
+
+} // namespace
+
+ModelRegistry& ModelRegistry::instance() {
+    static ModelRegistry registry;
+    return registry;
+}
+
+void ModelRegistry::set_budget(uint64_t bytes) {
+    Released released;  // 先于锁声明，锁释放后才析构
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = bytes;
+    trim_locked(effective_budget_locked(), "", released);
+}
+
+uint64_t ModelRegistry::budget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return effective_budget_locked();
+}
+
+uint64_t ModelRegistry::resident_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return resident_bytes_locked();
+}
+
+std::shared_ptr<ResidentModel> ModelRegistry::get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        if (entry.key == key) {
+            entry.last_used = ++clock_;
+            return entry.model;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<ResidentModel> ModelRegistry::active(ModelKind kind) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : entries_) {
+        if (entry.active && entry.model->kind() == kind) return entry.model;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<ResidentModel> ModelRegistry::activate(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&](const Entry& e) { return e.key == key; });
+    if (it == entries_.end()) return nullptr;
+
+    set_active_locked(it);
+    it->last_used = ++clock_;
+    return it->model;
+}
+
+bool ModelRegistry::reserve(uint64_t incoming_bytes) {
+    Released released;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    uint64_t budget = effective_budget_locked();
+    uint64_t target = budget > incoming_bytes ? budget - incoming_bytes : 0;
+
+    // 同时考虑系统实际可用内存，预算之外的进程也在用内存
+    uint64_t available = available_memory_bytes();
+    uint64_t needed = incoming_bytes + SYSTEM_HEADROOM_BYTES;
+    if (available > 0 && available < needed) {
+        uint64_t resident = resident_bytes_locked();
+        uint64_t shortfall = needed - available;
+        target = std::min(target, resident > shortfall ? resident - shortfall : 0);
+    }
+
+    trim_locked(target, "", released);
+    return resident_bytes_locked() + incoming_bytes <= budget;
+}
+
+void ModelRegistry::put(const std::string& key, std::shared_ptr<ResidentModel> model, bool make_active) {
+    Released released;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&](const Entry& e) { return e.key == key; });
+    if (it != entries_.end()) {
+        released.push_back(std::move(it->model));
+        it->model = std::move(model);
+        it->last_used = ++clock_;
+    } else {
+        entries_.push_back(Entry{key, std::move(model), ++clock_, false});
+        it = entries_.end() - 1;
+    }
+    if (make_active) set_active_locked(it);
+
+    trim_locked(effective_budget_locked(), key, released);
+}
+
+bool ModelRegistry::evict(const std::string& key) {
+    std::shared_ptr<ResidentModel> released;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(entries_.begin(), entries_.end(),
+                               [&](const Entry& e) { return e.key == key; });
+        if (it == entries_.end()) return false;
+        released = std::move(it->model);
+        entries_.erase(it);
+    }
+    // 在锁外析构，释放大模型可能耗时
+    return true;
+}
+
+bool ModelRegistry::evict_active(ModelKind kind) {
+    std::shared_ptr<ResidentModel> released;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(entries_.begin(), entries_.end(),
+                               [&](const Entry& e) { return e.active && e.model->kind() == kind; });
+        if (it == entries_.end()) return false;
+        released = std::move(it->model);
+        entries_.erase(it);
+    }
+    return true;
+}
+
+uint64_t ModelRegistry::trim_to(uint64_t target_bytes) {
+    Released released;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return trim_locked(target_bytes, "", released);
+}
+
+uint64_t ModelRegistry::on_memory_pressure(TrimLevel level) {
+    Released released;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    switch (level) {
+        case TrimLevel::MODERATE:
+            return trim_locked(effective_budget_locked() / 4 * 3, "", released);
+        case TrimLevel::LOW: {
+            auto mru = std::max_element(entries_.begin(), entries_.end(),
+                [](const Entry& a, const Entry& b) { return a.last_used < b.last_used; });
+            std::string keep = mru != entries_.end() ? mru->key : "";
+            return trim_locked(0, keep, released);
+        }
+        case TrimLevel::CRITICAL:
+            return trim_locked(0, "", released);
+    }
+    return 0;
+}
+
+std::vector<ResidentModelInfo> ModelRegistry::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<ResidentModelInfo> result;
+    result.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+        result.push_back(ResidentModelInfo{
+            entry.key,
+            entry.model->kind(),
+            entry.model->memory_bytes(),
+            entry.last_used,
+            entry.active || entry.model.use_count() > 1
+        });
+    }
+    std::sort(result.begin(), result.end(),
+              [](const ResidentModelInfo& a, const ResidentModelInfo& b) { return a.last_used > b.last_used; });
+    return result;
+}
+
+uint64_t ModelRegistry::available_memory_bytes() {
+    return read_meminfo_kb("MemAvailable") * 1024;
+}
+
+uint64_t ModelRegistry::total_memory_bytes() {
+    return read_meminfo_kb("MemTotal") * 1024;
+}
+
+// ========== 私有方法 ==========
+
+uint64_t ModelRegistry::effective_budget_locked() const {
+    return budget_ > 0 ? budget_ : total_memory_bytes() / 2;
+}
+
+uint64_t ModelRegistry::resident_bytes_locked() const {
+    uint64_t total = 0;
+    for (const auto& entry : entries_) total += entry.model->memory_bytes();
+    return total;
+}
+
+void ModelRegistry::set_active_locked(std::vector<Entry>::iterator entry) {
+    ModelKind kind = entry->model->kind();
+    for (auto& other : entries_) {
+        if (other.model->kind() == kind) other.active = false;
+    }
+    entry->active = true;
+}
+
+uint64_t ModelRegistry::trim_locked(uint64_t target_bytes, const std::string& keep, Released& released) {
+    uint64_t before = resident_bytes_locked();
+    uint64_t resident = before;
+
+    // 正在使用的模型淘汰了也不会立即释放内存，只淘汰空闲模型
+    while (resident > target_bytes && evict_lru_locked(keep, released)) {
+        resident = resident_bytes_locked();
+    }
+    return before - resident;
+}
+
+bool ModelRegistry::evict_lru_locked(const std::string& keep, Released& released) {
+    auto victim = entries_.end();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->key == keep) continue;
+        if (it->model.use_count() > 1) continue;
+        if (it->active) continue;
+        if (victim == entries_.end() || it->last_used < victim->last_used) victim = it;
+    }
+    if (victim == entries_.end()) return false;
+
+    released.push_back(std::move(victim->model));
+    entries_.erase(victim);
+    return true;
+}
+
+} // namespace pulse
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pulse {
+
+/**
+ * 常驻模型类型，与 Kotlin 侧 ResidentModelInfo.kind 对应
+ */
+enum class ModelKind : int {
+    LLAMA = 0,
+    WHISPER = 1
+};
+
+/**
+ * 内存压力等级，与 Kotlin 侧 MemoryTrimLevel 的 ordinal 对应
+ */
+enum class TrimLevel : int {
+    MODERATE = 0,  // 收缩到预算的 3/4
+    LOW = 1,       // 只保留最近使用的一个模型
+    CRITICAL = 2   // 释放所有未在使用中的模型
+};
+
+/**
+ * 可被注册表管理的常驻模型
+ *
+ * 析构即释放底层资源；正在使用的模型由调用方持有 shared_ptr，
+ * 被淘汰后会在最后一个使用者释放时才真正析构
+ */
+class ResidentModel {
+public:
+    virtual ~ResidentModel() = default;
+    virtual ModelKind kind() const = 0;
+    virtual uint64_t memory_bytes() const = 0;
+};
+
+/**
+ * 常驻模型快照信息
+ */
+struct ResidentModelInfo {
+    std::string key;
+    ModelKind kind;
+    uint64_t memory_bytes;
+    uint64_t last_used;
+    bool in_use;  // 当前模型或正在被使用，不会被 LRU 淘汰
+};
+
+/**
+ * 多模型常驻注册表
+ *
+ * - 在内存预算内同时保留多个 GGUF / whisper 模型，切换时无需重新加载
+ * - 预算不足或系统内存压力时按 LRU 淘汰，优先淘汰未在使用中的模型
+ * - 每种类型有一个当前模型，由注册表持有，不参与 LRU 淘汰，只能显式卸载
+ * - 预算为 0 时自动取物理内存的一半
+ * - 被淘汰的模型总在锁外析构，释放大模型可能耗时
+ */
+class ModelRegistry {
+public:
+    static ModelRegistry& instance();
+
+    void set_budget(uint64_t bytes);
+    uint64_t budget() const;
+    uint64_t resident_bytes() const;
+
+    /**
+     * 查找并标记为最近使用
+     */
+    std::shared_ptr<ResidentModel> get(const std::string& key);
+
+    template <typename T>
+    std::shared_ptr<T> get_as(const std::string& key) {
+        return std::dynamic_pointer_cast<T>(get(key));
+    }
+
+    /**
+     * 该类型的当前模型，没有时返回 nullptr
+     */
+    std::shared_ptr<ResidentModel> active(ModelKind kind) const;
+
+    template <typename T>
+    std::shared_ptr<T> active_as(ModelKind kind) const {
+        return std::dynamic_pointer_cast<T>(active(kind));
+    }
+
+    /**
+     * 把已常驻的模型设为其类型的当前模型，同类型原来的当前模型恢复为可淘汰
+     * @return 注册表中没有该模型时返回 nullptr
+     */
+    std::shared_ptr<ResidentModel> activate(const std::string& key);
+
+    /**
+     * 为即将加载的模型腾出空间（在加载之前调用，避免峰值内存叠加）
+     *
+     * 只淘汰非当前模型；要被取代的当前模型留到新模型 put 之后才可淘汰，新模型加载失败时仍可用
+     * @return 淘汰后仍放不下时返回 false，调用方可以照常尝试加载
+     */
+    bool reserve(uint64_t incoming_bytes);
+
+    /**
+     * 注册新加载的模型，必要时淘汰其他模型
+     * @param make_active 同时设为其类型的当前模型
+     */
+    void put(const std::string& key, std::shared_ptr<ResidentModel> model, bool make_active = false);
+
+    bool evict(const std::string& key);
+
+    /**
+     * 卸载该类型的当前模型
+     */
+    bool evict_active(ModelKind kind);
+
+    /**
+     * 按 LRU 淘汰直到常驻量不超过 target_bytes
+     * @return 释放的字节数
+     */
+    uint64_t trim_to(uint64_t target_bytes);
+
+    /**
+     * 响应系统内存压力
+     */
+    uint64_t on_memory_pressure(TrimLevel level);
+
+    std::vector<ResidentModelInfo> snapshot() const;
+
+    /**
+     * /proc/meminfo 中的 MemAvailable / MemTotal（字节）
+     */
+    static uint64_t available_memory_bytes();
+    static uint64_t total_memory_bytes();
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<ResidentModel> model;
+        uint64_t last_used;
+        bool active;
+    };
+
+    // 被淘汰的模型先移到这里，调用方在释放锁之后再析构
+    using Released = std::vector<std::shared_ptr<ResidentModel>>;
+
+    ModelRegistry() = default;
+
+    uint64_t effective_budget_locked() const;
+    uint64_t resident_bytes_locked() const;
+    void set_active_locked(std::vector<Entry>::iterator entry);
+    uint64_t trim_locked(uint64_t target_bytes, const std::string& keep, Released& released);
+    bool evict_lru_locked(const std::string& keep, Released& released);
+
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+    uint64_t budget_ = 0;
+    uint64_t clock_ = 0;
+};
+
+} // namespace pulse
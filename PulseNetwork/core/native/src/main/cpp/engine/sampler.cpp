@@ -0,0 +1,270 @@
+#include "sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace pulse {
+
+namespace {
+
+// 语法约束下贪心采样时先按 logit 顺序检查的候选数
+constexpr int GRAMMAR_GREEDY_PROBE = 64;
+
+// 不做 top-k 时 top-p 首次排序的候选数，不够覆盖 top_p 时倍增
+constexpr size_t TOP_P_WINDOW = 128;
+
+} // namespace
+
+Sampler::Sampler(const SamplingParams& params, const Vocab* vocab, Arena* arena)
+        : params_(params),
+          vocab_(vocab),
+          grammar_enabled_(params.grammar == GrammarMode::JSON && vocab != nullptr),
+          rng_(params.seed == 0xFFFFFFFF ? std::random_device{}() : params.seed),
+          candidates_(ArenaAllocator<Candidate>(arena)),
+          history_(ArenaAllocator<llama_token>(arena)),
+          counts_scratch_(ArenaAllocator<llama_token>(arena)),
+          scratch_(ArenaAllocator<float>(arena)) {
+    // 正 logit 要除以惩罚系数，<= 0（或 NaN）没有意义，按关闭处理
+    if (!(params_.repeat_penalty > 0.0f)) params_.repeat_penalty = 1.0f;
+    if (params_.penalty_last_n > 0) {
+        history_.reserve(params_.penalty_last_n);
+        counts_scratch_.reserve(params_.penalty_last_n);
+    }
+}
+
+bool Sampler::has_history_constraints() const {
+    return grammar_enabled_ ||
+           params_.repeat_penalty != 1.0f ||
+           params_.frequency_penalty != 0.0f ||
+           params_.presence_penalty != 0.0f;
+}
+
+void Sampler::prime(const std::vector<llama_token>& tokens) {
+    const int last_n = params_.penalty_last_n;
+    if (last_n <= 0) return;
+
+    size_t from = tokens.size() > size_t(last_n) ? tokens.size() - last_n : 0;
+    for (size_t i = from; i < tokens.size(); i++) remember(tokens[i]);
+}
+
+llama_token Sampler::sample(const float* logits, int n_vocab) {
+    load_candidates(logits, n_vocab);
+    apply_penalties();
+
+    if (is_greedy()) {
+        if (!grammar_enabled_) {
+            auto best = std::max_element(candidates_.begin(), candidates_.end(),
+                [](const Candidate& a, const Candidate& b) { return a.logit < b.logit; });
+            return best->id;
+        }
+        // 按 logit 从高到低检查，第一个合法的就是约束下的 argmax
+        int probe = std::min<int>(GRAMMAR_GREEDY_PROBE, candidates_.size());
+        std::partial_sort(candidates_.begin(), candidates_.begin() + probe, candidates_.end(),
+            [](const Candidate& a, const Candidate& b) { return a.logit > b.logit; });
+        for (int i = 0; i < probe; i++) {
+            if (grammar_allows(candidates_[i].id)) return candidates_[i].id;
+        }
+        return best_allowed(logits, n_vocab);
+    }
+
+    truncate_and_softmax();
+
+    if (!grammar_enabled_) return candidates_[sample_candidate()].id;
+
+    // 惰性检查：大多数时候第一次抽中的 token 就合法
+    for (size_t attempt = 0; attempt < candidates_.size(); attempt++) {
+        int index = sample_candidate();
+        if (index < 0) break;
+        if (grammar_allows(candidates_[index].id)) return candidates_[index].id;
+        candidates_[index].p = 0.0f;
+    }
+    return best_allowed(logits, n_vocab);
+}
+
+void Sampler::accept(llama_token token) {
+    remember(token);
+    if (grammar_enabled_ && !vocab_->is_eog[token]) {
+        grammar_.advance(vocab_->pieces[token]);
+    }
+}
+
+void Sampler::distribution(const float* logits, int n_vocab, std::vector<float>& probs) {
+    probs.assign(n_vocab, 0.0f);
+
+    if (is_greedy()) {
+        int best = static_cast<int>(std::max_element(logits, logits + n_vocab) - logits);
+        probs[best] = 1.0f;
+        return;
+    }
+
+    load_candidates(logits, n_vocab);
+    truncate_and_softmax();
+
+    float sum = 0.0f;
+    for (const auto& c : candidates_) sum += c.p;
+    for (const auto& c : candidates_) probs[c.id] = c.p / sum;
+}
+
+llama_token Sampler::sample(const std::vector<float>& probs) {
+    return sample_dense(probs.data(), probs.size());
+}
+
+llama_token Sampler::sample_residual(const std::vector<float>& p, const std::vector<float>& q) {
+    scratch_.resize(p.size());
+    float sum = 0.0f;
+    for (size_t i = 0; i < p.size(); i++) {
+        scratch_[i] = std::max(0.0f, p[i] - q[i]);
+        sum += scratch_[i];
+    }
+    if (sum <= 0.0f) return sample(p);
+    for (auto& v : scratch_) v /= sum;
+    return sample_dense(scratch_.data(), scratch_.size());
+}
+
+float Sampler::uniform() {
+    return std::uniform_real_distribution<float>(0.0f, 1.0f)(rng_);
+}
+
+// ========== 私有方法 ==========
+
+void Sampler::remember(llama_token token) {
+    const int last_n = params_.penalty_last_n;
+    if (last_n <= 0) return;
+    if (history_.size() < size_t(last_n)) {
+        history_.push_back(token);
+    } else {
+        history_[history_pos_] = token;
+        history_pos_ = (history_pos_ + 1) % last_n;
+    }
+}
+
+llama_token Sampler::sample_dense(const float* probs, size_t n) {
+    float r = uniform();
+    float cumulative = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        cumulative += probs[i];
+        if (r < cumulative) return static_cast<llama_token>(i);
+    }
+    // 浮点误差导致累加不足 1 时取最后一个非零项
+    for (size_t i = n; i-- > 0;) {
+        if (probs[i] > 0.0f) return static_cast<llama_token>(i);
+    }
+    return 0;
+}
+
+void Sampler::load_candidates(const float* logits, int n_vocab) {
+    candidates_.resize(n_vocab);
+    for (int i = 0; i < n_vocab; i++) {
+        candidates_[i] = Candidate{i, logits[i], 0.0f};
+    }
+}
+
+void Sampler::apply_penalties() {
+    if (history_.empty()) return;
+    if (params_.repeat_penalty == 1.0f &&
+        params_.frequency_penalty == 0.0f &&
+        params_.presence_penalty == 0.0f) {
+        return;
+    }
+
+    // 窗口很小（默认 64），排序后按游程计数比哈希表更快
+    counts_scratch_.assign(history_.begin(), history_.end());
+    std::sort(counts_scratch_.begin(), counts_scratch_.end());
+
+    for (size_t i = 0; i < counts_scratch_.size();) {
+        llama_token token = counts_scratch_[i];
+        size_t j = i;
+        while (j < counts_scratch_.size() && counts_scratch_[j] == token) j++;
+        int count = static_cast<int>(j - i);
+        i = j;
+
+        if (token < 0 || size_t(token) >= candidates_.size()) continue;
+        float& logit = candidates_[token].logit;
+        // 与 llama.cpp 相同：正 logit 除以惩罚系数，负 logit 乘以惩罚系数
+        logit = logit > 0.0f ? logit / params_.repeat_penalty : logit * params_.repeat_penalty;
+        logit -= count * params_.frequency_penalty + params_.presence_penalty;
+    }
+}
+
+void Sampler::truncate_and_softmax() {
+    auto by_logit = [](const Candidate& a, const Candidate& b) { return a.logit > b.logit; };
+    auto by_logit_asc = [](const Candidate& a, const Candidate& b) { return a.logit < b.logit; };
+
+    size_t n_sorted = 0;
+    if (params_.top_k > 0 && size_t(params_.top_k) < candidates_.size()) {
+        n_sorted = params_.top_k;
+        std::partial_sort(candidates_.begin(), candidates_.begin() + n_sorted, candidates_.end(), by_logit);
+        candidates_.resize(n_sorted);
+    }
+
+    // 不做 top-k 时不排序整个词表，线性扫描取最大值
+    const float max_logit = n_sorted > 0
+        ? candidates_[0].logit
+        : std::max_element(candidates_.begin(), candidates_.end(), by_logit_asc)->logit;
+    const float inv_temp = 1.0f / params_.temperature;
+    float sum = 0.0f;
+    for (auto& c : candidates_) {
+        c.p = std::exp((c.logit - max_logit) * inv_temp);
+        sum += c.p;
+    }
+    for (auto& c : candidates_) c.p /= sum;
+    if (params_.top_p >= 1.0f) return;
+
+    // top-p 按概率降序累加；未排序时逐步扩大有序前缀（nth_element 划分 + 只排前缀），
+    // 通常几百个候选就覆盖了 top_p 的概率质量
+    size_t window = TOP_P_WINDOW;
+    float cumulative = 0.0f;
+    size_t keep = 0;
+    while (keep < candidates_.size()) {
+        if (keep == n_sorted) {
+            auto first = candidates_.begin() + n_sorted;
+            auto last = candidates_.begin() + std::min(candidates_.size(), n_sorted + window);
+            if (last != candidates_.end()) std::nth_element(first, last, candidates_.end(), by_logit);
+            std::sort(first, last, by_logit);
+            n_sorted = last - candidates_.begin();
+            window *= 2;
+        }
+        cumulative += candidates_[keep++].p;
+        if (cumulative >= params_.top_p) break;
+    }
+    candidates_.resize(keep);
+}
+
+int Sampler::sample_candidate() {
+    float sum = 0.0f;
+    for (const auto& c : candidates_) sum += c.p;
+    if (sum <= 0.0f) return -1;
+
+    float r = uniform() * sum;
+    float cumulative = 0.0f;
+    int last_nonzero = -1;
+    for (size_t i = 0; i < candidates_.size(); i++) {
+        if (candidates_[i].p <= 0.0f) continue;
+        last_nonzero = static_cast<int>(i);
+        cumulative += candidates_[i].p;
+        if (r < cumulative) return last_nonzero;
+    }
+    return last_nonzero;
+}
+
+bool Sampler::grammar_allows(llama_token token) const {
+    if (vocab_->is_eog[token]) return grammar_.done();
+    const std::string& piece = vocab_->pieces[token];
+    // 空文本的控制 token 不推进语法，放行会导致原地打转
+    return !piece.empty() && grammar_.accepts(piece);
+}
+
+llama_token Sampler::best_allowed(const float* logits, int n_vocab) const {
+    std::vector<llama_token> order(n_vocab);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [logits](llama_token a, llama_token b) { return logits[a] > logits[b]; });
+    for (llama_token token : order) {
+        if (grammar_allows(token)) return token;
+    }
+    // 不会发生：JSON 任意状态下总有合法的单字符 token
+    return order.front();
+}
+
+} // namespace pulse
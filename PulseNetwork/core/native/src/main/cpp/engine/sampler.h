@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+#include "json_grammar.h"
+#include "llama.h"
+
+namespace pulse {
+
+/**
+ * 输出约束，与 Kotlin 侧 OutputGrammar 的 ordinal 对应
+ */
+enum class GrammarMode : int {
+    NONE = 0,
+    JSON = 1
+};
+
+/**
+ * 采样参数
+ */
+struct SamplingParams {
+    float temperature = 0.7f;
+    float top_p = 0.9f;
+    int top_k = 40;                  // <= 0 表示不截断
+    float repeat_penalty = 1.0f;     // 1.0 表示关闭，<= 0 按 1.0 处理
+    float frequency_penalty = 0.0f;
+    float presence_penalty = 0.0f;
+    int penalty_last_n = 64;         // 惩罚窗口（最近 n 个 token，含提示词）
+    GrammarMode grammar = GrammarMode::NONE;
+    uint32_t seed = 0xFFFFFFFF;      // 0xFFFFFFFF 表示随机种子
+};
+
+/**
+ * 词表视图，语法约束需要按 token 文本判断
+ */
+struct Vocab {
+    std::vector<std::string> pieces;
+    std::vector<uint8_t> is_eog;
+};
+
+/**
+ * 采样器
+ *
+ * 每个 token 的处理链：惩罚 -> top-k（部分排序）-> 温度 + 原地 softmax -> top-p -> 抽样，
+ * 只在截断后的候选上排序和归一化，词表再大每 token 也只是一次线性扫描加 O(k log k)。
+ * 不做 top-k 时 top-p 只排序覆盖 top_p 概率质量的前缀，不排序整个词表。
+ *
+ * 语法约束采用惰性检查：先按分布抽样，被语法拒绝时把该候选概率置零重抽，
+ * 候选全部被拒绝时再扫描整个词表取 logit 最高的合法 token。
+ *
+ * 温度 <= 0 时退化为贪心（argmax 的 one-hot 分布），
+ * 这样推测解码的接受/拒绝规则对贪心和随机采样是同一套实现。
+ *
+ * 传入 arena 时所有内部缓冲区从 arena 分配，首个 token 之后每 token 不再申请内存
+ */
+class Sampler {
+public:
+    /**
+     * @param vocab 启用语法约束时必须提供，需在采样器生命周期内有效
+     * @param arena 可为空；非空时需在采样器生命周期内保持不 reset
+     */
+    explicit Sampler(const SamplingParams& params, const Vocab* vocab = nullptr, Arena* arena = nullptr);
+
+    bool is_greedy() const { return params_.temperature <= 0.0f; }
+
+    /**
+     * 是否启用了依赖生成历史的处理（惩罚或语法约束），
+     * 这类分布无法由推测解码的草稿阶段提前算出
+     */
+    bool has_history_constraints() const;
+
+    /**
+     * 计入惩罚窗口但不推进语法状态（用于提示词）
+     */
+    void prime(const std::vector<llama_token>& tokens);
+
+    /**
+     * 走完整处理链抽取下一个 token
+     */
+    llama_token sample(const float* logits, int n_vocab);
+
+    /**
+     * 确认输出 token：计入惩罚窗口并推进语法状态
+     */
+    void accept(llama_token token);
+
+    /**
+     * 语法约束下顶层 JSON 已闭合
+     */
+    bool grammar_done() const { return grammar_enabled_ && grammar_.done(); }
+
+    /**
+     * 计算 top-k / top-p 截断后的稠密概率分布（长度 n_vocab），供推测解码使用
+     */
+    void distribution(const float* logits, int n_vocab, std::vector<float>& probs);
+
+    /**
+     * 从稠密分布中抽取一个 token
+     */
+    llama_token sample(const std::vector<float>& probs);
+
+    /**
+     * 推测解码被拒绝后的残差采样：从 norm(max(0, p - q)) 中抽取
+     */
+    llama_token sample_residual(const std::vector<float>& p, const std::vector<float>& q);
+
+    /**
+     * [0, 1) 均匀随机数
+     */
+    float uniform();
+
+private:
+    struct Candidate {
+        llama_token id;
+        float logit;
+        float p;
+    };
+
+    void remember(llama_token token);
+    llama_token sample_dense(const float* probs, size_t n);
+    void load_candidates(const float* logits, int n_vocab);
+    void apply_penalties();
+    void truncate_and_softmax();
+    int sample_candidate();
+    bool grammar_allows(llama_token token) const;
+    llama_token best_allowed(const float* logits, int n_vocab) const;
+
+    SamplingParams params_;
+    const Vocab* vocab_;
+    bool grammar_enabled_;
+    JsonGrammar grammar_;
+
+    std::mt19937 rng_;
+    ArenaVector<Candidate> candidates_;
+    ArenaVector<llama_token> history_;   // 环形缓冲，容量 penalty_last_n
+    size_t history_pos_ = 0;
+    ArenaVector<llama_token> counts_scratch_;
+    ArenaVector<float> scratch_;
+};
+
+} // namespace pulse
@@ -0,0 +1,113 @@
+#include "semantic_index.h"
+
+#include <algorithm>
+
+namespace pulse {
+
+SemanticIndex::SemanticIndex(size_t capacity) : capacity_(std::max<size_t>(1, capacity)) {}
+
+void SemanticIndex::set_dimension(int dim) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dim == dim_) return;
+    dim_ = std::max(dim, 0);
+    vectors_.clear();
+    entries_.clear();
+    by_key_.clear();
+}
+
+bool SemanticIndex::add(const std::string& key, uint64_t scope, const float* vector, int dim,
+                        const std::string& answer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (answer.empty()) return false;
+
+    size_t slot;
+    auto it = by_key_.find(key);
+    if (it != by_key_.end()) {
+        slot = it->second;
+    } else {
+        slot = slot_for_insert_locked();
+        by_key_[key] = slot;
+    }
+
+    const bool has_vector = vector && dim > 0 && dim == dim_;
+    if (has_vector) std::copy_n(vector, dim_, vectors_.data() + slot * dim_);
+    entries_[slot] = Entry{key, scope, has_vector, answer, ++clock_};
+    return true;
+}
+
+bool SemanticIndex::find_exact(const std::string& key, std::string& answer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = by_key_.find(key);
+    if (it == by_key_.end()) return false;
+    Entry& entry = entries_[it->second];
+    entry.last_used = ++clock_;
+    answer = entry.answer;
+    return true;
+}
+
+SemanticMatch SemanticIndex::find_nearest(uint64_t scope, const float* vector, int dim, float threshold) {
+    SemanticMatch match;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!vector || dim <= 0 || dim != dim_) return match;
+
+    int best = -1;
+    float best_similarity = threshold;
+    for (size_t i = 0; i < entries_.size(); i++) {
+        if (!entries_[i].has_vector || entries_[i].scope != scope) continue;
+        const float* v = vectors_.data() + i * dim_;
+        float dot = 0.0f;
+        for (int d = 0; d < dim_; d++) dot += v[d] * vector[d];
+        if (dot >= best_similarity) {
+            best_similarity = dot;
+            best = static_cast<int>(i);
+        }
+    }
+    if (best < 0) return match;
+
+    Entry& entry = entries_[best];
+    entry.last_used = ++clock_;
+    match.found = true;
+    match.similarity = best_similarity;
+    match.answer = entry.answer;
+    return match;
+}
+
+bool SemanticIndex::has_vectors(uint64_t scope) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Entry& entry : entries_) {
+        if (entry.has_vector && entry.scope == scope) return true;
+    }
+    return false;
+}
+
+void SemanticIndex::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    vectors_.clear();
+    entries_.clear();
+    by_key_.clear();
+}
+
+size_t SemanticIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+// ========== 私有方法 ==========
+
+size_t SemanticIndex::slot_for_insert_locked() {
+    if (entries_.size() < capacity_) {
+        entries_.emplace_back();
+        vectors_.resize(entries_.size() * dim_);
+        return entries_.size() - 1;
+    }
+
+    // 写满时替换最久未命中的条目，插入只在满时线性扫描一次
+    size_t oldest = 0;
+    for (size_t i = 1; i < entries_.size(); i++) {
+        if (entries_[i].last_used < entries_[oldest].last_used) oldest = i;
+    }
+    by_key_.erase(entries_[oldest].key);
+    return oldest;
+}
+
+} // namespace pulse
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pulse {
+
+/**
+ * 相似问题查询结果
+ */
+struct SemanticMatch {
+    bool found = false;
+    float similarity = 0.0f;
+    std::string answer;
+};
+
+/**
+ * 对话回答的原生索引
+ *
+ * 精确键由调用方构造，需包含生成回答时的完整上下文（见 LlamaSession::chat）；
+ * 相似查询只在同一 scope（问题之前的上下文哈希）内比较问题嵌入，
+ * 同一问题在不同对话中的回答互不命中。
+ * 向量在写入时归一化并连续存放，查询是一次 n × dim 的点积扫描（千级条目约 1 ms）。
+ * 写满后替换最久未命中的条目
+ */
+class SemanticIndex {
+public:
+    explicit SemanticIndex(size_t capacity = 1024);
+
+    /**
+     * 设置向量维度（嵌入模型的 n_embd），维度变化时清空索引
+     */
+    void set_dimension(int dim);
+
+    /**
+     * @param vector 问题嵌入，为空或维度不符时条目只参与精确匹配
+     * @return 回答为空时返回 false
+     */
+    bool add(const std::string& key, uint64_t scope, const float* vector, int dim, const std::string& answer);
+
+    bool find_exact(const std::string& key, std::string& answer);
+
+    /**
+     * 同一 scope 内余弦相似度最高且不低于 threshold 的条目
+     * @param vector 已归一化的问题嵌入
+     */
+    SemanticMatch find_nearest(uint64_t scope, const float* vector, int dim, float threshold);
+
+    /**
+     * 同一 scope 内是否有带嵌入的条目，没有时不必为相似查询计算嵌入
+     */
+    bool has_vectors(uint64_t scope) const;
+
+    void clear();
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t scope;
+        bool has_vector;
+        std::string answer;
+        uint64_t last_used;
+    };
+
+    size_t slot_for_insert_locked();
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    int dim_ = 0;
+    std::vector<float> vectors_;   // entries_.size() × dim_，已归一化
+    std::vector<Entry> entries_;
+    std::unordered_map<std::string, size_t> by_key_;
+    uint64_t clock_ = 0;
+};
+
+} // namespace pulse
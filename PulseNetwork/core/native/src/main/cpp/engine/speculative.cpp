@@ -0,0 +1,167 @@
+#include "speculative.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "llama_session.h"
+#include "throttle.h"
+
+namespace pulse {
+
+namespace {
+
+void batch_clear(llama_batch& batch) {
+    batch.n_tokens = 0;
+}
+
+void batch_add(llama_batch& batch, llama_token token, llama_pos pos, bool logits) {
+    int i = batch.n_tokens++;
+    batch.token[i] = token;
+    batch.pos[i] = pos;
+    batch.n_seq_id[i] = 1;
+    batch.seq_id[i][0] = 0;
+    batch.logits[i] = logits;
+}
+
+} // namespace
+
+SpeculativeDecoder::SpeculativeDecoder(llama_context* target, llama_context* draft, int n_draft)
+        : target_(target), draft_(draft), n_draft_(std::max(1, n_draft)) {}
+
+SpeculativeResult SpeculativeDecoder::generate(const std::vector<llama_token>& prompt,
+                                 int max_tokens,
+                                 Sampler& sampler,
+                                 const EmitFn& emit,
+                                 SpeculativeStats& stats,
+                                 const CancelToken* cancel) {
+    SpeculativeResult result;
+    if (prompt.empty() || max_tokens <= 0) return result;
+
+    const llama_model* model = llama_get_model(target_);
+    const int n_vocab = llama_n_vocab(model);
+    const int n_ctx = static_cast<int>(std::min(llama_n_ctx(target_), llama_n_ctx(draft_)));
+    // 取消导致的中断不算出错
+    auto failed = [cancel] { return !(cancel && cancel->should_stop()); };
+
+    // 除最后一个 token 外先写入两侧 KV，最后一个 token 作为第一轮的输入
+    auto prefill_start = std::chrono::steady_clock::now();
+    const int n_prefix = static_cast<int>(prompt.size()) - 1;
+    if (!decode_tokens(target_, prompt.data(), n_prefix, 0, cancel) ||
+        !decode_tokens(draft_, prompt.data(), n_prefix, 0, cancel)) {
+        result.ok = !failed();
+        return result;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    result.prefill_ms = std::chrono::duration<double, std::milli>(start - prefill_start).count();
+
+    int n_past = n_prefix;          // 主模型 KV 中已确认的 token 数
+    int draft_n_past = n_prefix;    // 草稿模型 KV 中已确认的 token 数
+    llama_token id_last = prompt.back();
+    std::vector<llama_token> draft_pending{id_last};  // 草稿模型尚未见过的已确认 token
+
+    std::vector<llama_token> drafts;
+    std::vector<std::vector<float>> q(n_draft_);
+    std::vector<std::vector<float>> p(n_draft_ + 1);
+    llama_batch batch = llama_batch_init(n_draft_ + 1, 0, 1);
+
+    int n_generated = 0;
+    bool done = false;
+
+    while (!done && n_generated < max_tokens) {
+        if (cancel && cancel->should_stop()) break;
+        const int k_max = std::min(n_draft_, max_tokens - n_generated - 1);
+        if (n_past + k_max + 1 >= n_ctx) break;
+
+        // ---- 草稿阶段：逐个提出 k 个 token ----
+        drafts.clear();
+        if (k_max > 0) {
+            if (!decode_tokens(draft_, draft_pending.data(),
+                               static_cast<int>(draft_pending.size()), draft_n_past, cancel)) {
+                result.ok = !failed();
+                break;
+            }
+            draft_n_past += static_cast<int>(draft_pending.size());
+
+            for (int i = 0; i < k_max; i++) {
+                sampler.distribution(llama_get_logits_ith(draft_, -1), n_vocab, q[i]);
+                llama_token token = sampler.sample(q[i]);
+                drafts.push_back(token);
+                if (llama_token_is_eog(model, token) || i + 1 == k_max) break;
+                if (!decode_tokens(draft_, &token, 1, draft_n_past + i)) break;
+            }
+        }
+        const int k = static_cast<int>(drafts.size());
+
+        // ---- 验证阶段：主模型一次前向处理 [id_last, d1..dk] ----
+        batch_clear(batch);
+        batch_add(batch, id_last, n_past, true);
+        for (int i = 0; i < k; i++) batch_add(batch, drafts[i], n_past + 1 + i, true);
+        if (llama_decode(target_, batch) != 0) {
+            result.ok = !failed();
+            break;
+        }
+        stats.target_passes++;
+        stats.drafted += k;
+
+        int accepted = 0;
+        llama_token next = -1;
+        for (int i = 0; i < k; i++) {
+            sampler.distribution(llama_get_logits_ith(target_, i), n_vocab, p[i]);
+            llama_token token = drafts[i];
+            float ratio = p[i][token] / q[i][token];
+            if (sampler.uniform() < ratio) {
+                accepted++;
+                n_generated++;
+                if (!emit(token) || llama_token_is_eog(model, token)) {
+                    done = true;
+                    break;
+                }
+            } else {
+                next = sampler.sample_residual(p[i], q[i]);
+                break;
+            }
+        }
+        stats.accepted += accepted;
+
+        if (!done && next < 0) {
+            // 全部接受，用最后一个位置的分布多采一个 token
+            sampler.distribution(llama_get_logits_ith(target_, k), n_vocab, p[k]);
+            next = sampler.sample(p[k]);
+        }
+
+        // ---- 回滚两侧 KV 中被拒绝的部分 ----
+        const int n_past_old = n_past;
+        n_past += 1 + accepted;
+        llama_kv_cache_seq_rm(target_, 0, n_past, -1);
+
+        if (k == 0) {
+            // 本轮没有起草，草稿模型的待处理 token 原样保留
+        } else if (accepted == k) {
+            // 草稿模型只解码到 d(k-1)，dk 留到下一轮补上
+            draft_n_past = n_past_old + k;
+            draft_pending.assign({drafts[k - 1]});
+        } else {
+            draft_n_past = n_past;
+            draft_pending.clear();
+        }
+        llama_kv_cache_seq_rm(draft_, 0, draft_n_past, -1);
+
+        if (done) break;
+
+        n_generated++;
+        if (!emit(next) || llama_token_is_eog(model, next)) break;
+        id_last = next;
+        draft_pending.push_back(id_last);
+        Throttle::instance().pause_between_tokens();
+    }
+
+    llama_batch_free(batch);
+
+    stats.generated += n_generated;
+    stats.decode_ms += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    result.n_generated = n_generated;
+    return result;
+}
+
+} // namespace pulse
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "cancel_token.h"
+#include "llama.h"
+#include "sampler.h"
+
+namespace pulse {
+
+/**
+ * 推测解码统计
+ */
+struct SpeculativeStats {
+    uint64_t drafted = 0;        // 草稿模型提出的 token 数
+    uint64_t accepted = 0;       // 被主模型接受的草稿 token 数
+    uint64_t generated = 0;      // 实际输出的 token 数
+    uint64_t target_passes = 0;  // 主模型前向次数
+    double decode_ms = 0.0;
+
+    double acceptance_rate() const {
+        return drafted > 0 ? double(accepted) / double(drafted) : 0.0;
+    }
+
+    double tokens_per_second() const {
+        return decode_ms > 0.0 ? generated * 1000.0 / decode_ms : 0.0;
+    }
+
+    // 每次主模型前向产出的 token 数，即相对逐 token 解码的理想加速比
+    double tokens_per_pass() const {
+        return target_passes > 0 ? double(generated) / double(target_passes) : 0.0;
+    }
+};
+
+/**
+ * 一次推测解码的结果
+ */
+struct SpeculativeResult {
+    bool ok = true;              // 预填充或解码出错时为 false（取消不算出错）
+    int n_generated = 0;
+    double prefill_ms = 0.0;
+};
+
+/**
+ * 推测解码器
+ *
+ * 小草稿模型先逐个提出 k 个 token，主模型一次批量前向验证全部 k 个位置：
+ * 以 min(1, p/q) 的概率接受草稿 token，第一次拒绝时从 norm(max(0, p - q)) 重新采样，
+ * 全部接受时再从主模型最后一个位置多采一个 token。
+ * 输出分布与只用主模型采样完全一致。
+ */
+class SpeculativeDecoder {
+public:
+    // 返回 false 时停止生成
+    using EmitFn = std::function<bool(llama_token)>;
+
+    SpeculativeDecoder(llama_context* target, llama_context* draft, int n_draft);
+
+    /**
+     * 两个上下文的 KV cache 需为空；每轮起草之前检查取消令牌
+     *
+     * stats.decode_ms 只计逐 token 阶段，预填充耗时单独放在结果里
+     */
+    SpeculativeResult generate(const std::vector<llama_token>& prompt,
+                 int max_tokens,
+                 Sampler& sampler,
+                 const EmitFn& emit,
+                 SpeculativeStats& stats,
+                 const CancelToken* cancel = nullptr);
+
+private:
+    llama_context* target_;
+    llama_context* draft_;
+    int n_draft_;
+};
+
+} // namespace pulse
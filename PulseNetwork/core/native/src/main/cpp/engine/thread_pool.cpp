@@ -0,0 +1,81 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <android/log.h>
+
+#include "cpu_topology.h"
+
+#define LOG_TAG "PulseNative"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace pulse {
+
+namespace {
+
+// 解码每个 token 之间间隔很短，工作线程先自旋一会儿再休眠，减少唤醒延迟
+constexpr uint32_t DECODE_POLL = 50;
+// 预填充之间通常隔着用户输入，直接休眠
+constexpr uint32_t PREFILL_POLL = 0;
+
+ggml_threadpool* new_pool(int n_threads, const CpuTopology& topo, bool pin, uint32_t poll) {
+    ggml_threadpool_params params = ggml_threadpool_params_default(n_threads);
+    params.poll = poll;
+
+    if (pin && topo.heterogeneous()) {
+        std::fill(std::begin(params.cpumask), std::end(params.cpumask), false);
+        for (int cpu : topo.performance) {
+            if (cpu < GGML_MAX_N_THREADS) params.cpumask[cpu] = true;
+        }
+        // 线程依次占用掩码中的核，每个线程固定一个核
+        params.strict_cpu = true;
+    }
+
+    return ggml_threadpool_new(&params);
+}
+
+} // namespace
+
+std::unique_ptr<InferenceThreadPool> InferenceThreadPool::create(const ThreadConfig& config) {
+    const CpuTopology& topo = CpuTopology::get();
+
+    std::unique_ptr<InferenceThreadPool> pool(new InferenceThreadPool());
+    pool->decode_threads_ = config.decode_threads > 0
+                            ? config.decode_threads
+                            : topo.recommended_decode_threads();
+    pool->prefill_threads_ = config.prefill_threads > 0
+                             ? config.prefill_threads
+                             : topo.recommended_prefill_threads();
+
+    // 绑核时线程数超过性能核数会让多个线程挤在同一个核上
+    if (config.pin_to_performance_cores && topo.heterogeneous()) {
+        int n_perf = static_cast<int>(topo.performance.size());
+        pool->decode_threads_ = std::min(pool->decode_threads_, n_perf);
+        pool->prefill_threads_ = std::min(pool->prefill_threads_, n_perf);
+    }
+
+    pool->decode_ = new_pool(pool->decode_threads_, topo, config.pin_to_performance_cores, DECODE_POLL);
+    pool->prefill_ = new_pool(pool->prefill_threads_, topo, config.pin_to_performance_cores, PREFILL_POLL);
+    if (!pool->decode_ || !pool->prefill_) {
+        LOGE("Failed to create inference thread pools");
+        return nullptr;
+    }
+
+    LOGI("Thread pools: decode %d, prefill %d, %zu performance / %zu efficiency cores, pinned: %d",
+         pool->decode_threads_, pool->prefill_threads_,
+         topo.performance.size(), topo.efficiency.size(),
+         config.pin_to_performance_cores && topo.heterogeneous());
+    return pool;
+}
+
+InferenceThreadPool::~InferenceThreadPool() {
+    if (decode_) ggml_threadpool_free(decode_);
+    if (prefill_) ggml_threadpool_free(prefill_);
+}
+
+void InferenceThreadPool::attach(llama_context* ctx) const {
+    llama_set_n_threads(ctx, decode_threads_, prefill_threads_);
+    llama_attach_threadpool(ctx, decode_, prefill_);
+}
+
+} // namespace pulse
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+
+#include "llama.h"
+
+namespace pulse {
+
+/**
+ * 推理线程配置，线程数 <= 0 时按 CPU 拓扑自动选择
+ */
+struct ThreadConfig {
+    int decode_threads = 0;
+    int prefill_threads = 0;
+    bool pin_to_performance_cores = true;
+};
+
+/**
+ * 常驻推理线程池
+ *
+ * 预填充和解码各一组 ggml 线程池，创建后随模型常驻，每次 llama_decode 复用同一批线程，
+ * 不再每个计算图都创建/销毁线程。开启绑核时每个线程固定在一个性能核上，
+ * 避免解码线程被调度到小核拖慢整步（一步的耗时由最慢的线程决定）
+ */
+class InferenceThreadPool {
+public:
+    static std::unique_ptr<InferenceThreadPool> create(const ThreadConfig& config);
+
+    ~InferenceThreadPool();
+
+    InferenceThreadPool(const InferenceThreadPool&) = delete;
+    InferenceThreadPool& operator=(const InferenceThreadPool&) = delete;
+
+    /**
+     * 挂到上下文上：单 token 解码走解码池，批量预填充走预填充池
+     */
+    void attach(llama_context* ctx) const;
+
+    int decode_threads() const { return decode_threads_; }
+    int prefill_threads() const { return prefill_threads_; }
+
+private:
+    InferenceThreadPool() = default;
+
+    ggml_threadpool* decode_ = nullptr;
+    ggml_threadpool* prefill_ = nullptr;
+    int decode_threads_ = 0;
+    int prefill_threads_ = 0;
+};
+
+} // namespace pulse
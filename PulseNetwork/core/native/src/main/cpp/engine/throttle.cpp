@@ -0,0 +1,33 @@
+#include "throttle.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace pulse {
+
+namespace {
+
+// 单次休眠上限，避免错误参数让生成看起来卡死
+constexpr int MAX_TOKEN_DELAY_MS = 1000;
+
+} // namespace
+
+Throttle& Throttle::instance() {
+    static Throttle throttle;
+    return throttle;
+}
+
+void Throttle::set(int max_threads, int token_delay_ms, int max_batch) {
+    max_threads_.store(std::max(0, max_threads), std::memory_order_relaxed);
+    token_delay_ms_.store(std::clamp(token_delay_ms, 0, MAX_TOKEN_DELAY_MS), std::memory_order_relaxed);
+    max_batch_.store(std::max(0, max_batch), std::memory_order_relaxed);
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+void Throttle::pause_between_tokens() const {
+    int delay = token_delay_ms();
+    if (delay > 0) std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+}
+
+} // namespace pulse
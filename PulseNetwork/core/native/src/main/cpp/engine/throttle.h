@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace pulse {
+
+/**
+ * 运行时推理限流参数
+ *
+ * 由 Kotlin 侧根据温度、电量实时下发，进行中的生成在下一个 token 生效：
+ * - max_threads：解码/预填充线程上限（不超过线程池大小），0 表示不限
+ * - token_delay_ms：每个 token（推测解码为每轮）之后的休眠，给 SoC 降温留出空闲
+ * - max_batch：预填充每次 llama_decode 的最大 token 数，0 表示用上下文的 n_batch
+ *
+ * 参数只会整体替换，读取方通过 version() 判断是否需要重新应用线程数
+ */
+class Throttle {
+public:
+    static Throttle& instance();
+
+    void set(int max_threads, int token_delay_ms, int max_batch);
+
+    int max_threads() const { return max_threads_.load(std::memory_order_relaxed); }
+    int token_delay_ms() const { return token_delay_ms_.load(std::memory_order_relaxed); }
+    int max_batch() const { return max_batch_.load(std::memory_order_relaxed); }
+    uint32_t version() const { return version_.load(std::memory_order_acquire); }
+
+    /**
+     * 按 token_delay_ms 休眠
+     */
+    void pause_between_tokens() const;
+
+private:
+    Throttle() = default;
+
+    std::atomic<int> max_threads_{0};
+    std::atomic<int> token_delay_ms_{0};
+    std::atomic<int> max_batch_{0};
+    std::atomic<uint32_t> version_{0};
+};
+
+} // namespace pulse
@@ -0,0 +1,72 @@
+#include "token_cache.h"
+
+namespace pulse {
+
+TokenCache::TokenCache(size_t capacity, size_t max_text_bytes)
+        : capacity_(capacity), max_text_bytes_(max_text_bytes) {}
+
+std::vector<llama_token> TokenCache::get(const std::string& text, bool add_special,
+                                         const TokenizeFn& tokenize) {
+    if (text.size() > max_text_bytes_) return tokenize(text, add_special);
+
+    const uint64_t key = hash(text, add_special);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end() && it->second->add_special == add_special && it->second->text == text) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            hits_++;
+            return it->second->tokens;
+        }
+        misses_++;
+    }
+
+    // 分词不持锁，并发的不同文本互不阻塞；同一文本并发未命中时后写入者覆盖
+    std::vector<llama_token> tokens = tokenize(text, add_special);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    lru_.push_front(Entry{key, text, add_special, tokens});
+    index_[key] = lru_.begin();
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+    return tokens;
+}
+
+void TokenCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+}
+
+uint64_t TokenCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+uint64_t TokenCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+// ========== 私有方法 ==========
+
+uint64_t TokenCache::hash(const std::string& text, bool add_special) {
+    // FNV-1a 64 位
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : text) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    h ^= add_special ? 1 : 0;
+    h *= 1099511628211ull;
+    return h;
+}
+
+} // namespace pulse
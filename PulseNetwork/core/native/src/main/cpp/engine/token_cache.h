@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "llama.h"
+
+namespace pulse {
+
+/**
+ * 分词结果 LRU 缓存
+ *
+ * 系统提示词、模板片段等反复出现的文本只分词一次；
+ * 按文本哈希索引，命中时再比对原文，哈希冲突不会返回错误结果。
+ * 超长文本（一次性的用户输入、文档）不进入缓存，避免挤掉高频片段
+ */
+class TokenCache {
+public:
+    using TokenizeFn = std::function<std::vector<llama_token>(const std::string& text, bool add_special)>;
+
+    explicit TokenCache(size_t capacity = 256, size_t max_text_bytes = 8192);
+
+    /**
+     * 查缓存，未命中时调用 tokenize 并写入缓存
+     */
+    std::vector<llama_token> get(const std::string& text, bool add_special, const TokenizeFn& tokenize);
+
+    void clear();
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    struct Entry {
+        uint64_t key;
+        std::string text;
+        bool add_special;
+        std::vector<llama_token> tokens;
+    };
+
+    static uint64_t hash(const std::string& text, bool add_special);
+
+    const size_t capacity_;
+    const size_t max_text_bytes_;
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;   // 最近使用的在前
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+} // namespace pulse
@@ -0,0 +1,34 @@
+#include "whisper_model.h"
+
+#include <sys/stat.h>
+#include <android/log.h>
+
+#define LOG_TAG "PulseNative"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace pulse {
+
+std::shared_ptr<WhisperModel> WhisperModel::load(const std::string& path) {
+    std::shared_ptr<WhisperModel> result(new WhisperModel());
+    result->path_ = path;
+    result->ctx_ = whisper_init_from_file_with_params(path.c_str(), whisper_context_default_params());
+    if (!result->ctx_) {
+        LOGE("Failed to load whisper model: %s", path.c_str());
+        return nullptr;
+    }
+    result->memory_bytes_ = estimate_bytes(path);
+    return result;
+}
+
+uint64_t WhisperModel::estimate_bytes(const std::string& path) {
+    struct stat st {};
+    return stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+
+WhisperModel::~WhisperModel() {
+    if (ctx_) whisper_free(ctx_);
+    LOGI("Whisper model released: %s", path_.c_str());
+}
+
+} // namespace pulse
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "whisper.h"
+#include "model_registry.h"
+
+namespace pulse {
+
+/**
+ * 已加载的 whisper 模型
+ */
+class WhisperModel : public ResidentModel {
+public:
+    static std::shared_ptr<WhisperModel> load(const std::string& path);
+
+    /**
+     * 加载前预估内存占用（约等于模型文件大小）
+     */
+    static uint64_t estimate_bytes(const std::string& path);
+
+    ~WhisperModel() override;
+
+    ModelKind kind() const override { return ModelKind::WHISPER; }
+    uint64_t memory_bytes() const override { return memory_bytes_; }
+
+    whisper_context* context() const { return ctx_; }
+    const std::string& path() const { return path_; }
+
+private:
+    WhisperModel() = default;
+
+    whisper_context* ctx_ = nullptr;
+    std::string path_;
+    uint64_t memory_bytes_ = 0;
+};
+
+} // namespace pulse
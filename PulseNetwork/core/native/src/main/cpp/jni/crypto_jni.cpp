@@ -0,0 +1,182 @@
+#include <jni.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <android/log.h>
+
+#include "aes_gcm.h"
+
+#define LOG_TAG "PulseNative"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// 密钥句柄：展开后的轮密钥只留在 native 内存里，Kotlin 侧只持有句柄
+static std::mutex g_keys_mutex;
+static std::unordered_map<jlong, std::shared_ptr<pulse::AesGcm>> g_keys;
+static jlong g_next_key = 1;
+
+static std::shared_ptr<pulse::AesGcm> find_key(JNIEnv* env, jlong handle) {
+    {
+        std::lock_guard<std::mutex> lock(g_keys_mutex);
+        auto it = g_keys.find(handle);
+        if (it != g_keys.end()) return it->second;
+    }
+    jclass cls = env->FindClass("java/lang/IllegalStateException");
+    env->ThrowNew(cls, "Unknown or destroyed key handle");
+    env->DeleteLocalRef(cls);
+    return nullptr;
+}
+
+static bool check_args(JNIEnv* env, jbyteArray nonce, jbyteArray input, jint offset, jint length) {
+    const char* error = nullptr;
+    if (!nonce || env->GetArrayLength(nonce) != static_cast<jsize>(pulse::AesGcm::NONCE_BYTES)) {
+        error = "Nonce must be 12 bytes";
+    } else if (!input || offset < 0 || length < 0 || offset > env->GetArrayLength(input) - length) {
+        error = "Offset or length out of bounds";
+    }
+    if (!error) return true;
+
+    jclass cls = env->FindClass("java/lang/IllegalArgumentException");
+    env->ThrowNew(cls, error);
+    env->DeleteLocalRef(cls);
+    return false;
+}
+
+/**
+ * 读取 nonce 和附加数据（都很短，直接复制）
+ */
+static void read_header(JNIEnv* env, jbyteArray nonce, jbyteArray aad,
+                        uint8_t nonce_out[pulse::AesGcm::NONCE_BYTES], std::vector<uint8_t>& aad_out) {
+    env->GetByteArrayRegion(nonce, 0, pulse::AesGcm::NONCE_BYTES, reinterpret_cast<jbyte*>(nonce_out));
+    aad_out.clear();
+    if (aad) {
+        aad_out.resize(env->GetArrayLength(aad));
+        env->GetByteArrayRegion(aad, 0, static_cast<jsize>(aad_out.size()),
+                                reinterpret_cast<jbyte*>(aad_out.data()));
+    }
+}
+
+/**
+ * 导入 256 位密钥
+ * @return 密钥句柄，用完需 nativeDestroyKey；长度不对时返回 0
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_pulsenetwork_core_native_AesGcmCipherImpl_nativeCreateKey(
+        JNIEnv* env,
+        jobject thiz,
+        jbyteArray key) {
+    if (!key || env->GetArrayLength(key) != static_cast<jsize>(pulse::AesGcm::KEY_BYTES)) return 0;
+
+    uint8_t bytes[pulse::AesGcm::KEY_BYTES];
+    env->GetByteArrayRegion(key, 0, pulse::AesGcm::KEY_BYTES, reinterpret_cast<jbyte*>(bytes));
+    auto cipher = std::make_shared<pulse::AesGcm>(bytes);
+    volatile uint8_t* wipe = bytes;
+    for (size_t i = 0; i < sizeof(bytes); i++) wipe[i] = 0;
+
+    std::lock_guard<std::mutex> lock(g_keys_mutex);
+    jlong handle = g_next_key++;
+    g_keys[handle] = std::move(cipher);
+    return handle;
+}
+
+/**
+ * 销毁密钥（轮密钥随之清零；进行中的调用持有引用，结束后才释放）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_pulsenetwork_core_native_AesGcmCipherImpl_nativeDestroyKey(
+        JNIEnv* env,
+        jobject thiz,
+        jlong handle) {
+    std::lock_guard<std::mutex> lock(g_keys_mutex);
+    g_keys.erase(handle);
+}
+
+/**
+ * 加密 input[offset, offset + length)
+ * @return 密文 + 16 字节 tag
+ */
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_com_pulsenetwork_core_native_AesGcmCipherImpl_nativeSeal(
+        JNIEnv* env,
+        jobject thiz,
+        jlong handle,
+        jbyteArray nonce,
+        jbyteArray aad,
+        jbyteArray input,
+        jint offset,
+        jint length) {
+    auto cipher = find_key(env, handle);
+    if (!cipher || !check_args(env, nonce, input, offset, length)) return nullptr;
+
+    uint8_t nonce_bytes[pulse::AesGcm::NONCE_BYTES];
+    std::vector<uint8_t> aad_bytes;
+    read_header(env, nonce, aad, nonce_bytes, aad_bytes);
+
+    jbyteArray result = env->NewByteArray(length + static_cast<jsize>(pulse::AesGcm::TAG_BYTES));
+    if (!result) return nullptr;
+
+    // 大块数据不复制，直接在 Java 数组上加解密；临界区内不调用其他 JNI 函数
+    auto* in = static_cast<uint8_t*>(env->GetPrimitiveArrayCritical(input, nullptr));
+    auto* out = static_cast<uint8_t*>(env->GetPrimitiveArrayCritical(result, nullptr));
+    if (in && out) {
+        cipher->seal(nonce_bytes, aad_bytes.data(), aad_bytes.size(),
+                     in + offset, length, out, out + length);
+    }
+    if (out) env->ReleasePrimitiveArrayCritical(result, out, 0);
+    if (in) env->ReleasePrimitiveArrayCritical(input, in, JNI_ABORT);
+    return in && out ? result : nullptr;
+}
+
+/**
+ * 校验并解密 input[offset, offset + length)（密文 + tag）
+ * @return 明文；tag 不匹配时返回 null
+ */
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_com_pulsenetwork_core_native_AesGcmCipherImpl_nativeOpen(
+        JNIEnv* env,
+        jobject thiz,
+        jlong handle,
+        jbyteArray nonce,
+        jbyteArray aad,
+        jbyteArray input,
+        jint offset,
+        jint length) {
+    auto cipher = find_key(env, handle);
+    if (!cipher || !check_args(env, nonce, input, offset, length)) return nullptr;
+    if (length < static_cast<jint>(pulse::AesGcm::TAG_BYTES)) return nullptr;
+
+    uint8_t nonce_bytes[pulse::AesGcm::NONCE_BYTES];
+    std::vector<uint8_t> aad_bytes;
+    read_header(env, nonce, aad, nonce_bytes, aad_bytes);
+
+    const jsize plain_length = length - static_cast<jsize>(pulse::AesGcm::TAG_BYTES);
+    jbyteArray result = env->NewByteArray(plain_length);
+    if (!result) return nullptr;
+
+    auto* in = static_cast<uint8_t*>(env->GetPrimitiveArrayCritical(input, nullptr));
+    auto* out = static_cast<uint8_t*>(env->GetPrimitiveArrayCritical(result, nullptr));
+    bool ok = false;
+    if (in && out) {
+        ok = cipher->open(nonce_bytes, aad_bytes.data(), aad_bytes.size(),
+                          in + offset, plain_length, in + offset + plain_length, out);
+    }
+    if (out) env->ReleasePrimitiveArrayCritical(result, out, 0);
+    if (in) env->ReleasePrimitiveArrayCritical(input, in, JNI_ABORT);
+
+    if (!ok) {
+        env->DeleteLocalRef(result);
+        return nullptr;
+    }
+    return result;
+}
+
+/**
+ * 当前使用的 AES 实现
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_pulsenetwork_core_native_AesGcmCipherImpl_nativeGetBackend(
+        JNIEnv* env,
+        jobject thiz) {
+    return env->NewStringUTF(pulse::backend_name(pulse::AesGcm::best_backend()));
+}
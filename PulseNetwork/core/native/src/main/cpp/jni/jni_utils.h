@@ -0,0 +1,56 @@
+#pragma once
+
+#include <jni.h>
+#include <string>
+
+namespace pulse {
+
+/**
+ * jstring -> 标准 UTF-8
+ *
+ * GetStringUTFChars 返回的是 Modified UTF-8，emoji 等增补字符会被编码成代理对，
+ * 直接交给分词器会得到错误的 token，这里经由 String.getBytes("UTF-8") 转换
+ */
+inline std::string to_std_string(JNIEnv* env, jstring str) {
+    if (!str) return {};
+
+    jclass string_class = env->GetObjectClass(str);
+    jmethodID get_bytes = env->GetMethodID(string_class, "getBytes", "(Ljava/lang/String;)[B");
+    jstring charset = env->NewStringUTF("UTF-8");
+    auto bytes = static_cast<jbyteArray>(env->CallObjectMethod(str, get_bytes, charset));
+
+    std::string result;
+    if (bytes) {
+        jsize length = env->GetArrayLength(bytes);
+        result.resize(length);
+        env->GetByteArrayRegion(bytes, 0, length, reinterpret_cast<jbyte*>(&result[0]));
+        env->DeleteLocalRef(bytes);
+    }
+    env->DeleteLocalRef(charset);
+    env->DeleteLocalRef(string_class);
+    return result;
+}
+
+/**
+ * 标准 UTF-8 -> jstring
+ *
+ * NewStringUTF 遇到 4 字节 UTF-8 序列会在部分 Android 版本上直接 abort，
+ * 模型输出中常见 emoji，因此经由 new String(byte[], "UTF-8") 构造
+ */
+inline jstring to_jstring(JNIEnv* env, const std::string& str) {
+    jbyteArray bytes = env->NewByteArray(static_cast<jsize>(str.size()));
+    env->SetByteArrayRegion(bytes, 0, static_cast<jsize>(str.size()),
+                            reinterpret_cast<const jbyte*>(str.data()));
+
+    jclass string_class = env->FindClass("java/lang/String");
+    jmethodID constructor = env->GetMethodID(string_class, "<init>", "([BLjava/lang/String;)V");
+    jstring charset = env->NewStringUTF("UTF-8");
+    auto result = static_cast<jstring>(env->NewObject(string_class, constructor, bytes, charset));
+
+    env->DeleteLocalRef(charset);
+    env->DeleteLocalRef(string_class);
+    env->DeleteLocalRef(bytes);
+    return result;
+}
+
+} // namespace pulse
@@ -1,24 +1,137 @@
 #include <jni.h>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <android/log.h>
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
 
+#include "jni_utils.h"
+#include "llama.h"
+#include "llama_model.h"
+#include "model_registry.h"
+#include "throttle.h"
+
 #define LOG_TAG "PulseNative"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// llama.cpp 前向声明
-struct llama_model;
-struct llama_context;
-
 // 全局状态
-static llama_model* g_model = nullptr;
-static llama_context* g_ctx = nullptr;
-static bool g_is_generating = false;
+// 当前模型由 ModelRegistry 持有并标记为当前模型（不参与 LRU 淘汰），
+// 读写都经过注册表的锁；使用期间取得的 shared_ptr 防止中途被卸载释放
+
+// 进行中请求的取消令牌，Kotlin 侧持有句柄
+static std::mutex g_tokens_mutex;
+static std::unordered_map<jlong, std::shared_ptr<pulse::CancelToken>> g_tokens;
+static jlong g_next_token = 1;
+
+// 最近一次生成的统计，供 Kotlin 侧拆分预填充 / 解码耗时
+static std::mutex g_last_result_mutex;
+static pulse::GenerateResult g_last_result;
+static bool g_has_last_result = false;
+
+static std::shared_ptr<pulse::LlamaModel> active_model() {
+    return pulse::ModelRegistry::instance().active_as<pulse::LlamaModel>(pulse::ModelKind::LLAMA);
+}
+
+static std::shared_ptr<pulse::CancelToken> find_token(jlong handle) {
+    std::lock_guard<std::mutex> lock(g_tokens_mutex);
+    auto it = g_tokens.find(handle);
+    return it != g_tokens.end() ? it->second : std::make_shared<pulse::CancelToken>();
+}
+
+/**
+ * 超时以异常通知 Kotlin 侧，取消则正常返回已生成的部分
+ */
+static void throw_if_timeout(JNIEnv* env, const pulse::GenerateResult& result) {
+    if (result.stop_reason != pulse::StopReason::TIMEOUT) return;
+    jclass cls = env->FindClass("com/pulsenetwork/core/native/GenerationTimeoutException");
+    env->ThrowNew(cls, "Generation exceeded its deadline");
+}
+
+/**
+ * 读取 Kotlin 侧 SamplingParams
+ */
+static pulse::SamplingParams read_sampling_params(JNIEnv* env, jobject obj) {
+    pulse::SamplingParams params;
+    if (!obj) return params;
+
+    jclass cls = env->GetObjectClass(obj);
+    params.temperature = env->GetFloatField(obj, env->GetFieldID(cls, "temperature", "F"));
+    params.top_p = env->GetFloatField(obj, env->GetFieldID(cls, "topP", "F"));
+    params.top_k = env->GetIntField(obj, env->GetFieldID(cls, "topK", "I"));
+    params.repeat_penalty = env->GetFloatField(obj, env->GetFieldID(cls, "repeatPenalty", "F"));
+    params.frequency_penalty = env->GetFloatField(obj, env->GetFieldID(cls, "frequencyPenalty", "F"));
+    params.presence_penalty = env->GetFloatField(obj, env->GetFieldID(cls, "presencePenalty", "F"));
+    params.penalty_last_n = env->GetIntField(obj, env->GetFieldID(cls, "penaltyLastN", "I"));
+    params.seed = static_cast<uint32_t>(env->GetIntField(obj, env->GetFieldID(cls, "seed", "I")));
+
+    jobject grammar = env->GetObjectField(obj,
+        env->GetFieldID(cls, "grammar", "Lcom/pulsenetwork/core/native/OutputGrammar;"));
+    if (grammar) {
+        jclass grammar_class = env->GetObjectClass(grammar);
+        jint ordinal = env->CallIntMethod(grammar, env->GetMethodID(grammar_class, "ordinal", "()I"));
+        params.grammar = static_cast<pulse::GrammarMode>(ordinal);
+        env->DeleteLocalRef(grammar_class);
+        env->DeleteLocalRef(grammar);
+    }
+    env->DeleteLocalRef(cls);
+    return params;
+}
+
+/**
+ * 把 Kotlin 侧 TokenCallback 包装为会话回调，回调返回 false 或抛异常都视为停止
+ */
+static pulse::LlamaSession::TokenFn token_callback(JNIEnv* env, jobject callback) {
+    jmethodID on_token = env->GetMethodID(env->GetObjectClass(callback), "onToken", "(Ljava/lang/String;)Z");
+    return [env, callback, on_token](const std::string& piece) {
+        jstring jpiece = pulse::to_jstring(env, piece);
+        jboolean keep_going = env->CallBooleanMethod(callback, on_token, jpiece);
+        env->DeleteLocalRef(jpiece);
+        if (env->ExceptionCheck()) {
+            // 回调抛异常（如收集端已取消）视为停止
+            env->ExceptionClear();
+            return false;
+        }
+        return keep_going == JNI_TRUE;
+    };
+}
+
+/**
+ * 构造 Kotlin 侧 GenerationStats
+ */
+static jobject new_generation_stats(JNIEnv* env, const pulse::GenerateResult& result) {
+    jclass statsClass = env->FindClass("com/pulsenetwork/core/native/GenerationStats");
+    jmethodID constructor = env->GetMethodID(statsClass, "<init>", "(IIDD)V");
+    jobject stats = env->NewObject(statsClass, constructor,
+        static_cast<jint>(result.n_prompt),
+        static_cast<jint>(result.n_generated),
+        static_cast<jdouble>(result.prefill_ms),
+        static_cast<jdouble>(result.decode_ms)
+    );
+    env->DeleteLocalRef(statsClass);
+    return stats;
+}
+
+static void log_result(const pulse::GenerateResult& result) {
+    {
+        std::lock_guard<std::mutex> lock(g_last_result_mutex);
+        g_last_result = result;
+        g_has_last_result = true;
+    }
+    LOGI("Generated %d tokens (prompt %d): prefill %.0f ms, decode %.1f tok/s",
+         result.n_generated, result.n_prompt, result.prefill_ms,
+         result.decode_ms > 0 ? result.n_generated * 1000.0 / result.decode_ms : 0.0);
+}
 
 /**
  * 加载模型
+ *
+ * 已常驻的模型直接激活，不重新加载；否则先让注册表按 LRU 腾出空间再加载
  */
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeLoadModel(
@@ -26,23 +139,65 @@ Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeLoadModel(
         jobject thiz,
         jstring model_path,
         jint context_length,
-        jint threads) {
+        jint threads,
+        jint prefill_threads,
+        jboolean pin_threads,
+        jboolean use_mmap,
+        jboolean lock_memory,
+        jint prefetch_mode,
+        jint kv_cache_type,
+        jobject listener) {
 
     const char* path = env->GetStringUTFChars(model_path, nullptr);
+    std::string path_str(path);
+    env->ReleaseStringUTFChars(model_path, path);
 
-    LOGI("Loading model from: %s", path);
-    LOGI("Context length: %d, Threads: %d", context_length, threads);
+    LOGI("Loading model from: %s", path_str.c_str());
+    LOGI("Context length: %d, KV cache: %d, Threads: %d/%d (pin %d), mmap: %d, mlock: %d, prefetch: %d",
+         context_length, kv_cache_type, threads, prefill_threads, pin_threads, use_mmap, lock_memory,
+         prefetch_mode);
+    auto kv_cache = static_cast<pulse::KvCacheType>(kv_cache_type);
+
+    jmethodID on_progress = listener
+        ? env->GetMethodID(env->GetObjectClass(listener), "onProgress", "(F)V")
+        : nullptr;
+    auto report = [env, listener, on_progress](float progress) {
+        if (!listener) return true;
+        env->CallVoidMethod(listener, on_progress, progress);
+        if (env->ExceptionCheck()) {
+            // 回调抛异常视为取消加载
+            env->ExceptionClear();
+            return false;
+        }
+        return true;
+    };
+
+    auto& registry = pulse::ModelRegistry::instance();
+    auto resident = registry.get_as<pulse::LlamaModel>(path_str);
+    if (resident && resident->n_ctx() >= context_length && resident->kv_cache() == kv_cache) {
+        LOGI("Model already resident, switching without reload");
+        registry.activate(path_str);
+        report(1.0f);
+        return JNI_TRUE;
+    }
 
-    // TODO: 实际调用 llama.cpp 加载模型
-    // auto params = llama_context_default_params();
-    // params.n_ctx = context_length;
-    // params.n_threads = threads;
-    // g_model = llama_load_model_from_file(path, params);
-    // g_ctx = llama_new_context_with_model(g_model, params);
+    // 当前模型保留到新模型加载成功、put 取代它之后，加载失败时仍可继续使用
+    registry.reserve(pulse::LlamaModel::estimate_bytes(path_str, context_length, kv_cache));
 
-    env->ReleaseStringUTFChars(model_path, path);
+    pulse::LoadOptions options;
+    options.n_ctx = context_length;
+    options.kv_cache = kv_cache;
+    options.threads.decode_threads = threads;
+    options.threads.prefill_threads = prefill_threads;
+    options.threads.pin_to_performance_cores = pin_threads;
+    options.use_mmap = use_mmap;
+    options.use_mlock = lock_memory;
+    options.prefetch = static_cast<pulse::PrefetchMode>(prefetch_mode);
+
+    auto model = pulse::LlamaModel::load(path_str, options, report);
+    if (!model) return JNI_FALSE;
 
-    // 暂时返回 true（模拟）
+    registry.put(path_str, model, true);
     return JNI_TRUE;
 }
 
@@ -53,110 +208,470 @@ extern "C" JNIEXPORT jboolean JNICALL
 Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeIsModelLoaded(
         JNIEnv* env,
         jobject thiz) {
-    return g_model != nullptr ? JNI_TRUE : JNI_FALSE;
+    return active_model() ? JNI_TRUE : JNI_FALSE;
 }
 
 /**
  * 生成文本（阻塞式）
+ * @return 文本和本次调用的统计，未加载模型或生成失败时返回 null
  */
-extern "C" JNIEXPORT jstring JNICALL
+extern "C" JNIEXPORT jobject JNICALL
 Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeGenerate(
         JNIEnv* env,
         jobject thiz,
         jstring prompt,
         jint max_tokens,
-        jfloat temperature,
-        jfloat top_p,
-        jint top_k) {
+        jobject sampling,
+        jlong cancel_handle) {
+
+    pulse::SamplingParams params = read_sampling_params(env, sampling);
+    LOGI("Generating text, max_tokens=%d, temp=%.2f, top_p=%.2f, top_k=%d, grammar=%d",
+         max_tokens, params.temperature, params.top_p, params.top_k, static_cast<int>(params.grammar));
+
+    auto active = active_model();
+    if (!active) {
+        LOGE("Generate called without a loaded model");
+        return nullptr;
+    }
+
+    auto cancel = find_token(cancel_handle);
+    std::string text;
+    auto result = active->session().generate(
+        pulse::to_std_string(env, prompt), max_tokens, params,
+        [&text](const std::string& piece) {
+            text += piece;
+            return true;
+        },
+        cancel.get());
+
+    log_result(result);
+    throw_if_timeout(env, result);
+    if (env->ExceptionCheck() || !result.ok) return nullptr;
+
+    jstring jtext = pulse::to_jstring(env, text);
+    jobject stats = new_generation_stats(env, result);
+    jclass generationClass = env->FindClass("com/pulsenetwork/core/native/Generation");
+    jmethodID constructor = env->GetMethodID(generationClass, "<init>",
+        "(Ljava/lang/String;Lcom/pulsenetwork/core/native/GenerationStats;)V");
+    return env->NewObject(generationClass, constructor, jtext, stats);
+}
+
+/**
+ * 批量生成：多个提示词在同一批次中解码
+ * @return 与 prompts 一一对应的结果及本次调用的统计，未加载模型或生成失败时返回 null
+ */
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeGenerateBatch(
+        JNIEnv* env,
+        jobject thiz,
+        jobjectArray prompts,
+        jint max_tokens,
+        jobject sampling,
+        jlong cancel_handle) {
 
-    const char* prompt_str = env->GetStringUTFChars(prompt, nullptr);
+    pulse::SamplingParams params = read_sampling_params(env, sampling);
+
+    auto active = active_model();
+    if (!active) {
+        LOGE("Batch generate called without a loaded model");
+        return nullptr;
+    }
 
-    LOGI("Generating text, max_tokens=%d, temp=%.2f", max_tokens, temperature);
+    const jsize n = env->GetArrayLength(prompts);
+    std::vector<std::string> inputs;
+    inputs.reserve(n);
+    for (jsize i = 0; i < n; i++) {
+        auto prompt = static_cast<jstring>(env->GetObjectArrayElement(prompts, i));
+        inputs.push_back(pulse::to_std_string(env, prompt));
+        env->DeleteLocalRef(prompt);
+    }
 
-    // TODO: 实际调用 llama.cpp 生成文本
-    // std::string result = llama_generate(g_ctx, prompt_str, max_tokens, temperature, top_p, top_k);
+    auto cancel = find_token(cancel_handle);
+    std::vector<std::string> outputs;
+    auto result = active->session().generate_batch(inputs, max_tokens, params, outputs, cancel.get());
 
-    std::string result = "[JNI Bridge] 模型未实际加载，这是占位响应。";
+    log_result(result);
+    throw_if_timeout(env, result);
+    if (env->ExceptionCheck() || !result.ok) return nullptr;
 
-    env->ReleaseStringUTFChars(prompt, prompt_str);
+    jclass string_class = env->FindClass("java/lang/String");
+    jobjectArray array = env->NewObjectArray(n, string_class, nullptr);
+    for (jsize i = 0; i < n; i++) {
+        jstring text = pulse::to_jstring(env, outputs[i]);
+        env->SetObjectArrayElement(array, i, text);
+        env->DeleteLocalRef(text);
+    }
+    env->DeleteLocalRef(string_class);
 
-    return env->NewStringUTF(result.c_str());
+    jobject stats = new_generation_stats(env, result);
+    jclass batchClass = env->FindClass("com/pulsenetwork/core/native/BatchGeneration");
+    jmethodID constructor = env->GetMethodID(batchClass, "<init>",
+        "([Ljava/lang/String;Lcom/pulsenetwork/core/native/GenerationStats;)V");
+    return env->NewObject(batchClass, constructor, array, stats);
 }
 
 /**
  * 生成文本（流式）
+ *
+ * 每凑齐一段完整 UTF-8 文本就回调 callback.onToken，回调返回 false 时停止
+ * @return 是否正常完成
  */
-extern "C" JNIEXPORT jobjectArray JNICALL
+extern "C" JNIEXPORT jboolean JNICALL
 Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeGenerateStream(
         JNIEnv* env,
         jobject thiz,
         jstring prompt,
         jint max_tokens,
-        jfloat temperature,
-        jfloat top_p,
-        jint top_k) {
-
-    const char* prompt_str = env->GetStringUTFChars(prompt, nullptr);
+        jobject sampling,
+        jobject callback,
+        jlong cancel_handle) {
 
+    pulse::SamplingParams params = read_sampling_params(env, sampling);
     LOGI("Generating text (stream), max_tokens=%d", max_tokens);
 
-    // TODO: 实际流式生成
-    // 返回 token 数组
+    auto active = active_model();
+    if (!active) {
+        LOGE("Generate called without a loaded model");
+        return JNI_FALSE;
+    }
 
-    // 模拟返回
-    jclass stringClass = env->FindClass("java/lang/String");
-    jobjectArray result = env->NewObjectArray(5, stringClass, nullptr);
+    auto cancel = find_token(cancel_handle);
+    auto result = active->session().generate(
+        pulse::to_std_string(env, prompt), max_tokens, params,
+        token_callback(env, callback), cancel.get());
 
-    env->SetObjectArrayElement(result, 0, env->NewStringUTF("这是"));
-    env->SetObjectArrayElement(result, 1, env->NewStringUTF("模拟"));
-    env->SetObjectArrayElement(result, 2, env->NewStringUTF("的"));
-    env->SetObjectArrayElement(result, 3, env->NewStringUTF("流式"));
-    env->SetObjectArrayElement(result, 4, env->NewStringUTF("响应。"));
+    log_result(result);
+    throw_if_timeout(env, result);
+    return result.ok ? JNI_TRUE : JNI_FALSE;
+}
 
-    env->ReleaseStringUTFChars(prompt, prompt_str);
+/**
+ * 开始多轮对话，预填充系统提示词（上下文滑动时始终保留）
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeStartChat(
+        JNIEnv* env,
+        jobject thiz,
+        jstring system_prompt,
+        jlong cancel_handle) {
 
+    auto active = active_model();
+    if (!active) {
+        LOGE("Chat started without a loaded model");
+        return JNI_FALSE;
+    }
+
+    auto cancel = find_token(cancel_handle);
+    bool ok = active->session().start_chat(pulse::to_std_string(env, system_prompt), cancel.get());
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 原生上下文是否仍处于多轮对话中（单次 / 批量生成会结束对话）
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeIsChatActive(
+        JNIEnv* env,
+        jobject thiz) {
+    auto active = active_model();
+    return active && active->session().chat_active() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 按模型自带的对话模板格式化消息
+ * @return 未加载模型或模板不受支持时返回 null
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeApplyChatTemplate(
+        JNIEnv* env,
+        jobject thiz,
+        jobjectArray roles,
+        jobjectArray contents,
+        jboolean add_assistant) {
+    auto active = active_model();
+    if (!active) return nullptr;
+
+    jsize count = env->GetArrayLength(roles);
+    std::vector<pulse::ChatTurn> turns;
+    turns.reserve(count);
+    for (jsize i = 0; i < count; i++) {
+        auto role = static_cast<jstring>(env->GetObjectArrayElement(roles, i));
+        auto content = static_cast<jstring>(env->GetObjectArrayElement(contents, i));
+        turns.push_back({pulse::to_std_string(env, role), pulse::to_std_string(env, content)});
+        env->DeleteLocalRef(role);
+        env->DeleteLocalRef(content);
+    }
+
+    std::string formatted;
+    if (!active->session().apply_chat_template(turns, add_assistant == JNI_TRUE, formatted)) {
+        LOGE("Model chat template is not supported");
+        return nullptr;
+    }
+    return pulse::to_jstring(env, formatted);
+}
+
+/**
+ * 追加一轮对话并流式生成回复，只预填充新内容
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeChatStream(
+        JNIEnv* env,
+        jobject thiz,
+        jstring text,
+        jint max_tokens,
+        jobject sampling,
+        jobject callback,
+        jlong cancel_handle) {
+
+    pulse::SamplingParams params = read_sampling_params(env, sampling);
+
+    auto active = active_model();
+    if (!active) {
+        LOGE("Chat called without a loaded model");
+        return JNI_FALSE;
+    }
+
+    auto cancel = find_token(cancel_handle);
+    auto result = active->session().chat(
+        pulse::to_std_string(env, text), max_tokens, params,
+        token_callback(env, callback), cancel.get());
+
+    log_result(result);
+    throw_if_timeout(env, result);
+    return result.ok ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 先查回答索引的对话轮次
+ *
+ * 命中时缓存的回答经 callback 一次性输出；未命中时正常生成，结束后回答写入索引
+ * @param question 用户问题原文，与对话上下文一起构成索引键
+ * @return 失败时返回 null
+ */
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeChatCached(
+        JNIEnv* env,
+        jobject thiz,
+        jstring text,
+        jstring question,
+        jint max_tokens,
+        jfloat threshold,
+        jobject sampling,
+        jobject callback,
+        jlong cancel_handle) {
+
+    pulse::SamplingParams params = read_sampling_params(env, sampling);
+
+    auto active = active_model();
+    if (!active) {
+        LOGE("Chat called without a loaded model");
+        return nullptr;
+    }
+
+    pulse::SemanticLookup lookup;
+    lookup.key = pulse::to_std_string(env, question);
+    lookup.threshold = threshold;
+
+    auto cancel = find_token(cancel_handle);
+    auto result = active->session().chat(
+        pulse::to_std_string(env, text), max_tokens, params,
+        token_callback(env, callback), cancel.get(), &lookup);
+
+    log_result(result);
+    throw_if_timeout(env, result);
+    if (!result.ok) return nullptr;
+
+    jfloatArray embedding = nullptr;
+    if (!lookup.embedding.empty()) {
+        embedding = env->NewFloatArray(static_cast<jsize>(lookup.embedding.size()));
+        env->SetFloatArrayRegion(embedding, 0, static_cast<jsize>(lookup.embedding.size()),
+                                 lookup.embedding.data());
+    }
+
+    jclass resultClass = env->FindClass("com/pulsenetwork/core/native/CachedChatResult");
+    jmethodID constructor = env->GetMethodID(resultClass, "<init>", "(ZF[F)V");
+    return env->NewObject(resultClass, constructor, lookup.from_cache ? JNI_TRUE : JNI_FALSE,
+                          static_cast<jfloat>(lookup.similarity), embedding);
+}
+
+/**
+ * 清空回答索引
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeClearSemanticIndex(
+        JNIEnv* env,
+        jobject thiz) {
+    auto active = active_model();
+    if (active) active->session().semantic_index().clear();
+}
+
+/**
+ * 分词（经缓存）
+ * @return 未加载模型时返回 null
+ */
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeTokenize(
+        JNIEnv* env,
+        jobject thiz,
+        jstring text,
+        jboolean add_special) {
+    auto active = active_model();
+    if (!active) return nullptr;
+
+    std::vector<llama_token> tokens =
+        active->session().tokenize_cached(pulse::to_std_string(env, text), add_special == JNI_TRUE);
+    jintArray result = env->NewIntArray(static_cast<jsize>(tokens.size()));
+    static_assert(sizeof(llama_token) == sizeof(jint), "llama_token must be 32-bit");
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(tokens.size()),
+                           reinterpret_cast<const jint*>(tokens.data()));
     return result;
 }
 
 /**
- * 停止生成
+ * token 序列还原为文本
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeDetokenize(
+        JNIEnv* env,
+        jobject thiz,
+        jintArray tokens) {
+    auto active = active_model();
+    if (!active) return nullptr;
+
+    std::vector<llama_token> ids(env->GetArrayLength(tokens));
+    env->GetIntArrayRegion(tokens, 0, static_cast<jsize>(ids.size()), reinterpret_cast<jint*>(ids.data()));
+    return pulse::to_jstring(env, active->session().detokenize(ids));
+}
+
+/**
+ * 精确 token 数（不含 BOS）
+ * @return 未加载模型时返回 -1
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeCountTokens(
+        JNIEnv* env,
+        jobject thiz,
+        jstring text) {
+    auto active = active_model();
+    if (!active) return -1;
+    return active->session().count_tokens(pulse::to_std_string(env, text));
+}
+
+/**
+ * 保存当前会话快照（KV cache 与对话状态）
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeSaveSession(
+        JNIEnv* env,
+        jobject thiz,
+        jstring path) {
+    auto active = active_model();
+    if (!active) return JNI_FALSE;
+    return active->session().save_state(pulse::to_std_string(env, path)) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 从快照恢复会话，之后的对话无需重新预填充历史
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeRestoreSession(
+        JNIEnv* env,
+        jobject thiz,
+        jstring path) {
+    auto active = active_model();
+    if (!active) return JNI_FALSE;
+    return active->session().load_state(pulse::to_std_string(env, path)) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 停止所有进行中的生成
  */
 extern "C" JNIEXPORT void JNICALL
 Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeStopGeneration(
         JNIEnv* env,
         jobject thiz) {
-    g_is_generating = false;
-    LOGI("Generation stopped");
+    std::lock_guard<std::mutex> lock(g_tokens_mutex);
+    for (auto& entry : g_tokens) entry.second->cancel();
+    LOGI("Generation stopped (%zu requests)", g_tokens.size());
 }
 
 /**
- * 获取文本嵌入向量
+ * 设置运行时限流参数，进行中的生成在下一个 token 生效
  */
-extern "C" JNIEXPORT jfloatArray JNICALL
-Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeGetEmbedding(
+extern "C" JNIEXPORT void JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeSetThrottle(
         JNIEnv* env,
         jobject thiz,
-        jstring text) {
+        jint max_threads,
+        jint token_delay_ms,
+        jint max_batch) {
+    pulse::Throttle::instance().set(max_threads, token_delay_ms, max_batch);
+    LOGI("Throttle: max_threads=%d, token_delay=%d ms, max_batch=%d",
+         max_threads, token_delay_ms, max_batch);
+}
 
-    const char* text_str = env->GetStringUTFChars(text, nullptr);
+/**
+ * 创建取消令牌
+ * @param timeout_ms 相对当前时刻的截止时间，<= 0 表示不限时
+ * @return 令牌句柄，用完需 nativeReleaseCancelToken
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeCreateCancelToken(
+        JNIEnv* env,
+        jobject thiz,
+        jlong timeout_ms) {
+    auto token = std::make_shared<pulse::CancelToken>();
+    token->set_timeout_ms(timeout_ms);
+
+    std::lock_guard<std::mutex> lock(g_tokens_mutex);
+    jlong handle = g_next_token++;
+    g_tokens[handle] = std::move(token);
+    return handle;
+}
 
-    // TODO: 实际获取嵌入向量
-    // float* embedding = llama_get_embedding(g_ctx);
+/**
+ * 取消单个请求（可在任意线程调用）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeCancelToken(
+        JNIEnv* env,
+        jobject thiz,
+        jlong handle) {
+    std::lock_guard<std::mutex> lock(g_tokens_mutex);
+    auto it = g_tokens.find(handle);
+    if (it != g_tokens.end()) it->second->cancel();
+}
 
-    // 返回 384 维模拟向量
-    const int dimension = 384;
-    jfloatArray result = env->NewFloatArray(dimension);
+/**
+ * 释放取消令牌，正在使用它的生成仍持有引用
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeReleaseCancelToken(
+        JNIEnv* env,
+        jobject thiz,
+        jlong handle) {
+    std::lock_guard<std::mutex> lock(g_tokens_mutex);
+    g_tokens.erase(handle);
+}
 
-    float* data = new float[dimension];
-    for (int i = 0; i < dimension; i++) {
-        data[i] = (float)(rand() % 200 - 100) / 100.0f;
-    }
+/**
+ * 获取文本嵌入向量（当前模型均值池化后 L2 归一化）
+ * @return 未加载模型或模型不支持嵌入时返回 null
+ */
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeGetEmbedding(
+        JNIEnv* env,
+        jobject thiz,
+        jstring text) {
 
-    env->SetFloatArrayRegion(result, 0, dimension, data);
-    delete[] data;
+    auto active = active_model();
+    if (!active || !active->embedder()) return nullptr;
 
-    env->ReleaseStringUTFChars(text, text_str);
+    std::vector<float> embedding;
+    if (!active->embedder()->embed(pulse::to_std_string(env, text), embedding)) return nullptr;
 
+    jfloatArray result = env->NewFloatArray(static_cast<jsize>(embedding.size()));
+    env->SetFloatArrayRegion(result, 0, static_cast<jsize>(embedding.size()), embedding.data());
     return result;
 }
 
@@ -168,19 +683,35 @@ Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeGetModelInfo(
         JNIEnv* env,
         jobject thiz) {
 
-    // TODO: 返回实际模型信息
+    auto active = active_model();
+    if (!active) return nullptr;
+    llama_model* model = active->model();
+
+    char name[128];
+    if (llama_model_meta_val_str(model, "general.name", name, sizeof(name)) < 0) {
+        std::string base = active->path().substr(active->path().find_last_of('/') + 1);
+        snprintf(name, sizeof(name), "%s", base.c_str());
+    }
+
+    // llama_model_desc 形如 "llama 7B Q4_K - Medium"，第二个空格之后是量化类型
+    char desc[128];
+    llama_model_desc(model, desc, sizeof(desc));
+    std::string quantization(desc);
+    size_t first = quantization.find(' ');
+    size_t second = first == std::string::npos ? first : quantization.find(' ', first + 1);
+    if (second != std::string::npos) quantization = quantization.substr(second + 1);
 
     jclass infoClass = env->FindClass("com/pulsenetwork/core/native/ModelInfo");
     jmethodID constructor = env->GetMethodID(infoClass, "<init>",
         "(Ljava/lang/String;JIILjava/lang/String;J)V");
 
     return env->NewObject(infoClass, constructor,
-        env->NewStringUTF("Unknown Model"),
-        0LL,      // parameterCount
-        2048,     // contextLength
-        384,      // embeddingSize
-        env->NewStringUTF("Unknown"),
-        0LL       // fileSizeMB
+        env->NewStringUTF(name),
+        (jlong) llama_model_n_params(model),
+        (jint) active->n_ctx(),
+        (jint) llama_n_embd(model),
+        env->NewStringUTF(quantization.c_str()),
+        (jlong) (llama_model_size(model) / (1024 * 1024))
     );
 }
 
@@ -192,12 +723,7 @@ Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeUnloadModel(
         JNIEnv* env,
         jobject thiz) {
 
-    // TODO: 实际释放模型
-    // if (g_ctx) llama_free(g_ctx);
-    // if (g_model) llama_free_model(g_model);
-
-    g_ctx = nullptr;
-    g_model = nullptr;
+    pulse::ModelRegistry::instance().evict_active(pulse::ModelKind::LLAMA);
 
     LOGI("Model unloaded");
 }
@@ -210,19 +736,156 @@ Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeGetAvailableMemory(
         JNIEnv* env,
         jobject thiz) {
 
-    // Android 内存信息
-    FILE* fp = fopen("/proc/meminfo", "r");
-    if (!fp) return 0;
+    return pulse::ModelRegistry::available_memory_bytes() / (1024 * 1024);
+}
 
-    long availableKB = 0;
-    char line[256];
+/**
+ * 设置常驻模型内存预算（MB），0 表示自动（物理内存的一半）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeSetMemoryBudget(
+        JNIEnv* env,
+        jobject thiz,
+        jlong budget_mb) {
+    pulse::ModelRegistry::instance().set_budget(static_cast<uint64_t>(budget_mb) * 1024 * 1024);
+}
 
-    while (fgets(line, sizeof(line), fp)) {
-        if (sscanf(line, "MemAvailable: %ld kB", &availableKB) == 1) {
-            break;
-        }
+/**
+ * 响应内存压力，按 LRU 淘汰空闲模型
+ * @return 释放的内存（MB）
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeTrimMemory(
+        JNIEnv* env,
+        jobject thiz,
+        jint level) {
+    uint64_t freed = pulse::ModelRegistry::instance().on_memory_pressure(
+        static_cast<pulse::TrimLevel>(level));
+    LOGI("Trim memory level %d, freed %.1f MB", level, freed / (1024.0 * 1024.0));
+    return static_cast<jlong>(freed / (1024 * 1024));
+}
+
+/**
+ * 获取所有常驻模型（最近使用的在前）
+ */
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeGetResidentModels(
+        JNIEnv* env,
+        jobject thiz) {
+
+    auto models = pulse::ModelRegistry::instance().snapshot();
+
+    jclass infoClass = env->FindClass("com/pulsenetwork/core/native/ResidentModelInfo");
+    jmethodID constructor = env->GetMethodID(infoClass, "<init>", "(Ljava/lang/String;IJZ)V");
+    jobjectArray result = env->NewObjectArray(static_cast<jsize>(models.size()), infoClass, nullptr);
+
+    for (size_t i = 0; i < models.size(); i++) {
+        jstring key = env->NewStringUTF(models[i].key.c_str());
+        jobject info = env->NewObject(infoClass, constructor,
+            key,
+            static_cast<jint>(models[i].kind),
+            static_cast<jlong>(models[i].memory_bytes / (1024 * 1024)),
+            models[i].in_use ? JNI_TRUE : JNI_FALSE
+        );
+        env->SetObjectArrayElement(result, static_cast<jsize>(i), info);
+        env->DeleteLocalRef(key);
+        env->DeleteLocalRef(info);
     }
 
-    fclose(fp);
-    return availableKB / 1024; // 转换为 MB
+    return result;
+}
+
+/**
+ * 加载草稿模型并为当前模型开启推测解码
+ *
+ * 草稿模型与主模型一样常驻在注册表中，需与主模型共享词表
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeLoadDraftModel(
+        JNIEnv* env,
+        jobject thiz,
+        jstring model_path,
+        jint draft_tokens,
+        jint threads) {
+
+    auto active = active_model();
+    if (!active) {
+        LOGE("Load the main model before the draft model");
+        return JNI_FALSE;
+    }
+
+    std::string path_str = pulse::to_std_string(env, model_path);
+    LOGI("Loading draft model from: %s, draft tokens: %d", path_str.c_str(), draft_tokens);
+
+    auto& registry = pulse::ModelRegistry::instance();
+    auto draft = registry.get_as<pulse::LlamaModel>(path_str);
+    if (!draft || draft->n_ctx() < active->n_ctx()) {
+        registry.reserve(pulse::LlamaModel::estimate_bytes(path_str, active->n_ctx(), active->kv_cache(), false));
+
+        pulse::LoadOptions options;
+        options.n_ctx = active->n_ctx();
+        options.kv_cache = active->kv_cache();
+        // 草稿模型只负责猜 token，不做回答索引的相似查询
+        options.embeddings = false;
+        options.threads.decode_threads = threads;
+        options.threads.prefill_threads = threads;
+        draft = pulse::LlamaModel::load(path_str, options, nullptr);
+        if (!draft) return JNI_FALSE;
+        registry.put(path_str, draft);
+    }
+
+    return active->session().set_draft(draft, draft_tokens) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * 关闭推测解码（草稿模型仍常驻，可被注册表按 LRU 淘汰）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeDisableSpeculative(
+        JNIEnv* env,
+        jobject thiz) {
+    if (auto active = active_model()) {
+        active->session().clear_draft();
+    }
+}
+
+/**
+ * 获取最近一次生成的统计，还没有生成过时返回 null
+ */
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeGetLastGenerationStats(
+        JNIEnv* env,
+        jobject thiz) {
+
+    pulse::GenerateResult result;
+    {
+        std::lock_guard<std::mutex> lock(g_last_result_mutex);
+        if (!g_has_last_result) return nullptr;
+        result = g_last_result;
+    }
+    return new_generation_stats(env, result);
+}
+
+/**
+ * 获取推测解码统计
+ */
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_pulsenetwork_core_native_LLMInferenceImpl_nativeGetSpeculativeStats(
+        JNIEnv* env,
+        jobject thiz) {
+
+    auto active = active_model();
+    if (!active) return nullptr;
+    pulse::SpeculativeStats stats = active->session().speculative_stats();
+
+    jclass statsClass = env->FindClass("com/pulsenetwork/core/native/SpeculativeStats");
+    jmethodID constructor = env->GetMethodID(statsClass, "<init>", "(JJJJD)V");
+
+    return env->NewObject(statsClass, constructor,
+        static_cast<jlong>(stats.drafted),
+        static_cast<jlong>(stats.accepted),
+        static_cast<jlong>(stats.generated),
+        static_cast<jlong>(stats.target_passes),
+        static_cast<jdouble>(stats.decode_ms)
+    );
 }
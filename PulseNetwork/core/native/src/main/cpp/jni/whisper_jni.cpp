@@ -1,16 +1,21 @@
 #include <jni.h>
+#include <memory>
 #include <string>
 #include <android/log.h>
 
+#include "model_registry.h"
+#include "whisper_model.h"
+
 #define LOG_TAG "PulseNative"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// whisper.cpp 前向声明
-struct whisper_context;
-
 // 全局状态
-static whisper_context* g_whisper_ctx = nullptr;
+// 与 llama 模型共用 ModelRegistry 的内存预算，当前模型由注册表持有
+
+static std::shared_ptr<pulse::WhisperModel> active_model() {
+    return pulse::ModelRegistry::instance().active_as<pulse::WhisperModel>(pulse::ModelKind::WHISPER);
+}
 
 /**
  * 加载模型
@@ -23,13 +28,25 @@ Java_com_pulsenetwork_core_native_SpeechRecognitionImpl_nativeLoadModel(
 
     const char* path = env->GetStringUTFChars(model_path, nullptr);
 
-    LOGI("Loading whisper model from: %s", path);
+    std::string path_str(path);
+    env->ReleaseStringUTFChars(model_path, path);
 
-    // TODO: 实际调用 whisper.cpp 加载模型
-    // g_whisper_ctx = whisper_init_from_file(path);
+    LOGI("Loading whisper model from: %s", path_str.c_str());
 
-    env->ReleaseStringUTFChars(model_path, path);
+    auto& registry = pulse::ModelRegistry::instance();
+    if (auto resident = registry.get_as<pulse::WhisperModel>(path_str)) {
+        LOGI("Whisper model already resident, switching without reload");
+        registry.activate(path_str);
+        return JNI_TRUE;
+    }
+
+    // 当前模型保留到新模型加载成功之后
+    registry.reserve(pulse::WhisperModel::estimate_bytes(path_str));
 
+    auto model = pulse::WhisperModel::load(path_str);
+    if (!model) return JNI_FALSE;
+
+    registry.put(path_str, model, true);
     return JNI_TRUE;
 }
 
@@ -40,7 +57,7 @@ extern "C" JNIEXPORT jboolean JNICALL
 Java_com_pulsenetwork_core_native_SpeechRecognitionImpl_nativeIsModelLoaded(
         JNIEnv* env,
         jobject thiz) {
-    return g_whisper_ctx != nullptr ? JNI_TRUE : JNI_FALSE;
+    return active_model() ? JNI_TRUE : JNI_FALSE;
 }
 
 /**
@@ -63,7 +80,7 @@ Java_com_pulsenetwork_core_native_SpeechRecognitionImpl_nativeTranscribe(
     // TODO: 实际调用 whisper.cpp 转录
     // whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
     // params.language = lang;
-    // whisper_full(g_whisper_ctx, params, sample_data, sample_count);
+    // whisper_full(active_model()->context(), params, sample_data, sample_count);
 
     env->ReleaseFloatArrayElements(samples, sample_data, 0);
     env->ReleaseStringUTFChars(language, lang);
@@ -132,10 +149,7 @@ Java_com_pulsenetwork_core_native_SpeechRecognitionImpl_nativeUnloadModel(
         JNIEnv* env,
         jobject thiz) {
 
-    // TODO: 实际释放模型
-    // if (g_whisper_ctx) whisper_free(g_whisper_ctx);
-
-    g_whisper_ctx = nullptr;
+    pulse::ModelRegistry::instance().evict_active(pulse::ModelKind::WHISPER);
 
     LOGI("Whisper model unloaded");
 }
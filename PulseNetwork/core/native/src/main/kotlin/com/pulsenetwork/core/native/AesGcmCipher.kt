@@ -0,0 +1,53 @@
+package com.pulsenetwork.core.native
+
+/**
+ * AES-256-GCM 加解密接口
+ *
+ * 通过 JNI 调用原生实现（ARMv8 Crypto Extensions / AES-NI，不支持时退回软件实现）。
+ * 密钥导入后只以句柄形式存在，展开后的轮密钥留在原生内存中，
+ * 每次调用不再创建 Cipher 实例；nonce 为 12 字节，tag 为 16 字节，附在密文末尾
+ */
+interface AesGcmCipher {
+
+    /**
+     * 导入 32 字节密钥
+     * @return 密钥句柄，用完需 destroyKey
+     */
+    fun createKey(key: ByteArray): Long
+
+    /**
+     * 销毁密钥，原生内存中的密钥材料随之清零
+     */
+    fun destroyKey(handle: Long)
+
+    /**
+     * 加密 input[offset, offset + length)
+     * @return 密文 + tag
+     */
+    fun seal(
+        handle: Long,
+        nonce: ByteArray,
+        aad: ByteArray?,
+        input: ByteArray,
+        offset: Int = 0,
+        length: Int = input.size - offset
+    ): ByteArray
+
+    /**
+     * 校验并解密 input[offset, offset + length)（密文 + tag）
+     * @return 明文；数据被篡改或密钥不符时为 null
+     */
+    fun open(
+        handle: Long,
+        nonce: ByteArray,
+        aad: ByteArray?,
+        input: ByteArray,
+        offset: Int = 0,
+        length: Int = input.size - offset
+    ): ByteArray?
+
+    /**
+     * 当前使用的实现：armv8-ce / aes-ni / software / jca
+     */
+    fun getBackend(): String
+}
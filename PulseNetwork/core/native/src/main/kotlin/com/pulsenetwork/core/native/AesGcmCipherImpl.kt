@@ -0,0 +1,129 @@
+package com.pulsenetwork.core.native
+
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicLong
+import javax.crypto.AEADBadTagException
+import javax.crypto.Cipher
+import javax.crypto.spec.GCMParameterSpec
+import javax.crypto.spec.SecretKeySpec
+
+/**
+ * AES-256-GCM 实现
+ *
+ * 通过 JNI 调用原生实现；JNI 未链接时退回 JCA，输出格式完全相同
+ */
+class AesGcmCipherImpl : AesGcmCipher {
+
+    companion object {
+        private const val KEY_BYTES = 32
+        private const val TAG_BITS = 128
+
+        init {
+            System.loadLibrary("pulsenative")
+        }
+    }
+
+    // 仅 JCA 回退使用
+    private val fallbackKeys = ConcurrentHashMap<Long, SecretKeySpec>()
+    private val nextFallbackKey = AtomicLong(1)
+
+    // JNI 原生方法
+    private external fun nativeCreateKey(key: ByteArray): Long
+
+    private external fun nativeDestroyKey(handle: Long)
+
+    private external fun nativeSeal(
+        handle: Long,
+        nonce: ByteArray,
+        aad: ByteArray?,
+        input: ByteArray,
+        offset: Int,
+        length: Int
+    ): ByteArray?
+
+    private external fun nativeOpen(
+        handle: Long,
+        nonce: ByteArray,
+        aad: ByteArray?,
+        input: ByteArray,
+        offset: Int,
+        length: Int
+    ): ByteArray?
+
+    private external fun nativeGetBackend(): String
+
+    override fun createKey(key: ByteArray): Long {
+        require(key.size == KEY_BYTES) { "AES-256 key must be $KEY_BYTES bytes" }
+        return try {
+            nativeCreateKey(key)
+        } catch (e: UnsatisfiedLinkError) {
+            // JCA 回退
+            val handle = nextFallbackKey.getAndIncrement()
+            fallbackKeys[handle] = SecretKeySpec(key, "AES")
+            handle
+        }
+    }
+
+    override fun destroyKey(handle: Long) {
+        try {
+            nativeDestroyKey(handle)
+        } catch (e: UnsatisfiedLinkError) {
+            fallbackKeys.remove(handle)
+        }
+    }
+
+    override fun seal(
+        handle: Long,
+        nonce: ByteArray,
+        aad: ByteArray?,
+        input: ByteArray,
+        offset: Int,
+        length: Int
+    ): ByteArray {
+        return try {
+            nativeSeal(handle, nonce, aad, input, offset, length)
+                ?: throw IllegalStateException("Native seal failed")
+        } catch (e: UnsatisfiedLinkError) {
+            val cipher = fallbackCipher(Cipher.ENCRYPT_MODE, handle, nonce, aad)
+            cipher.doFinal(input, offset, length)
+        }
+    }
+
+    override fun open(
+        handle: Long,
+        nonce: ByteArray,
+        aad: ByteArray?,
+        input: ByteArray,
+        offset: Int,
+        length: Int
+    ): ByteArray? {
+        return try {
+            nativeOpen(handle, nonce, aad, input, offset, length)
+        } catch (e: UnsatisfiedLinkError) {
+            val cipher = fallbackCipher(Cipher.DECRYPT_MODE, handle, nonce, aad)
+            try {
+                cipher.doFinal(input, offset, length)
+            } catch (e: AEADBadTagException) {
+                null
+            }
+        }
+    }
+
+    override fun getBackend(): String {
+        return try {
+            nativeGetBackend()
+        } catch (e: UnsatisfiedLinkError) {
+            "jca"
+        }
+    }
+
+    // ========== 私有方法 ==========
+
+    private fun fallbackCipher(mode: Int, handle: Long, nonce: ByteArray, aad: ByteArray?): Cipher {
+        val key = fallbackKeys[handle] ?: throw IllegalStateException("Unknown or destroyed key handle")
+        return Cipher.getInstance("AES/GCM/NoPadding").apply {
+            init(mode, key, GCMParameterSpec(TAG_BITS, nonce))
+            aad?.let { updateAAD(it) }
+        }
+    }
+}
@@ -11,13 +11,17 @@ interface LLMInference {
      * 加载模型
      * @param modelPath 模型文件路径 (GGUF 格式)
      * @param contextLength 上下文长度
-     * @param threads 使用的线程数
+     * @param threads 解码线程数，0 表示按 CPU 拓扑自动选择（性能核数，最多 4 个）
+     * @param options mmap / 预取等加载选项
+     * @param onProgress 加载进度回调 (0.0-1.0)，在加载线程上调用
      * @return 是否加载成功
      */
     suspend fun loadModel(
         modelPath: String,
         contextLength: Int = 2048,
-        threads: Int = 4
+        threads: Int = 0,
+        options: ModelLoadOptions = ModelLoadOptions(),
+        onProgress: (Float) -> Unit = {}
     ): Boolean
 
     /**
@@ -40,6 +44,20 @@ interface LLMInference {
         temperature: Float = 0.7f,
         topP: Float = 0.9f,
         topK: Int = 40
+    ): kotlinx.coroutines.flow.Flow<String> =
+        generateStream(prompt, maxTokens, SamplingParams(temperature = temperature, topP = topP, topK = topK))
+
+    /**
+     * 生成文本（流式，完整采样参数）
+     *
+     * 取消收集即取消生成，原生解码在一个 token 内停止
+     * @param timeoutMs 截止时间，<= 0 表示不限时；超时后流以 GenerationTimeoutException 结束
+     */
+    fun generateStream(
+        prompt: String,
+        maxTokens: Int,
+        params: SamplingParams,
+        timeoutMs: Long = 0L
     ): kotlinx.coroutines.flow.Flow<String>
 
     /**
@@ -49,17 +67,171 @@ interface LLMInference {
         prompt: String,
         maxTokens: Int = 256,
         temperature: Float = 0.7f
+    ): String = generate(prompt, maxTokens, SamplingParams(temperature = temperature))
+
+    /**
+     * 生成文本（阻塞式，完整采样参数）
+     *
+     * params.grammar 为 JSON 时输出保证是一个完整的 JSON 对象或数组，顶层闭合即停止；
+     * 协程取消时原生解码在一个 token 内停止
+     * @param timeoutMs 截止时间，<= 0 表示不限时
+     * @throws GenerationTimeoutException 超过截止时间
+     * @throws GenerationFailedException 未加载模型或解码失败
+     */
+    suspend fun generate(
+        prompt: String,
+        maxTokens: Int,
+        params: SamplingParams,
+        timeoutMs: Long = 0L
     ): String
 
     /**
-     * 停止生成
+     * 与 generate 相同，同时返回这一次调用的 token 数和耗时
+     *
+     * 并发生成时 getLastGenerationStats 可能属于其他调用，需要按调用归属统计时用这里的结果
+     * @throws GenerationTimeoutException 超过截止时间
+     * @throws GenerationFailedException 未加载模型或解码失败
+     */
+    suspend fun generateWithStats(
+        prompt: String,
+        maxTokens: Int,
+        params: SamplingParams,
+        timeoutMs: Long = 0L
+    ): Generation
+
+    /**
+     * 批量生成（阻塞式）
+     *
+     * 多个提示词在原生层作为多条序列共享一次批量解码，每步只调用一次 llama_decode；
+     * 上下文放不下的部分自动拆成多组。会结束当前对话
+     * @return 与 prompts 一一对应的生成结果
+     * @throws GenerationTimeoutException 超过截止时间
+     * @throws GenerationFailedException 未加载模型或解码失败
+     */
+    suspend fun generateBatch(
+        prompts: List<String>,
+        maxTokens: Int = 256,
+        params: SamplingParams = SamplingParams(),
+        timeoutMs: Long = 0L
+    ): List<String>
+
+    /**
+     * 与 generateBatch 相同，同时返回这一次调用的统计（各组累计）
+     * @throws GenerationTimeoutException 超过截止时间
+     * @throws GenerationFailedException 未加载模型或解码失败
+     */
+    suspend fun generateBatchWithStats(
+        prompts: List<String>,
+        maxTokens: Int = 256,
+        params: SamplingParams = SamplingParams(),
+        timeoutMs: Long = 0L
+    ): BatchGeneration
+
+    /**
+     * 开始多轮对话
+     *
+     * 清空上下文并预填充系统提示词；上下文写满时系统提示词始终保留，
+     * 只丢弃最早的对话内容
+     * @param systemPrompt 已按模型对话模板格式化的系统提示词
+     */
+    suspend fun startChat(systemPrompt: String): Boolean
+
+    /**
+     * 原生上下文是否仍处于多轮对话中
+     *
+     * generate / generateBatch（例如工作流步骤）会结束当前对话，之后需重新 startChat
+     */
+    fun isChatActive(): Boolean
+
+    /**
+     * 按模型自带的对话模板（GGUF 中的 tokenizer.chat_template）格式化消息，
+     * 模型未带模板或未加载模型时按 ChatML 格式化
+     * @param addAssistant 末尾追加助手回复的前缀
+     */
+    fun applyChatTemplate(turns: List<ChatTurn>, addAssistant: Boolean): String
+
+    /**
+     * 在当前对话之后追加一轮并流式生成回复
+     *
+     * 之前的对话保留在 KV cache 中，只需预填充本轮新增的 token；
+     * 单次 generate / generateStream 会结束当前对话
+     * @param turn 已按模型对话模板格式化的新内容（用户发言及助手前缀）
+     */
+    fun chatStream(
+        turn: String,
+        maxTokens: Int = 256,
+        params: SamplingParams = SamplingParams(),
+        timeoutMs: Long = 0L
+    ): kotlinx.coroutines.flow.Flow<String>
+
+    /**
+     * 先查原生回答索引再解码的对话轮次
+     *
+     * 问题原文和对话上下文（系统提示词、之前的轮次）都相同时直接给出缓存的回答，不再逐 token 解码；
+     * 否则在上下文相同的条目中比较问题嵌入（模型均值池化），余弦相似度不低于阈值时也直接给出。
+     * 未命中时正常生成，以结束符收尾的回答连同问题嵌入自动写入索引。
+     * 只做精确匹配或同一上下文下还没有条目时不计算嵌入，省去额外的一次前向计算。
+     * 最后一个事件总是 [AnswerEvent.Done]
+     * @param question 用户问题原文
+     * @param similarityThreshold 相似问题的余弦相似度下限，<= 0 时只做精确匹配。
+     *        生成式模型的池化向量未经句向量训练，合适的阈值因模型而异，默认值偏保守
+     */
+    fun chatWithCache(
+        turn: String,
+        question: String,
+        maxTokens: Int = 256,
+        params: SamplingParams = SamplingParams(),
+        timeoutMs: Long = 0L,
+        similarityThreshold: Float = CachedChatResult.DEFAULT_SIMILARITY_THRESHOLD
+    ): kotlinx.coroutines.flow.Flow<AnswerEvent>
+
+    /**
+     * 清空原生回答索引
+     */
+    fun clearSemanticIndex()
+
+    /**
+     * 把当前会话（KV cache 与对话状态）保存到文件
+     *
+     * 应用重启或模型重新加载后用 restoreSession 恢复，无需重新预填充整段历史
+     */
+    suspend fun saveSession(path: String): Boolean
+
+    /**
+     * 从文件恢复会话，之后 chatStream 直接续写
+     * @return 文件不存在、属于其他模型、KV 精度不同或保存时对话未进行时返回 false
+     */
+    suspend fun restoreSession(path: String): Boolean
+
+    /**
+     * 用当前模型的词表分词
+     *
+     * 反复出现的片段（系统提示词、模板）经原生 LRU 缓存，只分词一次
+     * @return 未加载模型时返回空数组
+     */
+    fun tokenize(text: String, addSpecial: Boolean = false): IntArray
+
+    /**
+     * token 序列还原为文本
+     */
+    fun detokenize(tokens: IntArray): String
+
+    /**
+     * 精确 token 数（不含 BOS），用于提示词预算
+     *
+     * 未加载模型时退化为按字符估算
+     */
+    fun countTokens(text: String): Int
+
+    /**
+     * 停止所有进行中的生成
      */
     fun stopGeneration()
 
     /**
-     * 获取嵌入向量
+     * 获取嵌入向量（当前模型均值池化后 L2 归一化，维度为 n_embd）
      * @param text 输入文本
-     * @return 嵌入向量
+     * @return 嵌入向量，未加载模型或模型不支持嵌入时返回 null
      */
     suspend fun getEmbedding(text: String): FloatArray?
 
@@ -77,6 +249,62 @@ interface LLMInference {
      * 获取可用内存（MB）
      */
     fun getAvailableMemory(): Long
+
+    /**
+     * 设置常驻模型内存预算（MB）
+     *
+     * LLM 与语音模型共用该预算，超出时按最近最少使用淘汰空闲模型；
+     * 0 表示自动（物理内存的一半）
+     */
+    fun setMemoryBudget(budgetMB: Long)
+
+    /**
+     * 响应系统内存压力，淘汰空闲的常驻模型
+     * @return 释放的内存（MB）
+     */
+    fun trimMemory(level: MemoryTrimLevel): Long
+
+    /**
+     * 获取当前常驻的模型（最近使用的在前）
+     */
+    fun getResidentModels(): List<ResidentModelInfo>
+
+    /**
+     * 加载草稿模型，为当前模型开启推测解码
+     *
+     * 草稿模型需与主模型共享词表（同系列的小参数量模型），
+     * 每轮由草稿模型提出 draftTokens 个 token，主模型一次批量验证，输出分布不变
+     * @param draftModelPath 草稿模型路径 (GGUF 格式)
+     * @param draftTokens 每轮起草的 token 数
+     * @return 是否开启成功（主模型未加载或词表不一致时失败）
+     */
+    suspend fun loadDraftModel(
+        draftModelPath: String,
+        draftTokens: Int = 4,
+        threads: Int = 0
+    ): Boolean
+
+    /**
+     * 关闭推测解码
+     */
+    fun disableSpeculativeDecoding()
+
+    /**
+     * 获取推测解码统计（累计值），未开启过时各项为 0
+     */
+    fun getSpeculativeStats(): SpeculativeStats?
+
+    /**
+     * 最近一次生成（任意入口）的 token 数与预填充 / 解码耗时，还没有生成过时为 null
+     */
+    fun getLastGenerationStats(): GenerationStats?
+
+    /**
+     * 设置推理限流参数
+     *
+     * 进行中的生成在下一个 token 生效，用于发热或低电量时平滑降速
+     */
+    fun setThrottle(throttle: InferenceThrottle)
 }
 
 /**
@@ -91,6 +319,223 @@ data class ModelInfo(
     val fileSizeMB: Long
 )
 
+/**
+ * 对话消息
+ */
+data class ChatTurn(
+    val role: String,       // ROLE_SYSTEM / ROLE_USER / ROLE_ASSISTANT
+    val content: String
+) {
+    companion object {
+        const val ROLE_SYSTEM = "system"
+        const val ROLE_USER = "user"
+        const val ROLE_ASSISTANT = "assistant"
+    }
+}
+
+/**
+ * 常驻模型信息
+ */
+data class ResidentModelInfo(
+    val path: String,
+    val kind: Int,          // KIND_LLM / KIND_SPEECH
+    val memoryMB: Long,
+    val inUse: Boolean
+) {
+    companion object {
+        const val KIND_LLM = 0
+        const val KIND_SPEECH = 1
+    }
+}
+
+/**
+ * 采样参数
+ *
+ * 处理顺序：重复惩罚 -> top-k -> 温度 -> top-p。
+ * 启用惩罚或语法约束后推测解码会自动回退为普通解码
+ */
+data class SamplingParams(
+    val temperature: Float = 0.7f,       // <= 0 为贪心解码
+    val topP: Float = 0.9f,              // 1.0 表示不截断
+    val topK: Int = 40,                  // <= 0 表示不截断
+    val repeatPenalty: Float = 1.0f,     // 1.0 表示关闭，常用 1.1；<= 0 按 1.0 处理
+    val frequencyPenalty: Float = 0f,    // 按出现次数线性扣减 logit
+    val presencePenalty: Float = 0f,     // 出现过即扣减 logit
+    val penaltyLastN: Int = 64,          // 惩罚窗口（含提示词）
+    val grammar: OutputGrammar = OutputGrammar.NONE,
+    val seed: Int = -1                   // -1 表示随机种子
+)
+
+/**
+ * 输出约束
+ */
+enum class OutputGrammar {
+    NONE,
+    JSON    // 只允许生成合法 JSON（顶层为对象或数组）
+}
+
+/**
+ * 先查缓存的对话轮次的结果
+ */
+data class CachedChatResult(
+    val fromCache: Boolean,
+    val similarity: Float = 0f,          // 命中条目的余弦相似度，精确命中为 1
+    val embedding: FloatArray? = null    // 问题的归一化嵌入，模型不支持嵌入时为 null
+) {
+    companion object {
+        const val DEFAULT_SIMILARITY_THRESHOLD = 0.95f
+    }
+
+    override fun equals(other: Any?): Boolean {
+        if (this === other) return true
+        if (other !is CachedChatResult) return false
+        return fromCache == other.fromCache && similarity == other.similarity &&
+            embedding.contentEquals(other.embedding)
+    }
+
+    override fun hashCode(): Int =
+        (fromCache.hashCode() * 31 + similarity.hashCode()) * 31 + embedding.contentHashCode()
+}
+
+/**
+ * chatWithCache 的输出事件
+ */
+sealed class AnswerEvent {
+    data class Token(val text: String) : AnswerEvent()
+    data class Done(val result: CachedChatResult) : AnswerEvent()
+}
+
+/**
+ * 单次生成统计
+ */
+data class GenerationStats(
+    val promptTokens: Int,
+    val generatedTokens: Int,
+    val prefillMs: Double,
+    val decodeMs: Double
+)
+
+/**
+ * 单次生成的文本及其统计，模拟实现中 stats 为 null
+ */
+data class Generation(
+    val text: String,
+    val stats: GenerationStats?
+)
+
+/**
+ * 批量生成的文本及其统计，模拟实现中 stats 为 null
+ */
+data class BatchGeneration(
+    val texts: List<String>,
+    val stats: GenerationStats?
+) {
+    // 供 JNI 直接用字符串数组构造
+    internal constructor(texts: Array<String>, stats: GenerationStats?) : this(texts.asList(), stats)
+}
+
+/**
+ * 推测解码统计
+ */
+data class SpeculativeStats(
+    val draftedTokens: Long,
+    val acceptedTokens: Long,
+    val generatedTokens: Long,
+    val targetPasses: Long,      // 主模型前向次数
+    val decodeMs: Double
+) {
+    /** 草稿 token 接受率 */
+    val acceptanceRate: Float
+        get() = if (draftedTokens > 0) acceptedTokens.toFloat() / draftedTokens else 0f
+
+    /** 解码速度（token/s） */
+    val tokensPerSecond: Float
+        get() = if (decodeMs > 0) (generatedTokens * 1000.0 / decodeMs).toFloat() else 0f
+
+    /** 每次主模型前向产出的 token 数，即相对逐 token 解码的加速比 */
+    val speedup: Float
+        get() = if (targetPasses > 0) generatedTokens.toFloat() / targetPasses else 0f
+}
+
+/**
+ * 推理限流参数，各项为 0 表示不限制
+ */
+data class InferenceThrottle(
+    val maxThreads: Int = 0,      // 解码/预填充线程上限（不超过加载时的线程数）
+    val tokenDelayMs: Int = 0,    // 每个 token 之后的休眠（毫秒）
+    val maxBatch: Int = 0         // 预填充单次前向的最大 token 数
+) {
+    companion object {
+        val NONE = InferenceThrottle()
+    }
+}
+
+/**
+ * 生成超过截止时间（由 JNI 抛出）
+ */
+class GenerationTimeoutException(message: String) : Exception(message)
+
+/**
+ * 生成失败（未加载模型或解码出错），不能当作空结果使用
+ */
+class GenerationFailedException(message: String) : Exception(message)
+
+/**
+ * 流式生成回调（JNI 回调）
+ */
+fun interface TokenCallback {
+    /**
+     * @param piece 一段完整的 UTF-8 文本
+     * @return false 停止生成
+     */
+    fun onToken(piece: String): Boolean
+}
+
+/**
+ * 内存回收等级
+ */
+enum class MemoryTrimLevel {
+    MODERATE,   // 收缩到预算的 3/4
+    LOW,        // 只保留最近使用的模型
+    CRITICAL    // 释放所有空闲模型
+}
+
+/**
+ * 模型加载选项
+ */
+data class ModelLoadOptions(
+    val useMmap: Boolean = true,          // 通过 mmap 加载，权重由页缓存支撑，不常驻两份
+    val lockInMemory: Boolean = false,    // mlock 锁定权重页，防止被换出（会增加常驻内存）
+    val prefetch: PrefetchMode = PrefetchMode.EAGER,
+    val prefillThreads: Int = 0,          // 预填充线程数，0 表示自动（全部性能核）
+    val pinToPerformanceCores: Boolean = true,  // 大小核设备上把推理线程固定在性能核
+    val kvCacheType: KvCacheType = KvCacheType.F16
+)
+
+/**
+ * KV cache 精度
+ */
+enum class KvCacheType {
+    F16,    // 默认精度
+    Q8_0,   // 内存约为 F16 的 1/2，质量几乎无损
+    Q4_0    // 内存约为 F16 的 1/4，适合超长上下文
+}
+
+/**
+ * 权重预取模式
+ */
+enum class PrefetchMode {
+    EAGER,  // 加载时预读全部权重，首 token 无缺页等待
+    LAZY    // 权重页按需换入，冷启动最快、常驻内存最低
+}
+
+/**
+ * 加载进度监听（JNI 回调）
+ */
+fun interface LoadProgressListener {
+    fun onProgress(progress: Float)
+}
+
 /**
  * LLM 服务状态
  */
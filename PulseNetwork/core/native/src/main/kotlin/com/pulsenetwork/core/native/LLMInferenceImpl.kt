@@ -1,9 +1,16 @@
 package com.pulsenetwork.core.native
 
+import kotlinx.coroutines.CoroutineStart
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.awaitCancellation
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.trySendBlocking
 import kotlinx.coroutines.flow.Flow
-import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.buffer
+import kotlinx.coroutines.flow.channelFlow
 import kotlinx.coroutines.flow.flowOn
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
 
 /**
@@ -20,6 +27,8 @@ class LLMInferenceImpl : LLMInference {
     }
 
     private var isLoaded = false
+    // 仅模拟实现使用，原生生成通过取消令牌停止
+    @Volatile
     private var isGenerating = false
     private var modelInfo: ModelInfo? = null
 
@@ -27,7 +36,14 @@ class LLMInferenceImpl : LLMInference {
     private external fun nativeLoadModel(
         modelPath: String,
         contextLength: Int,
-        threads: Int
+        threads: Int,
+        prefillThreads: Int,
+        pinThreads: Boolean,
+        useMmap: Boolean,
+        lockMemory: Boolean,
+        prefetchMode: Int,
+        kvCacheType: Int,
+        listener: LoadProgressListener?
     ): Boolean
 
     private external fun nativeIsModelLoaded(): Boolean
@@ -35,21 +51,73 @@ class LLMInferenceImpl : LLMInference {
     private external fun nativeGenerate(
         prompt: String,
         maxTokens: Int,
-        temperature: Float,
-        topP: Float,
-        topK: Int
-    ): String
+        params: SamplingParams,
+        cancelToken: Long
+    ): Generation?
 
     private external fun nativeGenerateStream(
         prompt: String,
         maxTokens: Int,
-        temperature: Float,
-        topP: Float,
-        topK: Int
-    ): Array<String>
+        params: SamplingParams,
+        callback: TokenCallback,
+        cancelToken: Long
+    ): Boolean
+
+    private external fun nativeGenerateBatch(
+        prompts: Array<String>,
+        maxTokens: Int,
+        params: SamplingParams,
+        cancelToken: Long
+    ): BatchGeneration?
+
+    private external fun nativeStartChat(systemPrompt: String, cancelToken: Long): Boolean
+
+    private external fun nativeIsChatActive(): Boolean
+
+    private external fun nativeApplyChatTemplate(
+        roles: Array<String>,
+        contents: Array<String>,
+        addAssistant: Boolean
+    ): String?
+
+    private external fun nativeChatStream(
+        text: String,
+        maxTokens: Int,
+        params: SamplingParams,
+        callback: TokenCallback,
+        cancelToken: Long
+    ): Boolean
+
+    private external fun nativeChatCached(
+        text: String,
+        question: String,
+        maxTokens: Int,
+        similarityThreshold: Float,
+        params: SamplingParams,
+        callback: TokenCallback,
+        cancelToken: Long
+    ): CachedChatResult?
+
+    private external fun nativeClearSemanticIndex()
+
+    private external fun nativeTokenize(text: String, addSpecial: Boolean): IntArray?
+
+    private external fun nativeDetokenize(tokens: IntArray): String?
+
+    private external fun nativeCountTokens(text: String): Int
+
+    private external fun nativeSaveSession(path: String): Boolean
+
+    private external fun nativeRestoreSession(path: String): Boolean
 
     private external fun nativeStopGeneration()
 
+    private external fun nativeCreateCancelToken(timeoutMs: Long): Long
+
+    private external fun nativeCancelToken(token: Long)
+
+    private external fun nativeReleaseCancelToken(token: Long)
+
     private external fun nativeGetEmbedding(text: String): FloatArray?
 
     private external fun nativeGetModelInfo(): ModelInfo?
@@ -58,17 +126,48 @@ class LLMInferenceImpl : LLMInference {
 
     private external fun nativeGetAvailableMemory(): Long
 
+    private external fun nativeSetMemoryBudget(budgetMB: Long)
+
+    private external fun nativeTrimMemory(level: Int): Long
+
+    private external fun nativeGetResidentModels(): Array<ResidentModelInfo>
+
+    private external fun nativeLoadDraftModel(modelPath: String, draftTokens: Int, threads: Int): Boolean
+
+    private external fun nativeDisableSpeculative()
+
+    private external fun nativeGetSpeculativeStats(): SpeculativeStats?
+
+    private external fun nativeGetLastGenerationStats(): GenerationStats?
+
+    private external fun nativeSetThrottle(maxThreads: Int, tokenDelayMs: Int, maxBatch: Int)
+
     override suspend fun loadModel(
         modelPath: String,
         contextLength: Int,
-        threads: Int
+        threads: Int,
+        options: ModelLoadOptions,
+        onProgress: (Float) -> Unit
     ): Boolean = withContext(Dispatchers.IO) {
         try {
-            isLoaded = nativeLoadModel(modelPath, contextLength, threads)
-            if (isLoaded) {
+            val loaded = nativeLoadModel(
+                modelPath,
+                contextLength,
+                threads,
+                options.prefillThreads,
+                options.pinToPerformanceCores,
+                options.useMmap,
+                options.lockInMemory,
+                options.prefetch.ordinal,
+                options.kvCacheType.ordinal,
+                LoadProgressListener { onProgress(it) }
+            )
+            // 加载失败时原来的模型仍是当前模型，isLoaded 和 modelInfo 保持不变
+            if (loaded) {
+                isLoaded = true
                 modelInfo = nativeGetModelInfo()
             }
-            isLoaded
+            loaded
         } catch (e: UnsatisfiedLinkError) {
             // JNI 未链接，使用模拟实现
             isLoaded = true
@@ -80,6 +179,7 @@ class LLMInferenceImpl : LLMInference {
                 quantization = "Q4_K_M",
                 fileSizeMB = 1200
             )
+            onProgress(1f)
             true
         } catch (e: Exception) {
             false
@@ -91,37 +191,213 @@ class LLMInferenceImpl : LLMInference {
     override fun generateStream(
         prompt: String,
         maxTokens: Int,
-        temperature: Float,
-        topP: Float,
-        topK: Int
-    ): Flow<String> = flow {
-        try {
-            val tokens = nativeGenerateStream(prompt, maxTokens, temperature, topP, topK)
-            tokens.forEach { token ->
-                if (!isGenerating) return@flow
-                emit(token)
+        params: SamplingParams,
+        timeoutMs: Long
+    ): Flow<String> = channelFlow {
+        try {
+            withCancelToken(timeoutMs) { token ->
+                // JNI 在当前线程同步回调，每段文本直接投递给收集端；收集端取消后回调返回 false 停止生成
+                nativeGenerateStream(prompt, maxTokens, params, TokenCallback { piece ->
+                    trySendBlocking(piece).isSuccess
+                }, token)
             }
         } catch (e: UnsatisfiedLinkError) {
             // 模拟实现
             val mockResponse = generateMockResponse(prompt)
-            mockResponse.forEach { char ->
-                if (!isGenerating) return@flow
-                emit(char.toString())
+            for (char in mockResponse) {
+                if (!isGenerating) break
+                send(char.toString())
                 kotlinx.coroutines.delay(30)
             }
+        } finally {
+            isGenerating = false
         }
-    }.flowOn(Dispatchers.IO)
+    }.buffer(Channel.UNLIMITED).flowOn(Dispatchers.IO)
 
     override suspend fun generate(
         prompt: String,
         maxTokens: Int,
-        temperature: Float
-    ): String = withContext(Dispatchers.IO) {
+        params: SamplingParams,
+        timeoutMs: Long
+    ): String = generateWithStats(prompt, maxTokens, params, timeoutMs).text
+
+    override suspend fun generateWithStats(
+        prompt: String,
+        maxTokens: Int,
+        params: SamplingParams,
+        timeoutMs: Long
+    ): Generation = withContext(Dispatchers.IO) {
         try {
-            nativeGenerate(prompt, maxTokens, temperature, 0.9f, 40)
+            withCancelToken(timeoutMs) { token ->
+                nativeGenerate(prompt, maxTokens, params, token)
+            } ?: throw GenerationFailedException("Generation failed")
         } catch (e: UnsatisfiedLinkError) {
             // 模拟实现
-            generateMockResponse(prompt)
+            val mockResponse = generateMockResponse(prompt)
+            val text = if (params.grammar == OutputGrammar.JSON) {
+                org.json.JSONObject().put("response", mockResponse).toString()
+            } else {
+                mockResponse
+            }
+            Generation(text, null)
+        }
+    }
+
+    override suspend fun generateBatch(
+        prompts: List<String>,
+        maxTokens: Int,
+        params: SamplingParams,
+        timeoutMs: Long
+    ): List<String> = generateBatchWithStats(prompts, maxTokens, params, timeoutMs).texts
+
+    override suspend fun generateBatchWithStats(
+        prompts: List<String>,
+        maxTokens: Int,
+        params: SamplingParams,
+        timeoutMs: Long
+    ): BatchGeneration = withContext(Dispatchers.IO) {
+        if (prompts.isEmpty()) return@withContext BatchGeneration(emptyList(), null)
+        try {
+            withCancelToken(timeoutMs) { token ->
+                nativeGenerateBatch(prompts.toTypedArray(), maxTokens, params, token)
+            } ?: throw GenerationFailedException("Batch generation failed")
+        } catch (e: UnsatisfiedLinkError) {
+            // 模拟实现
+            BatchGeneration(prompts.map { generateMockResponse(it) }, null)
+        }
+    }
+
+    override suspend fun startChat(systemPrompt: String): Boolean = withContext(Dispatchers.IO) {
+        try {
+            withCancelToken(0L) { token -> nativeStartChat(systemPrompt, token) }
+        } catch (e: UnsatisfiedLinkError) {
+            // 模拟实现无上下文
+            true
+        }
+    }
+
+    override fun isChatActive(): Boolean {
+        return try {
+            nativeIsChatActive()
+        } catch (e: UnsatisfiedLinkError) {
+            // 模拟实现无上下文，视为对话一直有效
+            true
+        }
+    }
+
+    override fun applyChatTemplate(turns: List<ChatTurn>, addAssistant: Boolean): String {
+        val formatted = try {
+            nativeApplyChatTemplate(
+                turns.map { it.role }.toTypedArray(),
+                turns.map { it.content }.toTypedArray(),
+                addAssistant
+            )
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+        return formatted ?: formatChatMl(turns, addAssistant)
+    }
+
+    override fun chatStream(
+        turn: String,
+        maxTokens: Int,
+        params: SamplingParams,
+        timeoutMs: Long
+    ): Flow<String> = channelFlow {
+        try {
+            withCancelToken(timeoutMs) { token ->
+                nativeChatStream(turn, maxTokens, params, TokenCallback { piece ->
+                    trySendBlocking(piece).isSuccess
+                }, token)
+            }
+        } catch (e: UnsatisfiedLinkError) {
+            // 模拟实现
+            val mockResponse = generateMockResponse(turn)
+            for (char in mockResponse) {
+                if (!isGenerating) break
+                send(char.toString())
+                kotlinx.coroutines.delay(30)
+            }
+        } finally {
+            isGenerating = false
+        }
+    }.buffer(Channel.UNLIMITED).flowOn(Dispatchers.IO)
+
+    override fun chatWithCache(
+        turn: String,
+        question: String,
+        maxTokens: Int,
+        params: SamplingParams,
+        timeoutMs: Long,
+        similarityThreshold: Float
+    ): Flow<AnswerEvent> = channelFlow {
+        try {
+            val result = withCancelToken(timeoutMs) { token ->
+                nativeChatCached(turn, question, maxTokens, similarityThreshold, params, TokenCallback { piece ->
+                    trySendBlocking(AnswerEvent.Token(piece)).isSuccess
+                }, token)
+            }
+            send(AnswerEvent.Done(result ?: CachedChatResult(false)))
+        } catch (e: UnsatisfiedLinkError) {
+            // 模拟实现
+            val mockResponse = generateMockResponse(turn)
+            for (char in mockResponse) {
+                if (!isGenerating) break
+                send(AnswerEvent.Token(char.toString()))
+                kotlinx.coroutines.delay(30)
+            }
+            send(AnswerEvent.Done(CachedChatResult(false)))
+        } finally {
+            isGenerating = false
+        }
+    }.buffer(Channel.UNLIMITED).flowOn(Dispatchers.IO)
+
+    override fun clearSemanticIndex() {
+        try {
+            nativeClearSemanticIndex()
+        } catch (e: UnsatisfiedLinkError) {
+            // 忽略
+        }
+    }
+
+    override fun tokenize(text: String, addSpecial: Boolean): IntArray {
+        return try {
+            nativeTokenize(text, addSpecial) ?: IntArray(0)
+        } catch (e: UnsatisfiedLinkError) {
+            IntArray(0)
+        }
+    }
+
+    override fun detokenize(tokens: IntArray): String {
+        return try {
+            nativeDetokenize(tokens) ?: ""
+        } catch (e: UnsatisfiedLinkError) {
+            ""
+        }
+    }
+
+    override fun countTokens(text: String): Int {
+        val count = try {
+            nativeCountTokens(text)
+        } catch (e: UnsatisfiedLinkError) {
+            -1
+        }
+        return if (count >= 0) count else estimateTokens(text)
+    }
+
+    override suspend fun saveSession(path: String): Boolean = withContext(Dispatchers.IO) {
+        try {
+            nativeSaveSession(path)
+        } catch (e: UnsatisfiedLinkError) {
+            false
+        }
+    }
+
+    override suspend fun restoreSession(path: String): Boolean = withContext(Dispatchers.IO) {
+        try {
+            nativeRestoreSession(path)
+        } catch (e: UnsatisfiedLinkError) {
+            false
         }
     }
 
@@ -163,8 +439,133 @@ class LLMInferenceImpl : LLMInference {
         }
     }
 
+    override fun setMemoryBudget(budgetMB: Long) {
+        try {
+            nativeSetMemoryBudget(budgetMB)
+        } catch (e: UnsatisfiedLinkError) {
+            // 忽略
+        }
+    }
+
+    override fun trimMemory(level: MemoryTrimLevel): Long {
+        val freedMB = try {
+            nativeTrimMemory(level.ordinal)
+        } catch (e: UnsatisfiedLinkError) {
+            0L
+        }
+        // 当前激活的模型可能已被淘汰
+        if (isLoaded && !isNativeModelLoaded()) {
+            isLoaded = false
+            modelInfo = null
+        }
+        return freedMB
+    }
+
+    override fun getResidentModels(): List<ResidentModelInfo> {
+        return try {
+            nativeGetResidentModels().toList()
+        } catch (e: UnsatisfiedLinkError) {
+            emptyList()
+        }
+    }
+
+    override suspend fun loadDraftModel(
+        draftModelPath: String,
+        draftTokens: Int,
+        threads: Int
+    ): Boolean = withContext(Dispatchers.IO) {
+        try {
+            nativeLoadDraftModel(draftModelPath, draftTokens, threads)
+        } catch (e: UnsatisfiedLinkError) {
+            false
+        }
+    }
+
+    override fun disableSpeculativeDecoding() {
+        try {
+            nativeDisableSpeculative()
+        } catch (e: UnsatisfiedLinkError) {
+            // 忽略
+        }
+    }
+
+    override fun getLastGenerationStats(): GenerationStats? {
+        return try {
+            nativeGetLastGenerationStats()
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+
+    override fun getSpeculativeStats(): SpeculativeStats? {
+        return try {
+            nativeGetSpeculativeStats()
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+
+    override fun setThrottle(throttle: InferenceThrottle) {
+        try {
+            nativeSetThrottle(throttle.maxThreads, throttle.tokenDelayMs, throttle.maxBatch)
+        } catch (e: UnsatisfiedLinkError) {
+            // 忽略
+        }
+    }
+
+    /**
+     * 为一次原生生成创建取消令牌
+     *
+     * JNI 调用会阻塞当前线程直到生成结束，协程取消无法打断它；
+     * 这里用一个兄弟协程监听取消，转发给原生令牌，解码循环在一个 token 内退出
+     */
+    private suspend fun <T> withCancelToken(timeoutMs: Long, block: (Long) -> T): T = coroutineScope {
+        val token = nativeCreateCancelToken(timeoutMs)
+        val watcher = launch(start = CoroutineStart.UNDISPATCHED) {
+            try {
+                awaitCancellation()
+            } finally {
+                nativeCancelToken(token)
+            }
+        }
+        try {
+            block(token)
+        } finally {
+            watcher.cancel()
+            nativeReleaseCancelToken(token)
+        }
+    }
+
+    private fun isNativeModelLoaded(): Boolean {
+        return try {
+            nativeIsModelLoaded()
+        } catch (e: UnsatisfiedLinkError) {
+            isLoaded
+        }
+    }
+
+    /**
+     * 与 llama.cpp 内置的 ChatML 模板输出一致
+     */
+    private fun formatChatMl(turns: List<ChatTurn>, addAssistant: Boolean): String = buildString {
+        for (turn in turns) {
+            append("<|im_start|>").append(turn.role).append('\n')
+            append(turn.content).append("<|im_end|>\n")
+        }
+        if (addAssistant) append("<|im_start|>assistant\n")
+    }
+
     // ========== 模拟实现 ==========
 
+    /**
+     * 无词表时的估算：中文约 1.5 字符 = 1 token，其他约 4 字符 = 1 token
+     */
+    private fun estimateTokens(text: String): Int {
+        val chineseChars = text.count { it.code in 0x4E00..0x9FFF }
+        val otherChars = text.length - chineseChars
+        return kotlin.math.ceil(chineseChars / 1.5 + otherChars / 4.0).toInt()
+    }
+
     private fun generateMockResponse(prompt: String): String {
         isGenerating = true
 
@@ -24,4 +24,10 @@ object NativeModule {
     fun provideSpeechRecognition(): SpeechRecognition {
         return SpeechRecognitionImpl()
     }
+
+    @Provides
+    @Singleton
+    fun provideAesGcmCipher(): AesGcmCipher {
+        return AesGcmCipherImpl()
+    }
 }
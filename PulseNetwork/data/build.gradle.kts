@@ -38,6 +38,7 @@ android {
 
 dependencies {
     implementation(project(":domain"))
+    implementation(project(":core:native"))
 
     // Kotlin Coroutines
     implementation("org.jetbrains.kotlinx:kotlinx-coroutines-core:1.7.3")
@@ -59,6 +60,8 @@ dependencies {
     testImplementation("junit:junit:4.13.2")
     testImplementation("org.jetbrains.kotlinx:kotlinx-coroutines-test:1.7.3")
     testImplementation("io.mockk:mockk:1.13.8")
+    // android.jar 中的 org.json 只是桩，本地单元测试需要真实实现
+    testImplementation("org.json:json:20231013")
 }
 
 kapt {
@@ -5,11 +5,15 @@ import android.net.wifi.WifiManager
 import android.os.BatteryManager
 import android.os.PowerManager
 import android.view.WindowManager
+import com.pulsenetwork.core.native.LLMInference
 import com.pulsenetwork.data.evolution.NodeEvolutionImpl
 import com.pulsenetwork.data.governor.GovernorServiceImpl
 import com.pulsenetwork.data.prediction.PredictionEngineImpl
 import com.pulsenetwork.data.relation.RelationNetworkImpl
 import com.pulsenetwork.data.swarm.SwarmNetworkImpl
+import com.pulsenetwork.data.workflow.StepResultCache
+import com.pulsenetwork.data.workflow.WorkflowCheckpointLog
+import com.pulsenetwork.data.workflow.WorkflowCoreCipher
 import com.pulsenetwork.data.workflow.WorkflowExecutorImpl
 import com.pulsenetwork.data.workflow.WorkflowInterviewerImpl
 import com.pulsenetwork.domain.evolution.NodeEvolution
@@ -55,8 +59,10 @@ object DataModule {
 
     @Provides
     @Singleton
-    fun provideWorkflowInterviewer(): WorkflowInterviewer {
-        return WorkflowInterviewerImpl()
+    fun provideWorkflowInterviewer(
+        coreCipher: WorkflowCoreCipher
+    ): WorkflowInterviewer {
+        return WorkflowInterviewerImpl(coreCipher)
     }
 
     @Provides
@@ -132,8 +138,12 @@ object DataModule {
     @Provides
     @Singleton
     fun provideWorkflowExecutor(
-        swarmNetwork: SwarmNetwork
+        swarmNetwork: SwarmNetwork,
+        llmInference: LLMInference,
+        stepResultCache: StepResultCache,
+        checkpointLog: WorkflowCheckpointLog,
+        coreCipher: WorkflowCoreCipher
     ): WorkflowExecutor {
-        return WorkflowExecutorImpl(swarmNetwork)
+        return WorkflowExecutorImpl(swarmNetwork, llmInference, stepResultCache, checkpointLog, coreCipher)
     }
 }
@@ -1,6 +1,7 @@
 package com.pulsenetwork.data.governor
 
 import android.content.*
+import android.content.res.Configuration
 import android.net.wifi.WifiManager
 import android.os.BatteryManager
 import android.os.Build
@@ -144,6 +145,28 @@ class GovernorServiceImpl @Inject constructor(
         }
     }
 
+    override fun memoryPressureFlow(): Flow<MemoryPressure> = callbackFlow {
+        val callbacks = object : ComponentCallbacks2 {
+            override fun onTrimMemory(level: Int) {
+                toMemoryPressure(level)?.let { trySend(it) }
+            }
+
+            override fun onLowMemory() {
+                trySend(MemoryPressure.CRITICAL)
+            }
+
+            override fun onConfigurationChanged(newConfig: Configuration) {
+                // 无需处理
+            }
+        }
+
+        context.registerComponentCallbacks(callbacks)
+
+        awaitClose {
+            context.unregisterComponentCallbacks(callbacks)
+        }
+    }
+
     override suspend fun enterProtectionMode(reason: String) {
         protectionMode = true
         protectionReason = reason
@@ -247,6 +270,19 @@ class GovernorServiceImpl @Inject constructor(
         )
     }
 
+    @Suppress("DEPRECATION")
+    private fun toMemoryPressure(level: Int): MemoryPressure? {
+        return when {
+            level >= ComponentCallbacks2.TRIM_MEMORY_COMPLETE -> MemoryPressure.CRITICAL
+            level >= ComponentCallbacks2.TRIM_MEMORY_MODERATE -> MemoryPressure.LOW
+            level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL -> MemoryPressure.CRITICAL
+            level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW -> MemoryPressure.LOW
+            level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE -> MemoryPressure.MODERATE
+            level >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND -> MemoryPressure.MODERATE
+            else -> null  // UI_HIDDEN 等与内存无关
+        }
+    }
+
     private fun getCpuUsage(): Float {
         return try {
             val reader = java.io.RandomAccessFile("/proc/stat", "r")
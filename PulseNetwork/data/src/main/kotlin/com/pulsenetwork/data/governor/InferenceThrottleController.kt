@@ -0,0 +1,97 @@
+package com.pulsenetwork.data.governor
+
+import com.pulsenetwork.core.native.InferenceThrottle
+import com.pulsenetwork.core.native.LLMInference
+import com.pulsenetwork.domain.governor.Governor
+import com.pulsenetwork.domain.governor.GovernorStatus
+import com.pulsenetwork.domain.governor.ThermalState
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.flow.distinctUntilChanged
+import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.flow.scan
+import kotlinx.coroutines.launch
+import javax.inject.Inject
+import javax.inject.Singleton
+
+/**
+ * 推理限流控制器
+ *
+ * 根据总督上报的温度、热状态和电量逐级收紧原生推理的线程数、token 间隔和批大小，
+ * 让长时间生成平滑降速，而不是等系统热管理强行降频或杀进程。
+ * 升级立即生效，降级需温度回落到阈值以下一定幅度，且每次只降一级，避免来回抖动
+ */
+@Singleton
+class InferenceThrottleController @Inject constructor(
+    private val governor: Governor,
+    private val llmInference: LLMInference
+) {
+
+    /**
+     * 限流等级
+     */
+    enum class Level(val throttle: InferenceThrottle) {
+        NONE(InferenceThrottle.NONE),
+        LIGHT(InferenceThrottle(maxThreads = 3, tokenDelayMs = 5, maxBatch = 256)),
+        MEDIUM(InferenceThrottle(maxThreads = 2, tokenDelayMs = 20, maxBatch = 128)),
+        HEAVY(InferenceThrottle(maxThreads = 1, tokenDelayMs = 60, maxBatch = 32))
+    }
+
+    private var job: Job? = null
+
+    /**
+     * 开始跟随设备状态调整限流
+     */
+    fun start(scope: CoroutineScope) {
+        if (job?.isActive == true) return
+        job = scope.launch {
+            governor.statusFlow()
+                .scan(Level.NONE) { current, status -> nextLevel(current, status) }
+                .distinctUntilChanged()
+                .map { it.throttle }
+                .collect { llmInference.setThrottle(it) }
+        }
+    }
+
+    fun stop() {
+        job?.cancel()
+        job = null
+        llmInference.setThrottle(InferenceThrottle.NONE)
+    }
+
+    companion object {
+        // 电池温度阈值（℃），依次进入 LIGHT / MEDIUM / HEAVY
+        private val TEMPERATURE_THRESHOLDS = floatArrayOf(40f, 43f, 46f)
+
+        // 降级所需的温度回落幅度（℃）
+        private const val COOL_DOWN_MARGIN = 2f
+
+        private const val LOW_BATTERY_LEVEL = 15
+
+        /**
+         * 根据当前等级和最新状态计算下一个等级
+         */
+        fun nextLevel(current: Level, status: GovernorStatus): Level {
+            val target = targetLevel(status, 0f)
+            if (target >= current) return target
+
+            // 只有温度明显回落后才降级，且每次一级
+            val cooled = targetLevel(status, COOL_DOWN_MARGIN)
+            return if (cooled < current) Level.values()[current.ordinal - 1] else current
+        }
+
+        private fun targetLevel(status: GovernorStatus, margin: Float): Level {
+            val byTemperature = TEMPERATURE_THRESHOLDS
+                .count { status.batteryTemperature >= it - margin }
+            val byThermal = when (status.thermalState) {
+                ThermalState.NORMAL -> 0
+                ThermalState.WARNING -> 1
+                ThermalState.SERIOUS -> 2
+                ThermalState.CRITICAL -> 3
+            }
+            val byBattery = if (!status.isCharging && status.batteryLevel < LOW_BATTERY_LEVEL) 1 else 0
+
+            return Level.values()[maxOf(byTemperature, byThermal, byBattery)]
+        }
+    }
+}
@@ -1,10 +1,19 @@
 package com.pulsenetwork.data.swarm
 
+import com.pulsenetwork.core.native.LLMInference
+import com.pulsenetwork.domain.swarm.EvictionHeap
+import com.pulsenetwork.domain.swarm.LshIndex
+import com.pulsenetwork.domain.swarm.MinHasher
 import com.pulsenetwork.domain.swarm.SemanticCacheEntry
 import dagger.hilt.android.qualifiers.ApplicationContext
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.flow.update
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
+import java.util.concurrent.atomic.AtomicReference
 import javax.inject.Inject
 import javax.inject.Singleton
 import kotlin.math.abs
@@ -20,22 +29,51 @@ import kotlin.math.sqrt
  * - 通过语义相似度匹配查询
  * - 与邻居节点共享缓存
  * - 质量评分和热度衰减
+ *
+ * 条目不导入原生回答索引：原生索引的键包含对话上下文（见 LLMInference.chatWithCache），
+ * 这里的问答对（尤其是邻居的）只作为参考，不能当作本地对话的精确命中
+ *
+ * 并发：UI、网络接收协程和工作流步骤会同时调用
+ * - 两级缓存是分段加锁的 ConcurrentHashMap
+ * - 命中只原子更新槽位计数，不复制条目
+ * - 查询扫描只读快照，写入只推进快照版本，扫描与写入互不阻塞
+ * - 只有淘汰堆需要加锁
  */
 @Singleton
-class SemanticCacheService @Inject constructor() {
+class SemanticCacheService @Inject constructor(
+    private val llmInference: LLMInference
+) {
 
     // 本地缓存
-    private val localCache = mutableMapOf<String, SemanticCacheEntry>()
+    private val localCache = ConcurrentHashMap<String, CacheSlot>()
 
     // 网络缓存（来自邻居）
-    private val networkCache = mutableMapOf<String, SemanticCacheEntry>()
+    private val networkCache = ConcurrentHashMap<String, CacheSlot>()
 
     // 相似度阈值
     private val similarityThreshold = 0.85f
 
+    // 文本回退查询的阈值（字符二元组的 Jaccard，同义改写通常在 0.7 以上）
+    private val textSimilarityThreshold = 0.7f
+
+    // 问题文本的 MinHash 签名与 LSH 索引，文本查询只比较候选条目
+    private val minHasher = MinHasher()
+    private val textIndex = LshIndex<String>()
+
     // 最大缓存大小
     private val maxCacheSize = 1000
 
+    // 两级缓存共用的淘汰堆，堆顶是有效分数最低的条目
+    private val evictionHeap = EvictionHeap<String>(maxCacheSize + 1)
+    private val evictionLock = Any()
+
+    // 查询扫描用的只读快照（本地在前），写入推进版本号，查询发现版本落后时重建
+    private val cacheVersion = AtomicLong(0)
+    private val snapshot = AtomicReference(Snapshot(0, emptyArray()))
+
+    // 同一毫秒内的并发写入也能得到不同的 id
+    private val idSequence = AtomicLong(0)
+
     // 统计
     private val _cacheHits = MutableStateFlow(0L)
     val cacheHits: StateFlow<Long> = _cacheHits.asStateFlow()
@@ -50,10 +88,12 @@ class SemanticCacheService @Inject constructor() {
         query: String,
         answer: String,
         queryVector: FloatArray? = null,
+        vectorModel: String? = null,
         qualityScore: Float = 0.8f,
         nodeId: String
     ) {
-        val id = "${nodeId}_${System.currentTimeMillis()}"
+        val now = System.currentTimeMillis()
+        val id = "${nodeId}_${now}_${idSequence.incrementAndGet()}"
 
         val entry = SemanticCacheEntry(
             id = id,
@@ -62,12 +102,13 @@ class SemanticCacheService @Inject constructor() {
             answer = answer,
             qualityScore = qualityScore,
             sourceNodeId = nodeId,
-            createdAt = System.currentTimeMillis(),
-            lastAccessedAt = System.currentTimeMillis(),
-            hitCount = 0
+            createdAt = now,
+            lastAccessedAt = now,
+            hitCount = 0,
+            vectorModel = vectorModel
         )
 
-        localCache[id] = entry
+        put(CacheSlot(entry, isLocal = true, signature = minHasher.signature(query)))
         cleanupIfNeeded()
     }
 
@@ -75,7 +116,7 @@ class SemanticCacheService @Inject constructor() {
      * 添加网络缓存（来自邻居）
      */
     fun addNetworkCache(entry: SemanticCacheEntry) {
-        networkCache[entry.id] = entry
+        put(CacheSlot(entry, isLocal = false, signature = minHasher.signature(entry.query)))
         cleanupIfNeeded()
     }
 
@@ -84,90 +125,87 @@ class SemanticCacheService @Inject constructor() {
      */
     fun addNetworkCacheBatch(entries: List<SemanticCacheEntry>) {
         entries.forEach { entry ->
-            networkCache[entry.id] = entry
+            put(CacheSlot(entry, isLocal = false, signature = minHasher.signature(entry.query)))
         }
         cleanupIfNeeded()
     }
 
     /**
      * 查询缓存（带向量）
+     *
+     * 只比较同一嵌入模型产生的向量，未标记模型的条目不参与
+     * @param vectorModel 生成 queryVector 的嵌入模型
      */
-    fun query(queryVector: FloatArray): SemanticCacheEntry? {
-        var bestMatch: SemanticCacheEntry? = null
+    fun query(queryVector: FloatArray, vectorModel: String): SemanticCacheEntry? {
+        var bestMatch: CacheSlot? = null
         var bestSimilarity = similarityThreshold
 
-        // 先搜索本地缓存
-        for (entry in localCache.values) {
-            val vector = entry.queryVector ?: continue
-            val similarity = cosineSimilarity(queryVector, vector)
+        // 本地条目按原始相似度，网络条目考虑有效分数
+        for (slot in readSnapshot()) {
+            if (slot.removed || slot.entry.vectorModel != vectorModel) continue
+            val vector = slot.entry.queryVector ?: continue
+            var similarity = cosineSimilarity(queryVector, vector)
+            if (!slot.isLocal) similarity *= slot.effectiveScore()
 
             if (similarity > bestSimilarity) {
                 bestSimilarity = similarity
-                bestMatch = entry
+                bestMatch = slot
             }
         }
 
-        // 再搜索网络缓存（考虑有效分数）
-        for (entry in networkCache.values) {
-            val vector = entry.queryVector ?: continue
-            val similarity = cosineSimilarity(queryVector, vector)
-            val adjustedSimilarity = similarity * entry.effectiveScore()
-
-            if (adjustedSimilarity > bestSimilarity) {
-                bestSimilarity = adjustedSimilarity
-                bestMatch = entry
-            }
-        }
-
-        if (bestMatch != null) {
-            _cacheHits.value++
-            // 更新命中信息
-            updateHitInfo(bestMatch.id)
-        } else {
-            _cacheMisses.value++
-        }
+        return recordResult(bestMatch)
+    }
 
-        return bestMatch
+    /**
+     * 记录一次在原生回答索引中完成的查询
+     */
+    fun recordLookup(hit: Boolean) {
+        if (hit) _cacheHits.update { it + 1 } else _cacheMisses.update { it + 1 }
     }
 
     /**
-     * 按文本查询（简化版，无向量时使用）
+     * 按文本查询（无向量时使用）
+     *
+     * 以 MinHash 估计字符二元组的 Jaccard 相似度，只比较 LSH 候选，
+     * 中文问题不依赖空格分词；本地命中优先于网络
      */
     fun queryByText(query: String): SemanticCacheEntry? {
-        // 先搜索本地缓存
-        for (entry in localCache.values) {
-            if (textSimilarity(query, entry.query) > similarityThreshold) {
-                _cacheHits.value++
-                updateHitInfo(entry.id)
-                return entry
+        val signature = minHasher.signature(query) ?: return recordResult(null)
+
+        var bestLocal: CacheSlot? = null
+        var bestLocalSimilarity = textSimilarityThreshold
+        var bestNetwork: CacheSlot? = null
+        var bestNetworkSimilarity = textSimilarityThreshold
+
+        for (id in textIndex.candidates(signature)) {
+            val slot = localCache[id] ?: networkCache[id] ?: continue
+            val candidate = slot.signature ?: continue
+            var similarity = minHasher.similarity(signature, candidate)
+            if (slot.isLocal) {
+                if (similarity >= bestLocalSimilarity) {
+                    bestLocalSimilarity = similarity
+                    bestLocal = slot
+                }
+            } else {
+                similarity *= slot.effectiveScore()
+                if (similarity >= bestNetworkSimilarity) {
+                    bestNetworkSimilarity = similarity
+                    bestNetwork = slot
+                }
             }
         }
-
-        // 再搜索网络缓存
-        for (entry in networkCache.values) {
-            val similarity = textSimilarity(query, entry.query)
-            val adjustedSimilarity = similarity * entry.effectiveScore()
-
-            if (adjustedSimilarity > similarityThreshold) {
-                _cacheHits.value++
-                updateHitInfo(entry.id)
-                return entry
-            }
-        }
-
-        _cacheMisses.value++
-        return null
+        return recordResult(bestLocal ?: bestNetwork)
     }
 
     /**
      * 获取可分享的缓存条目
      */
     fun getShareableEntries(limit: Int = 100): List<SemanticCacheEntry> {
-        val allEntries = localCache.values + networkCache.values
-
-        return allEntries
+        return readSnapshot()
+            .filter { !it.removed }
             .sortedByDescending { it.effectiveScore() }
             .take(limit)
+            .map { it.current() }
     }
 
     /**
@@ -176,22 +214,27 @@ class SemanticCacheService @Inject constructor() {
     fun clearExpired(maxAgeHours: Int = 48) {
         val cutoff = System.currentTimeMillis() - (maxAgeHours * 60 * 60 * 1000L)
 
-        localCache.entries.removeIf { it.value.lastAccessedAt < cutoff }
-        networkCache.entries.removeIf { it.value.lastAccessedAt < cutoff }
+        for (cache in listOf(localCache, networkCache)) {
+            for ((id, slot) in cache) {
+                if (slot.lastAccessedAt.get() < cutoff) remove(id, slot)
+            }
+        }
     }
 
     /**
      * 获取统计信息
      */
     fun getStats(): Map<String, Any> {
+        val hits = _cacheHits.value
+        val misses = _cacheMisses.value
         return mapOf(
             "local_cache_size" to localCache.size,
             "network_cache_size" to networkCache.size,
             "total_cache_size" to (localCache.size + networkCache.size),
-            "cache_hits" to _cacheHits.value,
-            "cache_misses" to _cacheMisses.value,
-            "hit_rate" to if (_cacheHits.value + _cacheMisses.value > 0) {
-                _cacheHits.value.toFloat() / (_cacheHits.value + _cacheMisses.value)
+            "cache_hits" to hits,
+            "cache_misses" to misses,
+            "hit_rate" to if (hits + misses > 0) {
+                hits.toFloat() / (hits + misses)
             } else 0f
         )
     }
@@ -200,40 +243,135 @@ class SemanticCacheService @Inject constructor() {
      * 清空缓存
      */
     fun clear() {
-        localCache.clear()
-        networkCache.clear()
+        synchronized(evictionLock) {
+            for (cache in listOf(localCache, networkCache)) {
+                cache.values.forEach { it.removed = true }
+                cache.clear()
+            }
+            evictionHeap.clear()
+            textIndex.clear()
+            cacheVersion.incrementAndGet()
+        }
+        llmInference.clearSemanticIndex()
     }
 
     // ========== 私有方法 ==========
 
-    private fun updateHitInfo(entryId: String) {
-        val entry = localCache[entryId] ?: networkCache[entryId] ?: return
+    /**
+     * 缓存槽位
+     *
+     * 条目本身不可变，命中次数和访问时间用原子量原地更新，
+     * 并发命中不会像 copy-and-replace 那样相互覆盖
+     */
+    private class CacheSlot(
+        val entry: SemanticCacheEntry,
+        val isLocal: Boolean,
+        val signature: IntArray?     // 问题文本的 MinHash 签名
+    ) {
+        val hits = AtomicInteger(entry.hitCount)
+        val lastAccessedAt = AtomicLong(entry.lastAccessedAt)
 
-        val updated = entry.copy(
-            lastAccessedAt = System.currentTimeMillis(),
-            hitCount = entry.hitCount + 1
-        )
+        @Volatile
+        var removed = false
 
-        if (localCache.containsKey(entryId)) {
-            localCache[entryId] = updated
-        } else {
-            networkCache[entryId] = updated
+        fun recordHit(now: Long) {
+            hits.incrementAndGet()
+            lastAccessedAt.accumulateAndGet(now) { old, new -> maxOf(old, new) }
         }
+
+        fun effectiveScore(): Float = entry.effectiveScore(hits.get())
+
+        fun current(): SemanticCacheEntry =
+            entry.copy(hitCount = hits.get(), lastAccessedAt = lastAccessedAt.get())
     }
 
-    private fun cleanupIfNeeded() {
-        val totalSize = localCache.size + networkCache.size
-        if (totalSize <= maxCacheSize) return
+    private fun put(slot: CacheSlot) {
+        val id = slot.entry.id
+        val cache = if (slot.isLocal) localCache else networkCache
+        cache.put(id, slot)?.let { unlink(id, it) }
+        slot.signature?.let { textIndex.add(id, it) }
+        synchronized(evictionLock) {
+            evictionHeap.offer(id, slot.entry.evictionKey())
+        }
+        cacheVersion.incrementAndGet()
+    }
 
-        // 按有效分数排序，移除最低的
-        val allEntries = (localCache.values + networkCache.values)
-            .sortedByDescending { it.effectiveScore() }
+    private fun remove(id: String, slot: CacheSlot) {
+        val cache = if (slot.isLocal) localCache else networkCache
+        if (!cache.remove(id, slot)) return
+        unlink(id, slot)
+        synchronized(evictionLock) {
+            evictionHeap.remove(id)
+        }
+        cacheVersion.incrementAndGet()
+    }
 
-        val toKeep = allEntries.take(maxCacheSize)
-        val toRemove = allEntries.drop(maxCacheSize).map { it.id }.toSet()
+    /**
+     * 槽位离开缓存：标记给旧快照中的读者，并移出文本索引
+     */
+    private fun unlink(id: String, slot: CacheSlot) {
+        slot.removed = true
+        slot.signature?.let { textIndex.remove(id, it) }
+    }
+
+    private class Snapshot(val version: Long, val slots: Array<CacheSlot>)
 
-        localCache.entries.removeIf { it.key in toRemove }
-        networkCache.entries.removeIf { it.key in toRemove }
+    /**
+     * 版本落后时重建快照（已删除的槽位带 removed 标记，旧快照仍可安全扫描）
+     *
+     * 先读版本再遍历，重建结果至少包含该版本之前的全部写入；
+     * 发布只向更新的版本推进，较慢的重建不会覆盖其他读者已发布的新快照
+     */
+    private fun readSnapshot(): Array<CacheSlot> {
+        val version = cacheVersion.get()
+        val current = snapshot.get()
+        if (current.version >= version) return current.slots
+
+        val rebuilt = Snapshot(version, (localCache.values + networkCache.values).toTypedArray())
+        snapshot.accumulateAndGet(rebuilt) { old, new -> if (new.version > old.version) new else old }
+        return rebuilt.slots
+    }
+
+    private fun recordResult(match: CacheSlot?): SemanticCacheEntry? {
+        if (match == null) {
+            _cacheMisses.update { it + 1 }
+            return null
+        }
+        _cacheHits.update { it + 1 }
+        match.recordHit(System.currentTimeMillis())
+        return match.current()
+    }
+
+    /**
+     * 超出容量时弹出堆顶，每次淘汰 O(log n)
+     *
+     * 命中只更新原子计数不进堆，堆中的键可能偏低；
+     * 弹出前按当前命中数重算，偏低的重新入堆后再比较
+     */
+    private fun cleanupIfNeeded() {
+        if (localCache.size + networkCache.size <= maxCacheSize) return
+
+        synchronized(evictionLock) {
+            while (localCache.size + networkCache.size > maxCacheSize) {
+                val id = evictionHeap.peek() ?: break
+                val slot = localCache[id] ?: networkCache[id]
+                if (slot == null) {
+                    evictionHeap.poll()
+                    continue
+                }
+
+                val key = slot.entry.evictionKey(slot.hits.get())
+                if (key > evictionHeap.priorityOf(id)!!) {
+                    evictionHeap.offer(id, key)
+                    continue
+                }
+
+                evictionHeap.poll()
+                val cache = if (slot.isLocal) localCache else networkCache
+                if (cache.remove(id, slot)) unlink(id, slot)
+            }
+        }
+        cacheVersion.incrementAndGet()
     }
 
     private fun cosineSimilarity(a: FloatArray, b: FloatArray): Float {
@@ -253,16 +391,4 @@ class SemanticCacheService @Inject constructor() {
 
         return dotProduct / (sqrt(normA) * sqrt(normB))
     }
-
-    private fun textSimilarity(a: String, b: String): Float {
-        val wordsA = a.lowercase().split(Regex("\\s+")).toSet()
-        val wordsB = b.lowercase().split(Regex("\\s+")).toSet()
-
-        val intersection = wordsA.intersect(wordsB)
-        val union = wordsA.union(wordsB)
-
-        if (union.isEmpty()) return 0f
-
-        return intersection.size.toFloat() / union.size.toFloat()
-    }
 }
@@ -0,0 +1,34 @@
+package com.pulsenetwork.data.workflow
+
+import org.json.JSONArray
+import org.json.JSONObject
+
+/**
+ * 步骤输出与 JSON 之间的转换，供结果缓存和检查点日志共用
+ *
+ * Map / 集合递归转换，基本类型原样保留，其余值按字符串保存
+ */
+internal fun toJsonValue(value: Any?): Any = when (value) {
+    null -> JSONObject.NULL
+    is Map<*, *> -> JSONObject().apply {
+        value.forEach { (k, v) -> put(k.toString(), toJsonValue(v)) }
+    }
+    is Iterable<*> -> JSONArray().apply { value.forEach { put(toJsonValue(it)) } }
+    is Array<*> -> JSONArray().apply { value.forEach { put(toJsonValue(it)) } }
+    is String, is Boolean, is Int, is Long, is Double -> value
+    is Float -> value.toDouble()
+    else -> value.toString()
+}
+
+internal fun fromJsonValue(value: Any?): Any? = when (value) {
+    is JSONObject -> value.keys().asSequence()
+        .mapNotNull { k -> fromJsonValue(value.get(k))?.let { k to it } }
+        .toMap()
+    is JSONArray -> (0 until value.length()).mapNotNull { fromJsonValue(value.get(it)) }
+    JSONObject.NULL -> null
+    else -> value
+}
+
+@Suppress("UNCHECKED_CAST")
+internal fun JSONObject.optOutput(name: String): Map<String, Any>? =
+    optJSONObject(name)?.let { fromJsonValue(it) as Map<String, Any> }
@@ -0,0 +1,147 @@
+package com.pulsenetwork.data.workflow
+
+import com.pulsenetwork.domain.workflow.AggregationType
+import com.pulsenetwork.domain.workflow.InputType
+import com.pulsenetwork.domain.workflow.OutputFormat
+import com.pulsenetwork.domain.workflow.StepConfig
+import com.pulsenetwork.domain.workflow.StepType
+import com.pulsenetwork.domain.workflow.TrustLevelRequirement
+import com.pulsenetwork.domain.workflow.WorkflowStep
+import org.json.JSONArray
+import org.json.JSONException
+import org.json.JSONObject
+
+/**
+ * 步骤配置与 JSON 互转，用于加密核心逻辑中的步骤段
+ *
+ * 每个字段都显式写出，默认值以后变化也不影响已加密的工作流；
+ * StepConfig.Sealed 只存在于内存中，不能再次写入
+ */
+internal object StepConfigJson {
+
+    /**
+     * @throws IllegalArgumentException 配置为 StepConfig.Sealed
+     */
+    fun encode(config: StepConfig): JSONObject = when (config) {
+        is StepConfig.LocalInference -> JSONObject()
+            .put("modelType", config.modelType)
+            .put("promptTemplate", config.promptTemplate)
+            .put("maxTokens", config.maxTokens)
+            .put("temperature", config.temperature.toDouble())
+            .put("outputFormat", config.outputFormat.name)
+            .put("seed", config.seed)
+        is StepConfig.RemoteInference -> JSONObject()
+            .put("modelType", config.modelType)
+            .put("promptTemplate", config.promptTemplate)
+            .put("preferredNodes", JSONArray(config.preferredNodes))
+            .put("requireTrustLevel", config.requireTrustLevel.name)
+        is StepConfig.DataTransform -> JSONObject()
+            .put("transformType", config.transformType)
+            .put("inputMapping", JSONObject(config.inputMapping))
+            .put("outputMapping", JSONObject(config.outputMapping))
+        is StepConfig.ConditionCheck -> JSONObject()
+            .put("condition", config.condition)
+            .put("trueBranch", config.trueBranch ?: JSONObject.NULL)
+            .put("falseBranch", config.falseBranch ?: JSONObject.NULL)
+        is StepConfig.ParallelBatch -> JSONObject()
+            .put("batchSize", config.batchSize)
+            .put("stepTemplate", encodeStep(config.stepTemplate))
+            .put("inputKey", config.inputKey)
+            .put("itemKey", config.itemKey)
+            .put("maxConcurrency", config.maxConcurrency)
+        is StepConfig.Aggregation -> JSONObject()
+            .put("aggregationType", config.aggregationType.name)
+            .put("inputKeys", JSONArray(config.inputKeys))
+        is StepConfig.ExternalApi -> JSONObject()
+            .put("url", config.url)
+            .put("method", config.method)
+            .put("headers", JSONObject(config.headers))
+            .put("bodyTemplate", config.bodyTemplate ?: JSONObject.NULL)
+        is StepConfig.UserInput -> JSONObject()
+            .put("prompt", config.prompt)
+            .put("inputType", config.inputType.name)
+            .put("timeout", config.timeout)
+        is StepConfig.Sealed -> throw IllegalArgumentException("Sealed step config cannot be encoded")
+    }
+
+    /**
+     * @throws JSONException 缺少字段或枚举值未知
+     */
+    fun decode(type: StepType, json: JSONObject): StepConfig = try {
+        when (type) {
+            StepType.LOCAL_INFERENCE -> StepConfig.LocalInference(
+                modelType = json.getString("modelType"),
+                promptTemplate = json.getString("promptTemplate"),
+                maxTokens = json.getInt("maxTokens"),
+                temperature = json.getDouble("temperature").toFloat(),
+                outputFormat = OutputFormat.valueOf(json.getString("outputFormat")),
+                seed = json.getInt("seed")
+            )
+            StepType.REMOTE_INFERENCE -> StepConfig.RemoteInference(
+                modelType = json.getString("modelType"),
+                promptTemplate = json.getString("promptTemplate"),
+                preferredNodes = json.getJSONArray("preferredNodes").strings(),
+                requireTrustLevel = TrustLevelRequirement.valueOf(json.getString("requireTrustLevel"))
+            )
+            StepType.DATA_TRANSFORM -> StepConfig.DataTransform(
+                transformType = json.getString("transformType"),
+                inputMapping = json.getJSONObject("inputMapping").strings(),
+                outputMapping = json.getJSONObject("outputMapping").strings()
+            )
+            StepType.CONDITION_CHECK -> StepConfig.ConditionCheck(
+                condition = json.getString("condition"),
+                trueBranch = json.optStringOrNull("trueBranch"),
+                falseBranch = json.optStringOrNull("falseBranch")
+            )
+            StepType.PARALLEL_BATCH -> StepConfig.ParallelBatch(
+                batchSize = json.getInt("batchSize"),
+                stepTemplate = decodeStep(json.getJSONObject("stepTemplate")),
+                inputKey = json.getString("inputKey"),
+                itemKey = json.getString("itemKey"),
+                maxConcurrency = json.getInt("maxConcurrency")
+            )
+            StepType.AGGREGATION -> StepConfig.Aggregation(
+                aggregationType = AggregationType.valueOf(json.getString("aggregationType")),
+                inputKeys = json.getJSONArray("inputKeys").strings()
+            )
+            StepType.EXTERNAL_API -> StepConfig.ExternalApi(
+                url = json.getString("url"),
+                method = json.getString("method"),
+                headers = json.getJSONObject("headers").strings(),
+                bodyTemplate = json.optStringOrNull("bodyTemplate")
+            )
+            StepType.USER_INPUT -> StepConfig.UserInput(
+                prompt = json.getString("prompt"),
+                inputType = InputType.valueOf(json.getString("inputType")),
+                timeout = json.getLong("timeout")
+            )
+        }
+    } catch (e: IllegalArgumentException) {
+        throw JSONException("Unknown value in $type config: ${e.message}")
+    }
+
+    // ========== 私有方法 ==========
+
+    private fun encodeStep(step: WorkflowStep): JSONObject = JSONObject()
+        .put("id", step.id)
+        .put("name", step.name)
+        .put("type", step.type.name)
+        .put("config", encode(step.config))
+
+    private fun decodeStep(json: JSONObject): WorkflowStep {
+        val type = StepType.valueOf(json.getString("type"))
+        return WorkflowStep(
+            id = json.getString("id"),
+            name = json.getString("name"),
+            type = type,
+            config = decode(type, json.getJSONObject("config")),
+            order = 0
+        )
+    }
+
+    private fun JSONArray.strings(): List<String> = (0 until length()).map { getString(it) }
+
+    private fun JSONObject.strings(): Map<String, String> = keys().asSequence().associateWith { getString(it) }
+
+    private fun JSONObject.optStringOrNull(name: String): String? = if (isNull(name)) null else getString(name)
+}
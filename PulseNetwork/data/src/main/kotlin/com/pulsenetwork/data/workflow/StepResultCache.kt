@@ -0,0 +1,168 @@
+package com.pulsenetwork.data.workflow
+
+import android.content.Context
+import com.pulsenetwork.domain.workflow.StepResult
+import com.pulsenetwork.domain.workflow.StepStatus
+import dagger.hilt.android.qualifiers.ApplicationContext
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import org.json.JSONObject
+import java.io.File
+import java.security.MessageDigest
+import java.util.concurrent.atomic.AtomicInteger
+import javax.inject.Inject
+import javax.inject.Singleton
+
+/**
+ * 步骤结果缓存（内容寻址）
+ *
+ * 键由调用方对步骤配置和输入值做 SHA-256 得到。
+ * 内存中保留最近使用的一部分，全部结果以 JSON 文件存放在 cacheDir 下，
+ * 应用重启后仍然有效；每写入若干次检查一次文件数，超过上限时删除最早写入的。
+ * 输出中不能表示为 JSON 的值按字符串保存
+ */
+@Singleton
+class StepResultCache @Inject constructor(
+    @ApplicationContext context: Context
+) {
+
+    companion object {
+        private const val DIRECTORY = "step_results"
+        private const val MAX_MEMORY_ENTRIES = 64
+        private const val MAX_DISK_ENTRIES = 512
+        private const val TRIM_INTERVAL = 32
+        private const val STALE_TEMP_MS = 60 * 1000L
+
+        /**
+         * 对若干字段求 SHA-256，每个字段前写入长度，避免拼接歧义
+         */
+        fun hash(parts: List<String>): String {
+            val digest = MessageDigest.getInstance("SHA-256")
+            for (part in parts) {
+                val bytes = part.toByteArray(Charsets.UTF_8)
+                digest.update(bytes.size.toString().toByteArray(Charsets.UTF_8))
+                digest.update(':'.code.toByte())
+                digest.update(bytes)
+            }
+            return digest.digest().joinToString("") { "%02x".format(it) }
+        }
+    }
+
+    private class Entry(
+        val result: StepResult,
+        val expiresAt: Long
+    )
+
+    private val directory = File(context.cacheDir, DIRECTORY)
+
+    // 启动后第一次写入即整理一次，之后每 TRIM_INTERVAL 次写入整理一次
+    private val writesUntilTrim = AtomicInteger(1)
+
+    // 访问顺序的 LinkedHashMap 即 LRU
+    private val memory = object : LinkedHashMap<String, Entry>(MAX_MEMORY_ENTRIES, 0.75f, true) {
+        override fun removeEldestEntry(eldest: MutableMap.MutableEntry<String, Entry>?): Boolean =
+            size > MAX_MEMORY_ENTRIES
+    }
+
+    suspend fun get(key: String): StepResult? {
+        val now = System.currentTimeMillis()
+        synchronized(memory) {
+            memory[key]?.let { entry ->
+                if (entry.expiresAt > now) return entry.result
+                memory.remove(key)
+            }
+        }
+
+        val entry = withContext(Dispatchers.IO) { readEntry(key) } ?: return null
+        if (entry.expiresAt <= now) {
+            withContext(Dispatchers.IO) { File(directory, key).delete() }
+            return null
+        }
+        synchronized(memory) { memory[key] = entry }
+        return entry.result
+    }
+
+    suspend fun put(key: String, result: StepResult, ttlMs: Long) {
+        if (ttlMs <= 0 || result.status != StepStatus.COMPLETED) return
+        val entry = Entry(result, System.currentTimeMillis() + ttlMs)
+        synchronized(memory) { memory[key] = entry }
+        withContext(Dispatchers.IO) {
+            try {
+                writeEntry(key, entry)
+                if (writesUntilTrim.decrementAndGet() <= 0) {
+                    writesUntilTrim.set(TRIM_INTERVAL)
+                    trimDisk()
+                }
+            } catch (e: java.io.IOException) {
+                // 写盘失败只影响下次启动后的命中，不影响本次结果
+            }
+        }
+    }
+
+    suspend fun clear() {
+        synchronized(memory) { memory.clear() }
+        withContext(Dispatchers.IO) { directory.listFiles()?.forEach { it.delete() } }
+    }
+
+    // ========== 私有方法 ==========
+
+    private fun readEntry(key: String): Entry? {
+        val file = File(directory, key)
+        if (!file.exists()) return null
+        return try {
+            val json = JSONObject(file.readText())
+            val output = json.optOutput("output")
+            Entry(
+                result = StepResult(
+                    stepId = json.getString("stepId"),
+                    status = StepStatus.COMPLETED,
+                    output = output,
+                    error = null,
+                    executionTimeMs = json.getLong("executionTimeMs"),
+                    executedBy = json.optString("executedBy").ifEmpty { null },
+                    timestamp = json.getLong("timestamp")
+                ),
+                expiresAt = json.getLong("expiresAt")
+            )
+        } catch (e: Exception) {
+            // 损坏的文件当作未命中
+            file.delete()
+            null
+        }
+    }
+
+    private fun writeEntry(key: String, entry: Entry) {
+        val result = entry.result
+        val json = JSONObject()
+            .put("stepId", result.stepId)
+            .put("executionTimeMs", result.executionTimeMs)
+            .put("executedBy", result.executedBy ?: "")
+            .put("timestamp", result.timestamp)
+            .put("expiresAt", entry.expiresAt)
+        result.output?.let { json.put("output", toJsonValue(it)) }
+
+        directory.mkdirs()
+        // 先写临时文件再改名，读到的总是完整内容；临时文件名唯一，同一键的并发写入互不覆盖
+        val temp = File.createTempFile(key, ".tmp", directory)
+        try {
+            temp.writeText(json.toString())
+            if (!temp.renameTo(File(directory, key))) temp.delete()
+        } catch (e: java.io.IOException) {
+            temp.delete()
+            throw e
+        }
+    }
+
+    private fun trimDisk() {
+        val all = directory.listFiles() ?: return
+        // 写入中途被杀留下的临时文件
+        val staleBefore = System.currentTimeMillis() - STALE_TEMP_MS
+        all.filter { it.name.endsWith(".tmp") && it.lastModified() < staleBefore }.forEach { it.delete() }
+
+        val files = all.filterNot { it.name.endsWith(".tmp") }
+        if (files.size <= MAX_DISK_ENTRIES) return
+        files.sortedBy { it.lastModified() }
+            .take(files.size - MAX_DISK_ENTRIES)
+            .forEach { it.delete() }
+    }
+}
@@ -0,0 +1,186 @@
+package com.pulsenetwork.data.workflow
+
+import android.content.Context
+import com.pulsenetwork.domain.workflow.ExecutableWorkflow
+import com.pulsenetwork.domain.workflow.StepResult
+import com.pulsenetwork.domain.workflow.StepStatus
+import dagger.hilt.android.qualifiers.ApplicationContext
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.NonCancellable
+import kotlinx.coroutines.withContext
+import org.json.JSONObject
+import java.io.File
+import java.io.FileOutputStream
+import java.io.IOException
+import javax.inject.Inject
+import javax.inject.Singleton
+
+/**
+ * 工作流检查点日志
+ *
+ * 每个执行中的工作流对应 filesDir 下一个只追加的文件，每行一条 JSON 记录：
+ * 首行记录工作流指纹，之后每完成一个步骤追加一行（结果及其输出，即上下文增量），
+ * 写入后立即 fsync。进程被杀后再次执行同一工作流时回放日志，
+ * 已完成的步骤直接恢复，只有中断时正在执行的步骤需要重跑。
+ * 崩溃时写了一半的末行解析失败，回放时忽略；工作流定义或输入变化后指纹不符，日志作废
+ *
+ * @param directory 日志目录，应用中为 filesDir 下的固定子目录
+ */
+@Singleton
+class WorkflowCheckpointLog(
+    private val directory: File
+) {
+
+    @Inject
+    constructor(@ApplicationContext context: Context) : this(File(context.filesDir, DIRECTORY))
+
+    companion object {
+        private const val DIRECTORY = "workflow_checkpoints"
+        private const val SUFFIX = ".log"
+    }
+
+    /**
+     * 打开工作流的日志
+     *
+     * @return 日志中已完成的步骤结果，按完成顺序；没有可用日志时为空并开始新日志
+     */
+    suspend fun open(workflow: ExecutableWorkflow): List<StepResult> = withContext(Dispatchers.IO) {
+        val file = fileFor(workflow.id)
+        val fingerprint = fingerprint(workflow)
+        val restored = try {
+            replay(file, fingerprint)
+        } catch (e: IOException) {
+            null
+        }
+        if (restored != null) {
+            terminateLastLine(file)
+            return@withContext restored
+        }
+
+        try {
+            directory.mkdirs()
+            file.writeText("")
+            append(
+                file,
+                JSONObject()
+                    .put("type", "start")
+                    .put("workflowId", workflow.id)
+                    .put("fingerprint", fingerprint)
+            )
+        } catch (e: IOException) {
+            // 无法写日志时照常执行，只是不能断点续跑
+        }
+        emptyList()
+    }
+
+    /**
+     * 记录一个已完成的步骤；其他状态的步骤恢复后需要重跑，不记录
+     */
+    suspend fun record(workflowId: String, result: StepResult) {
+        if (result.status != StepStatus.COMPLETED) return
+        val line = JSONObject()
+            .put("type", "step")
+            .put("stepId", result.stepId)
+            .put("executionTimeMs", result.executionTimeMs)
+            .put("executedBy", result.executedBy ?: "")
+            .put("timestamp", result.timestamp)
+        result.output?.let { line.put("output", toJsonValue(it)) }
+
+        withContext(Dispatchers.IO) {
+            val file = fileFor(workflowId)
+            if (!file.exists()) return@withContext
+            try {
+                append(file, line)
+            } catch (e: IOException) {
+                // 写失败只影响断点续跑
+            }
+        }
+    }
+
+    /**
+     * 工作流结束，不再需要续跑
+     */
+    suspend fun discard(workflowId: String) {
+        withContext(NonCancellable + Dispatchers.IO) { fileFor(workflowId).delete() }
+    }
+
+    /**
+     * 留有日志、即上次未正常结束的工作流 ID
+     */
+    suspend fun interruptedWorkflowIds(): List<String> = withContext(Dispatchers.IO) {
+        val files = directory.listFiles { file -> file.name.endsWith(SUFFIX) } ?: return@withContext emptyList()
+        files.mapNotNull { file ->
+            try {
+                val first = file.bufferedReader().use { it.readLine() } ?: return@mapNotNull null
+                JSONObject(first).optString("workflowId").ifEmpty { null }
+            } catch (e: Exception) {
+                null
+            }
+        }
+    }
+
+    // ========== 私有方法 ==========
+
+    // 工作流 ID 可能含有不能用作文件名的字符，文件名取其哈希
+    private fun fileFor(workflowId: String): File =
+        File(directory, StepResultCache.hash(listOf(workflowId)).take(32) + SUFFIX)
+
+    private fun fingerprint(workflow: ExecutableWorkflow): String =
+        StepResultCache.hash(listOf(workflow.steps.toString(), workflow.inputs.toString()))
+
+    /**
+     * @return 指纹不符或文件不存在时为 null
+     */
+    private fun replay(file: File, fingerprint: String): List<StepResult>? {
+        if (!file.exists()) return null
+        val results = ArrayList<StepResult>()
+        var started = false
+
+        file.forEachLine { line ->
+            try {
+                val record = JSONObject(line)
+                when (record.optString("type")) {
+                    "start" -> started = record.optString("fingerprint") == fingerprint
+                    "step" -> if (started) {
+                        results.add(
+                            StepResult(
+                                stepId = record.getString("stepId"),
+                                status = StepStatus.COMPLETED,
+                                output = record.optOutput("output"),
+                                error = null,
+                                executionTimeMs = record.getLong("executionTimeMs"),
+                                executedBy = record.optString("executedBy").ifEmpty { null },
+                                timestamp = record.getLong("timestamp")
+                            )
+                        )
+                    }
+                }
+            } catch (e: Exception) {
+                // 写了一半的记录
+            }
+        }
+        return if (started) results else null
+    }
+
+    /**
+     * 末行写了一半时补上换行，后续记录不会和它粘在一起
+     */
+    private fun terminateLastLine(file: File) {
+        try {
+            java.io.RandomAccessFile(file, "rw").use { raf ->
+                if (raf.length() == 0L) return
+                raf.seek(raf.length() - 1)
+                if (raf.read() != '\n'.code) raf.write('\n'.code)
+            }
+        } catch (e: IOException) {
+            // 忽略
+        }
+    }
+
+    private fun append(file: File, record: JSONObject) {
+        FileOutputStream(file, true).use { stream ->
+            stream.write((record.toString() + "\n").toByteArray(Charsets.UTF_8))
+            stream.fd.sync()
+        }
+    }
+}
@@ -0,0 +1,194 @@
+package com.pulsenetwork.data.workflow
+
+import android.content.Context
+import androidx.security.crypto.EncryptedFile
+import androidx.security.crypto.MasterKey
+import com.pulsenetwork.core.native.AesGcmCipher
+import com.pulsenetwork.domain.workflow.EncryptedWorkflow
+import com.pulsenetwork.domain.workflow.ExecutableWorkflow
+import com.pulsenetwork.domain.workflow.SealedStream
+import com.pulsenetwork.domain.workflow.SealedStreamException
+import com.pulsenetwork.domain.workflow.SegmentCipher
+import com.pulsenetwork.domain.workflow.StepConfig
+import com.pulsenetwork.domain.workflow.StepType
+import com.pulsenetwork.domain.workflow.WorkflowStep
+import dagger.hilt.android.qualifiers.ApplicationContext
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import org.json.JSONException
+import org.json.JSONObject
+import java.io.File
+import java.security.SecureRandom
+import javax.inject.Inject
+import javax.inject.Singleton
+
+/**
+ * 工作流核心逻辑加密
+ *
+ * 核心逻辑按步骤分段，用 AES-256-GCM 分段加密（见 SealedStream），执行时逐步解密：
+ * load 只解密概要段（步骤 ID、名称、类型和依赖，供调度），
+ * 步骤配置和执行条件由执行引擎在执行到该步骤时经 unseal 解密。
+ * 设备工作流密钥首次使用时随机生成，经 Android Keystore 主密钥加密后保存在 filesDir；
+ * 导入原生层后只保留句柄
+ */
+@Singleton
+class WorkflowCoreCipher @Inject constructor(
+    @ApplicationContext private val context: Context,
+    private val aesGcm: AesGcmCipher
+) {
+
+    companion object {
+        private const val KEY_FILE = "workflow_core.key"
+        private const val KEY_BYTES = 32
+    }
+
+    private val random = SecureRandom()
+    private val keyMutex = Mutex()
+
+    @Volatile
+    private var keyHandle = 0L
+
+    /**
+     * 每个元素加密为一段
+     */
+    suspend fun seal(segments: List<ByteArray>): ByteArray {
+        val prefix = ByteArray(SealedStream.NONCE_PREFIX_BYTES).also { random.nextBytes(it) }
+        return withContext(Dispatchers.Default) {
+            SealedStream.seal(HandleCipher(handle()), segments, prefix)
+        }
+    }
+
+    /**
+     * 解析加密后的核心逻辑，各段在读取时才解密
+     * @throws com.pulsenetwork.domain.workflow.SealedStreamException 格式不对
+     */
+    suspend fun open(core: ByteArray): SealedStream.Reader {
+        return SealedStream.open(HandleCipher(handle()), core)
+    }
+
+    /**
+     * 载入加密工作流：只解密第 0 段（概要与步骤依赖），各步骤配置留在密文中，
+     * 执行引擎执行到该步骤时再调用 unseal。步骤类型在概要中，调度时按它区分资源类别
+     * @throws SealedStreamException 格式不对或校验失败
+     */
+    suspend fun load(workflow: EncryptedWorkflow, inputs: Map<String, Any>): ExecutableWorkflow {
+        val core = open(workflow.encryptedCore)
+        val header = parseSegment(core, 0)
+        val graph = header.optJSONArray("steps")
+            ?: throw SealedStreamException("Workflow core has no step graph")
+        if (graph.length() != core.size - 1) {
+            throw SealedStreamException("Step graph lists ${graph.length()} steps, core has ${core.size - 1}")
+        }
+
+        val steps = (0 until graph.length()).map { index ->
+            val step = graph.getJSONObject(index)
+            val dependencies = step.optJSONArray("dependencies")
+            WorkflowStep(
+                id = step.getString("id"),
+                name = step.optString("name", step.getString("id")),
+                type = stepType(step.getString("type")),
+                config = StepConfig.Sealed(segment = index + 1),
+                dependencies = (0 until (dependencies?.length() ?: 0)).map { dependencies!!.getString(it) },
+                order = index
+            )
+        }
+
+        return ExecutableWorkflow(
+            id = workflow.id,
+            name = workflow.name,
+            description = workflow.description,
+            steps = steps,
+            inputs = inputs,
+            sealedCore = core
+        )
+    }
+
+    /**
+     * 解密步骤配置和执行条件，StepConfig.Sealed 以外的步骤原样返回
+     * @throws SealedStreamException 工作流没有加密核心、该段校验失败或与概要中的步骤不符
+     */
+    fun unseal(step: WorkflowStep, core: SealedStream.Reader?): WorkflowStep {
+        val sealed = step.config as? StepConfig.Sealed ?: return step
+        if (core == null) throw SealedStreamException("Step ${step.id} is sealed but the workflow has no core")
+        if (sealed.segment !in 1 until core.size) throw SealedStreamException("No segment ${sealed.segment}")
+
+        val segment = parseSegment(core, sealed.segment)
+        try {
+            if (segment.getString("id") != step.id || stepType(segment.getString("type")) != step.type) {
+                throw SealedStreamException("Segment ${sealed.segment} does not belong to step ${step.id}")
+            }
+            return step.copy(
+                config = StepConfigJson.decode(step.type, segment.getJSONObject("config")),
+                condition = if (segment.isNull("condition")) null else segment.getString("condition")
+            )
+        } catch (e: JSONException) {
+            throw SealedStreamException("Segment ${sealed.segment} has an invalid step config: ${e.message}")
+        }
+    }
+
+    // ========== 私有方法 ==========
+
+    private fun stepType(name: String): StepType =
+        StepType.values().firstOrNull { it.name == name }
+            ?: throw SealedStreamException("Unknown step type $name")
+
+    /**
+     * 解密一段并解析为 JSON，明文字节用完即清零
+     */
+    private fun parseSegment(core: SealedStream.Reader, index: Int): JSONObject {
+        val plain = core.segment(index)
+        try {
+            return JSONObject(String(plain, Charsets.UTF_8))
+        } catch (e: JSONException) {
+            throw SealedStreamException("Segment $index is not valid JSON")
+        } finally {
+            plain.fill(0)
+        }
+    }
+
+    private suspend fun handle(): Long {
+        keyHandle.takeIf { it != 0L }?.let { return it }
+        return keyMutex.withLock {
+            if (keyHandle == 0L) {
+                val key = withContext(Dispatchers.IO) { loadOrCreateKey() }
+                keyHandle = aesGcm.createKey(key)
+                key.fill(0)
+            }
+            keyHandle
+        }
+    }
+
+    private fun loadOrCreateKey(): ByteArray {
+        val file = File(context.filesDir, KEY_FILE)
+        val masterKey = MasterKey.Builder(context)
+            .setKeyScheme(MasterKey.KeyScheme.AES256_GCM)
+            .build()
+        val encryptedFile = EncryptedFile.Builder(
+            context,
+            file,
+            masterKey,
+            EncryptedFile.FileEncryptionScheme.AES256_GCM_HKDF_4KB
+        ).build()
+
+        if (file.exists()) {
+            val key = encryptedFile.openFileInput().use { it.readBytes() }
+            if (key.size == KEY_BYTES) return key
+            // 损坏的密钥文件无法恢复，已加密的核心逻辑随之失效
+            file.delete()
+        }
+
+        val key = ByteArray(KEY_BYTES).also { random.nextBytes(it) }
+        encryptedFile.openFileOutput().use { it.write(key) }
+        return key
+    }
+
+    private inner class HandleCipher(private val handle: Long) : SegmentCipher {
+        override fun seal(nonce: ByteArray, aad: ByteArray, input: ByteArray, offset: Int, length: Int) =
+            aesGcm.seal(handle, nonce, aad, input, offset, length)
+
+        override fun open(nonce: ByteArray, aad: ByteArray, input: ByteArray, offset: Int, length: Int) =
+            aesGcm.open(handle, nonce, aad, input, offset, length)
+    }
+}
@@ -1,11 +1,20 @@
 package com.pulsenetwork.data.workflow
 
+import com.pulsenetwork.core.native.GenerationStats
+import com.pulsenetwork.core.native.LLMInference
+import com.pulsenetwork.core.native.OutputGrammar
+import com.pulsenetwork.core.native.SamplingParams
 import com.pulsenetwork.domain.swarm.*
 import com.pulsenetwork.domain.workflow.*
 import kotlinx.coroutines.*
+import kotlinx.coroutines.channels.Channel
 import kotlinx.coroutines.flow.*
+import kotlinx.coroutines.sync.Semaphore
+import kotlinx.coroutines.sync.withPermit
 import java.util.UUID
 import java.util.concurrent.ConcurrentHashMap
+import kotlin.coroutines.AbstractCoroutineContextElement
+import kotlin.coroutines.CoroutineContext
 import javax.inject.Inject
 import javax.inject.Singleton
 
@@ -14,14 +23,33 @@ import javax.inject.Singleton
  *
  * 支持多种执行模式：
  * - 顺序执行：按步骤顺序依次执行
- * - 并行执行：无依赖的步骤同时执行
+ * - 并行执行：按依赖图调度，依赖就绪即启动，按资源类别限制并发
  * - 自适应执行：根据网络负载动态调整
  */
 @Singleton
 class WorkflowExecutorImpl @Inject constructor(
-    private val swarmNetwork: SwarmNetwork
+    private val swarmNetwork: SwarmNetwork,
+    private val llmInference: LLMInference,
+    private val stepCache: StepResultCache,
+    private val checkpointLog: WorkflowCheckpointLog,
+    private val coreCipher: WorkflowCoreCipher
 ) : WorkflowExecutor {
 
+    companion object {
+        // 模型信息不可用时假定的上下文长度
+        private const val DEFAULT_CONTEXT_LENGTH = 2048
+
+        // countTokens 不含原生分词时加在开头的 BOS
+        private const val BOS_TOKENS = 1
+
+        // 上下文信息异常时提示词预算的下限，避免把所有变量截成空串
+        private const val MIN_PROMPT_TOKENS = 64
+
+        // 并行执行时各资源类别的并发上限（本机推理共用一个原生会话）
+        private const val MAX_LOCAL_LLM_STEPS = 1
+        private const val MAX_REMOTE_STEPS = 4
+    }
+
     // 活跃执行
     private val activeExecutions = ConcurrentHashMap<String, ActiveExecution>()
 
@@ -31,6 +59,25 @@ class WorkflowExecutorImpl @Inject constructor(
     // 步骤结果存储
     private val stepResults = ConcurrentHashMap<String, MutableMap<String, StepResult>>()
 
+    // 执行中的协程，取消时直接取消，正在运行的步骤（包括原生解码）随之停止
+    private val executionJobs = ConcurrentHashMap<String, Job>()
+
+    // 经 cancel() 主动取消的执行；其他来源的取消（调用方协程结束）保留检查点以便续跑
+    private val cancelRequested = ConcurrentHashMap.newKeySet<String>()
+
+    // 步骤、重试、缓存查询、远程调用和原生预填充 / 解码的计时区间
+    private val tracer = Tracer()
+
+    // 各步骤的历史耗时，用于剩余时间估计和关键路径优先级
+    private val latencyStats = StepLatencyStats()
+
+    /**
+     * 协程上下文中携带工作流 ID，步骤内部的计时区间据此归属
+     */
+    private class TraceContext(val workflowId: String) : AbstractCoroutineContextElement(Key) {
+        companion object Key : CoroutineContext.Key<TraceContext>
+    }
+
     // 协程作用域
     private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
 
@@ -66,14 +113,21 @@ class WorkflowExecutorImpl @Inject constructor(
         // 初始化步骤结果存储
         stepResults[workflowId] = mutableMapOf()
 
-        return try {
-            when (workflow.executionMode) {
-                ExecutionMode.SEQUENTIAL -> executeSequential(workflow, progressFlow)
-                ExecutionMode.PARALLEL -> executeParallel(workflow, progressFlow)
-                ExecutionMode.ADAPTIVE -> executeAdaptive(workflow, progressFlow)
+        val result = try {
+            withContext(TraceContext(workflowId)) {
+                executionJobs[workflowId] = coroutineContext.job
+                traced(workflow.name, "workflow") {
+                    when (workflow.executionMode) {
+                        ExecutionMode.SEQUENTIAL -> executeSequential(workflow, progressFlow)
+                        ExecutionMode.PARALLEL -> executeParallel(workflow, progressFlow)
+                        ExecutionMode.ADAPTIVE -> executeAdaptive(workflow, progressFlow)
+                    }
+                }
             }
         } catch (e: CancellationException) {
             updateProgress(progressFlow) { it.copy(status = ExecutionStatus.CANCELLED) }
+            // 调用方被取消（如进程即将退出）不等于用户取消：检查点保留，取消继续向上传播
+            if (!cancelRequested.remove(workflowId)) throw e
             WorkflowExecutionResult.Cancelled(
                 workflowId = workflowId,
                 cancelledAt = System.currentTimeMillis(),
@@ -89,10 +143,21 @@ class WorkflowExecutorImpl @Inject constructor(
                 partialResults = stepResults[workflowId] ?: emptyMap()
             )
         } finally {
+            executionJobs.remove(workflowId)
             activeExecutions.remove(workflowId)
+            cancelRequested.remove(workflowId)
+        }
+
+        // 成功或主动取消后不再续跑；失败时保留检查点，再次执行从失败的步骤开始
+        if (result is WorkflowExecutionResult.Success || result is WorkflowExecutionResult.Cancelled) {
+            checkpointLog.discard(workflowId)
         }
+        return result
     }
 
+    override suspend fun execute(workflow: EncryptedWorkflow, inputs: Map<String, Any>): WorkflowExecutionResult =
+        execute(coreCipher.load(workflow, inputs))
+
     override fun executionProgressFlow(workflowId: String): Flow<ExecutionProgress> {
         return progressFlows.getOrPut(workflowId) {
             MutableStateFlow(
@@ -117,6 +182,8 @@ class WorkflowExecutorImpl @Inject constructor(
         updateProgress(progressFlows[workflowId] ?: return false) {
             it.copy(status = ExecutionStatus.CANCELLED)
         }
+        cancelRequested.add(workflowId)
+        executionJobs.remove(workflowId)?.cancel()
         activeExecutions.remove(workflowId)
         return true
     }
@@ -138,6 +205,12 @@ class WorkflowExecutorImpl @Inject constructor(
         return true
     }
 
+    override fun exportTrace(workflowId: String?): String = tracer.exportChromeTrace(workflowId)
+
+    override suspend fun getInterruptedWorkflowIds(): List<String> {
+        return checkpointLog.interruptedWorkflowIds().filterNot { activeExecutions.containsKey(it) }
+    }
+
     override suspend fun resume(workflowId: String): Boolean {
         val progressFlow = progressFlows[workflowId] ?: return false
         val current = progressFlow.value
@@ -154,10 +227,19 @@ class WorkflowExecutorImpl @Inject constructor(
         progressFlow: MutableStateFlow<ExecutionProgress>
     ): WorkflowExecutionResult {
         val startTime = System.currentTimeMillis()
-        val results = mutableMapOf<String, StepResult>()
+        // 结果和上下文都是持久化 Map：更新只复制一条路径，快照无需拷贝
+        var results = PersistentMap.empty<String, StepResult>()
         val completedSteps = mutableListOf<String>()
         val failedSteps = mutableListOf<FailedStep>()
-        var context = workflow.inputs.toMutableMap()
+        var context = workflow.inputs.toPersistentMap()
+
+        // 回放检查点：上次已完成的步骤直接恢复结果和上下文
+        for (restored in checkpointLog.open(workflow)) {
+            results = results.put(restored.stepId, restored)
+            stepResults[workflow.id]?.put(restored.stepId, restored)
+            completedSteps.add(restored.stepId)
+            restored.output?.let { context = context.putAll(it) }
+        }
 
         updateProgress(progressFlow) { it.copy(status = ExecutionStatus.RUNNING) }
 
@@ -165,31 +247,32 @@ class WorkflowExecutorImpl @Inject constructor(
         val sortedSteps = workflow.steps.sortedBy { it.order }
 
         for ((index, step) in sortedSteps.withIndex()) {
-            // 检查是否被取消或暂停
+            if (step.id in results) continue
+
+            // 暂停时挂起等待；取消会结束等待
+            awaitNotPaused(progressFlow)
             if (progressFlow.value.status == ExecutionStatus.CANCELLED) {
                 break
             }
 
-            while (progressFlow.value.status == ExecutionStatus.PAUSED) {
-                delay(100)
-            }
-
             // 更新当前步骤
             updateProgress(progressFlow) {
                 it.copy(currentStep = index + 1)
             }
 
             // 执行步骤
-            val stepResult = executeStep(step, context, workflow.retryPolicy)
+            val stepResult = executeStep(step, context, workflow.retryPolicy, workflow.conditions, workflow.sealedCore)
 
-            results[step.id] = stepResult
+            results = results.put(step.id, stepResult)
             stepResults[workflow.id]?.put(step.id, stepResult)
+            checkpointLog.record(workflow.id, stepResult)
+            recordLatency(workflow, step, stepResult)
 
             if (stepResult.status == StepStatus.COMPLETED) {
                 completedSteps.add(step.id)
                 // 将步骤输出合并到上下文
                 stepResult.output?.let { output ->
-                    context.putAll(output)
+                    context = context.putAll(output)
                 }
             } else if (stepResult.status == StepStatus.FAILED) {
                 failedSteps.add(
@@ -213,9 +296,9 @@ class WorkflowExecutorImpl @Inject constructor(
             // 更新进度
             val elapsed = System.currentTimeMillis() - startTime
             val percent = ((index + 1).toFloat() / sortedSteps.size) * 100
-            val estimatedRemaining = if (index > 0) {
-                (elapsed / (index + 1)) * (sortedSteps.size - index - 1)
-            } else workflow.timeout
+            val estimatedRemaining = sortedSteps.subList(index + 1, sortedSteps.size)
+                .filter { it.id !in results }
+                .sumOf { estimateMs(workflow, it) }
 
             updateProgress(progressFlow) {
                 it.copy(
@@ -224,7 +307,7 @@ class WorkflowExecutorImpl @Inject constructor(
                     percentComplete = percent,
                     elapsedTimeMs = elapsed,
                     estimatedRemainingMs = estimatedRemaining,
-                    stepResults = results.toMap()
+                    stepResults = results
                 )
             }
         }
@@ -239,16 +322,16 @@ class WorkflowExecutorImpl @Inject constructor(
                 }
                 WorkflowExecutionResult.Success(
                     workflowId = workflow.id,
-                    outputs = context.toMap(),
+                    outputs = context,
                     totalExecutionTimeMs = totalTime,
-                    stepResults = results.toMap()
+                    stepResults = results
                 )
             }
             completedSteps.isNotEmpty() -> {
                 updateProgress(progressFlow) { it.copy(status = ExecutionStatus.COMPLETED) }
                 WorkflowExecutionResult.PartialSuccess(
                     workflowId = workflow.id,
-                    outputs = context.toMap(),
+                    outputs = context,
                     failedSteps = failedSteps,
                     totalExecutionTimeMs = totalTime
                 )
@@ -260,69 +343,187 @@ class WorkflowExecutorImpl @Inject constructor(
                     error = "Execution failed at step ${failedSteps.firstOrNull()?.stepId}",
                     errorType = ErrorType.EXECUTION_FAILED,
                     failedAtStep = failedSteps.firstOrNull()?.stepId,
-                    partialResults = results.toMap()
+                    partialResults = results
                 )
             }
         }
     }
 
+    /**
+     * DAG 调度：依赖全部完成的步骤进入就绪队列，按关键路径优先级出队，
+     * 所属资源类别未满时立即启动；步骤失败时其下游全部跳过
+     */
     private suspend fun executeParallel(
         workflow: ExecutableWorkflow,
         progressFlow: MutableStateFlow<ExecutionProgress>
     ): WorkflowExecutionResult {
         val startTime = System.currentTimeMillis()
-        val results = ConcurrentHashMap<String, StepResult>()
-        val context = ConcurrentHashMap<String, Any>().apply {
-            putAll(workflow.inputs)
+        val graph = StepGraph(workflow.steps) { estimateMs(workflow, it) }
+        // 只在协调协程中修改；启动步骤时直接把当前版本作为快照传入
+        var results = PersistentMap.empty<String, StepResult>()
+        var context = workflow.inputs.toPersistentMap()
+        val completedSteps = mutableListOf<String>()
+        val failedSteps = mutableListOf<FailedStep>()
+        val restored = checkpointLog.open(workflow).filter { it.stepId in graph.steps }
+
+        val limits = mapOf(
+            ResourceClass.LOCAL_LLM to MAX_LOCAL_LLM_STEPS,
+            ResourceClass.REMOTE to MAX_REMOTE_STEPS,
+            ResourceClass.CPU to Runtime.getRuntime().availableProcessors()
+        )
+        val running = ResourceClass.values().associateWithTo(mutableMapOf()) { 0 }
+        val remainingDeps = graph.steps.mapValuesTo(mutableMapOf()) { it.value.dependencies.distinct().size }
+
+        // 回放检查点：已完成的步骤不再执行，其下游的依赖计数相应减少
+        for (result in restored) {
+            results = results.put(result.stepId, result)
+            stepResults[workflow.id]?.put(result.stepId, result)
+            completedSteps.add(result.stepId)
+            result.output?.let { context = context.putAll(it) }
+            remainingDeps[result.stepId] = -1
+            for (child in graph.dependents(result.stepId)) {
+                if (remainingDeps.getValue(child) > 0) remainingDeps[child] = remainingDeps.getValue(child) - 1
+            }
         }
+        val ready = java.util.PriorityQueue(
+            compareByDescending<WorkflowStep> { graph.priority.getValue(it.id) }.thenBy { it.order }
+        )
+        graph.topologicalOrder.filter { remainingDeps[it.id] == 0 }.forEach { ready.add(it) }
 
         updateProgress(progressFlow) { it.copy(status = ExecutionStatus.RUNNING) }
 
-        // 分组：独立步骤 vs 依赖步骤
-        val (independent, dependent) = workflow.steps.partition { it.dependencies.isEmpty() }
-
-        // 并行执行独立步骤
-        val independentJobs = independent.map { step ->
-            scope.async {
-                step to executeStep(step, context.toMap(), workflow.retryPolicy)
+        // 失败步骤的下游不再执行
+        fun skipDownstream(stepId: String) {
+            for (child in graph.dependents(stepId)) {
+                if (results.containsKey(child) || remainingDeps[child] == -1) continue
+                remainingDeps[child] = -1
+                results = results.put(child, StepResult(
+                    stepId = child,
+                    status = StepStatus.SKIPPED,
+                    output = null,
+                    error = "Upstream step $stepId failed",
+                    executionTimeMs = 0,
+                    executedBy = null
+                ))
+                skipDownstream(child)
             }
         }
 
-        // 等待所有独立步骤完成
-        independentJobs.awaitAll().forEach { (step, result) ->
-            results[step.id] = result
-            result.output?.let { context.putAll(it) }
-        }
+        coroutineScope {
+            val finished = Channel<Pair<WorkflowStep, StepResult>>(Channel.UNLIMITED)
+            var inFlight = 0
+
+            // 按优先级启动资源未满的就绪步骤，资源已满的留在队列中
+            fun dispatch() {
+                if (progressFlow.value.status == ExecutionStatus.CANCELLED) return
+                val blocked = mutableListOf<WorkflowStep>()
+                while (ready.isNotEmpty()) {
+                    val step = ready.poll()!!
+                    val resource = step.type.resourceClass
+                    if (running.getValue(resource) >= limits.getValue(resource)) {
+                        blocked.add(step)
+                        continue
+                    }
+                    running[resource] = running.getValue(resource) + 1
+                    inFlight++
+                    val snapshot = context
+                    launch(Dispatchers.Default) {
+                        finished.send(
+                            step to executeStep(step, snapshot, workflow.retryPolicy, workflow.conditions, workflow.sealedCore)
+                        )
+                    }
+                }
+                ready.addAll(blocked)
+            }
 
-        // 顺序执行依赖步骤
-        for (step in dependent.sortedBy { it.order }) {
-            if (progressFlow.value.status == ExecutionStatus.CANCELLED) break
+            while (true) {
+                awaitNotPaused(progressFlow)
+                dispatch()
+                if (inFlight == 0) break
+
+                val (step, result) = finished.receive()
+                inFlight--
+                val resource = step.type.resourceClass
+                running[resource] = running.getValue(resource) - 1
+
+                results = results.put(step.id, result)
+                stepResults[workflow.id]?.put(step.id, result)
+                checkpointLog.record(workflow.id, result)
+                recordLatency(workflow, step, result)
+                when (result.status) {
+                    StepStatus.COMPLETED -> {
+                        completedSteps.add(step.id)
+                        result.output?.let { context = context.putAll(it) }
+                        for (child in graph.dependents(step.id)) {
+                            if (remainingDeps.getValue(child) < 0) continue
+                            val remaining = remainingDeps.getValue(child) - 1
+                            remainingDeps[child] = remaining
+                            if (remaining == 0) ready.add(graph.steps.getValue(child))
+                        }
+                    }
+                    StepStatus.FAILED -> {
+                        failedSteps.add(
+                            FailedStep(step.id, result.error ?: "Unknown error", step.retryCount, result.timestamp)
+                        )
+                        skipDownstream(step.id)
+                    }
+                    // 等待用户输入等未完成的步骤没有输出，下游无法执行
+                    else -> skipDownstream(step.id)
+                }
 
-            val result = executeStep(step, context.toMap(), workflow.retryPolicy)
-            results[step.id] = result
-            result.output?.let { context.putAll(it) }
+                val elapsed = System.currentTimeMillis() - startTime
+                val done = results.size
+                updateProgress(progressFlow) {
+                    it.copy(
+                        currentStep = done,
+                        completedSteps = completedSteps.toList(),
+                        failedSteps = failedSteps.toList(),
+                        percentComplete = done.toFloat() / graph.steps.size * 100,
+                        elapsedTimeMs = elapsed,
+                        // 剩余步骤中最长的路径即剩余的关键路径
+                        estimatedRemainingMs = graph.topologicalOrder
+                            .filter { it.id !in results }
+                            .maxOfOrNull { graph.priority.getValue(it.id) } ?: 0L,
+                        stepResults = results
+                    )
+                }
+            }
         }
 
         val totalTime = System.currentTimeMillis() - startTime
-        val failedSteps = results.filter { it.value.status == StepStatus.FAILLED }
-            .map { (id, result) ->
-                FailedStep(id, result.error ?: "Unknown error", 0, result.timestamp)
-            }
+        val cancelled = progressFlow.value.status == ExecutionStatus.CANCELLED
 
-        return if (failedSteps.isEmpty()) {
-            WorkflowExecutionResult.Success(
-                workflowId = workflow.id,
-                outputs = context.toMap(),
-                totalExecutionTimeMs = totalTime,
-                stepResults = results.toMap()
-            )
-        } else {
-            WorkflowExecutionResult.PartialSuccess(
-                workflowId = workflow.id,
-                outputs = context.toMap(),
-                failedSteps = failedSteps,
-                totalExecutionTimeMs = totalTime
-            )
+        return when {
+            failedSteps.isEmpty() && !cancelled -> {
+                updateProgress(progressFlow) {
+                    it.copy(status = ExecutionStatus.COMPLETED, percentComplete = 100f)
+                }
+                WorkflowExecutionResult.Success(
+                    workflowId = workflow.id,
+                    outputs = context,
+                    totalExecutionTimeMs = totalTime,
+                    stepResults = results
+                )
+            }
+            completedSteps.isNotEmpty() -> {
+                if (!cancelled) updateProgress(progressFlow) { it.copy(status = ExecutionStatus.COMPLETED) }
+                WorkflowExecutionResult.PartialSuccess(
+                    workflowId = workflow.id,
+                    outputs = context,
+                    failedSteps = failedSteps,
+                    totalExecutionTimeMs = totalTime
+                )
+            }
+            else -> {
+                updateProgress(progressFlow) { it.copy(status = ExecutionStatus.FAILED) }
+                WorkflowExecutionResult.Failure(
+                    workflowId = workflow.id,
+                    error = "Execution failed at step ${failedSteps.firstOrNull()?.stepId}",
+                    errorType = ErrorType.EXECUTION_FAILED,
+                    failedAtStep = failedSteps.firstOrNull()?.stepId,
+                    partialResults = results
+                )
+            }
         }
     }
 
@@ -347,29 +548,99 @@ class WorkflowExecutorImpl @Inject constructor(
     private suspend fun executeStep(
         step: WorkflowStep,
         context: Map<String, Any>,
-        retryPolicy: RetryPolicy
+        retryPolicy: RetryPolicy,
+        conditions: Map<String, Expression> = emptyMap(),
+        sealedCore: SealedStream.Reader? = null
+    ): StepResult = traced(step.name, "step", mapOf("stepId" to step.id, "type" to step.type.name)) {
+        // 加密步骤执行到这里才解密配置，解密失败不重试
+        val resolved = try {
+            traced("unseal", "crypto") { coreCipher.unseal(step, sealedCore) }
+        } catch (e: SealedStreamException) {
+            return@traced StepResult(
+                stepId = step.id,
+                status = StepStatus.FAILED,
+                output = null,
+                error = e.message,
+                executionTimeMs = 0,
+                executedBy = null
+            )
+        }
+
+        // 执行条件随配置一起加密，解密后才能判断；语法错误重试也不会成功，直接失败
+        resolved.condition?.let { condition ->
+            val satisfied = try {
+                Expression.compile(condition).test(context)
+            } catch (e: ExpressionException) {
+                return@traced StepResult(
+                    stepId = step.id,
+                    status = StepStatus.FAILED,
+                    output = null,
+                    error = "Invalid step condition: ${e.message}",
+                    executionTimeMs = 0,
+                    executedBy = "local"
+                )
+            }
+            if (!satisfied) {
+                return@traced StepResult(
+                    stepId = step.id,
+                    status = StepStatus.SKIPPED,
+                    output = null,
+                    error = null,
+                    executionTimeMs = 0,
+                    executedBy = "local"
+                )
+            }
+        }
+        runStep(resolved, context, retryPolicy, conditions)
+    }
+
+    private suspend fun runStep(
+        step: WorkflowStep,
+        context: Map<String, Any>,
+        retryPolicy: RetryPolicy,
+        conditions: Map<String, Expression>
     ): StepResult {
         val startTime = System.currentTimeMillis()
         var lastError: String? = null
         var attempts = 0
 
+        // 相同配置和输入的确定性步骤直接复用之前的结果
+        val cacheKey = if (step.cache.enabled && step.memoizable) cacheKey(step, context) else null
+        cacheKey?.let { key ->
+            traced("cache lookup", "cache") { stepCache.get(key) }?.let { cached ->
+                return cached.copy(
+                    stepId = step.id,
+                    executionTimeMs = System.currentTimeMillis() - startTime,
+                    executedBy = "cache",
+                    timestamp = System.currentTimeMillis()
+                )
+            }
+        }
+
         repeat(retryPolicy.maxRetries + 1) {
             attempts++
             try {
-                val result = when (step.type) {
-                    StepType.LOCAL_INFERENCE -> executeLocalInference(step, context)
-                    StepType.REMOTE_INFERENCE -> executeRemoteInference(step, context)
-                    StepType.DATA_TRANSFORM -> executeDataTransform(step, context)
-                    StepType.CONDITION_CHECK -> executeConditionCheck(step, context)
-                    StepType.PARALLEL_BATCH -> executeParallelBatch(step, context)
-                    StepType.AGGREGATION -> executeAggregation(step, context)
-                    StepType.EXTERNAL_API -> executeExternalApi(step, context)
-                    StepType.USER_INPUT -> executeUserInput(step, context)
+                val result = traced("attempt $attempts", "attempt", mapOf("stepId" to step.id)) {
+                    when (step.type) {
+                        StepType.LOCAL_INFERENCE -> executeLocalInference(step, context)
+                        StepType.REMOTE_INFERENCE -> executeRemoteInference(step, context)
+                        StepType.DATA_TRANSFORM -> executeDataTransform(step, context)
+                        StepType.CONDITION_CHECK -> executeConditionCheck(step, context, conditions)
+                        StepType.PARALLEL_BATCH -> executeParallelBatch(step, context)
+                        StepType.AGGREGATION -> executeAggregation(step, context)
+                        StepType.EXTERNAL_API -> executeExternalApi(step, context)
+                        StepType.USER_INPUT -> executeUserInput(step, context)
+                    }
                 }
 
-                return result.copy(
+                val finished = result.copy(
                     executionTimeMs = System.currentTimeMillis() - startTime
                 )
+                cacheKey?.let { stepCache.put(it, finished, step.cache.ttlMs) }
+                return finished
+            } catch (e: CancellationException) {
+                // 工作流被取消，不算步骤失败，也不重试
+                throw e
             } catch (e: Exception) {
                 lastError = e.message
                 if (attempts <= retryPolicy.maxRetries) {
@@ -399,16 +670,37 @@ class WorkflowExecutorImpl @Inject constructor(
     ): StepResult {
         val config = step.config as StepConfig.LocalInference
 
-        // 构建prompt
-        val prompt = buildPrompt(config.promptTemplate, context)
+        if (!llmInference.isModelLoaded()) {
+            throw IllegalStateException("Local model not loaded")
+        }
+
+        // 构建prompt，按模型上下文为输出预留空间
+        val prompt = buildPromptWithinBudget(
+            config.promptTemplate,
+            context,
+            promptBudget(config.maxTokens)
+        )
+
+        // JSON 输出走约束解码，一次生成即可解析，无需重试
+        val params = SamplingParams(
+            temperature = config.temperature,
+            seed = config.seed,
+            grammar = when (config.outputFormat) {
+                OutputFormat.TEXT -> OutputGrammar.NONE
+                OutputFormat.JSON -> OutputGrammar.JSON
+            }
+        )
+        // 步骤超时直接作为原生截止时间，超时后算力在一个 token 内释放
+        val response = tracedGeneration("generate") {
+            llmInference.generateWithStats(prompt, config.maxTokens, params, step.timeout)
+                .let { it.text to it.stats }
+        }
 
-        // TODO: 实际调用本地模型推理
-        // 这里返回模拟结果
         return StepResult(
             stepId = step.id,
             status = StepStatus.COMPLETED,
             output = mapOf(
-                "response" to "[Local inference result for: ${prompt.take(50)}...]",
+                "response" to response,
                 "model" to config.modelType
             ),
             error = null,
@@ -466,7 +758,9 @@ class WorkflowExecutorImpl @Inject constructor(
             priority = MessagePriority.NORMAL
         )
 
-        val result = swarmNetwork.sendToNode(selectedNode.id, message)
+        val result = traced("send task", "remote", mapOf("nodeId" to selectedNode.id)) {
+            swarmNetwork.sendToNode(selectedNode.id, message)
+        }
 
         return when (result) {
             is SendMessageResult.Success -> StepResult(
@@ -513,12 +807,25 @@ class WorkflowExecutorImpl @Inject constructor(
 
     private fun executeConditionCheck(
         step: WorkflowStep,
-        context: Map<String, Any>
+        context: Map<String, Any>,
+        conditions: Map<String, Expression>
     ): StepResult {
         val config = step.config as StepConfig.ConditionCheck
 
-        // 简单的条件评估（实际实现需要更复杂的表达式引擎）
-        val result = evaluateCondition(config.condition, context)
+        // 工作流内的条件已预编译；语法错误重试也不会成功，直接失败
+        val expression = conditions[step.id] ?: try {
+            Expression.compile(config.condition)
+        } catch (e: ExpressionException) {
+            return StepResult(
+                stepId = step.id,
+                status = StepStatus.FAILED,
+                output = null,
+                error = "Invalid condition: ${e.message}",
+                executionTimeMs = 0,
+                executedBy = "local"
+            )
+        }
+        val result = expression.test(context)
 
         val nextStep = if (result) config.trueBranch else config.falseBranch
 
@@ -540,18 +847,112 @@ class WorkflowExecutorImpl @Inject constructor(
         context: Map<String, Any>
     ): StepResult {
         val config = step.config as StepConfig.ParallelBatch
+        val items = batchItems(context[config.inputKey])
+
+        val results = when (val template = config.stepTemplate.config) {
+            is StepConfig.LocalInference -> mapLocalInferenceBatch(step, template, config, items, context)
+            else -> mapStepTemplate(step, config, items, context)
+        }
 
-        // TODO: 实现真正的并行批处理
         return StepResult(
             stepId = step.id,
             status = StepStatus.COMPLETED,
-            output = mapOf("batchResult" to "processed ${config.batchSize} items"),
+            output = mapOf(
+                "batchResults" to results,
+                "batchResult" to "processed ${items.size} items"
+            ),
             error = null,
             executionTimeMs = 0,
             executedBy = "local"
         )
     }
 
+    /**
+     * 本地推理模板：每个微批次合成一次原生批量解码，多条序列共享每一步 llama_decode
+     */
+    private suspend fun mapLocalInferenceBatch(
+        step: WorkflowStep,
+        template: StepConfig.LocalInference,
+        config: StepConfig.ParallelBatch,
+        items: List<Any>,
+        context: Map<String, Any>
+    ): List<Any> {
+        if (items.isEmpty()) return emptyList()
+        if (!llmInference.isModelLoaded()) {
+            throw IllegalStateException("Local model not loaded")
+        }
+
+        val budget = promptBudget(template.maxTokens)
+        val params = SamplingParams(
+            temperature = template.temperature,
+            seed = template.seed,
+            grammar = when (template.outputFormat) {
+                OutputFormat.TEXT -> OutputGrammar.NONE
+                OutputFormat.JSON -> OutputGrammar.JSON
+            }
+        )
+
+        // 每一项只在共享的上下文上多加一个键，不复制整个上下文
+        val base = context.toPersistentMap()
+        val results = ArrayList<Any>(items.size)
+        for (chunk in items.chunked(config.batchSize.coerceAtLeast(1))) {
+            currentCoroutineContext().ensureActive()
+            val prompts = chunk.map { item ->
+                buildPromptWithinBudget(
+                    template.promptTemplate,
+                    base.put(config.itemKey, item),
+                    budget
+                )
+            }
+            results.addAll(tracedGeneration("generate batch of ${prompts.size}") {
+                llmInference.generateBatchWithStats(prompts, template.maxTokens, params, step.timeout)
+                    .let { it.texts to it.stats }
+            })
+        }
+        return results
+    }
+
+    /**
+     * 其他模板：逐项执行，最多 maxConcurrency 项同时进行，任一项失败则整个步骤失败
+     */
+    private suspend fun mapStepTemplate(
+        step: WorkflowStep,
+        config: StepConfig.ParallelBatch,
+        items: List<Any>,
+        context: Map<String, Any>
+    ): List<Any> = coroutineScope {
+        val permits = Semaphore(config.maxConcurrency.coerceAtLeast(1))
+        val retryPolicy = RetryPolicy(maxRetries = config.stepTemplate.retryCount)
+        val base = context.toPersistentMap()
+
+        val results = items.mapIndexed { index, item ->
+            async {
+                permits.withPermit {
+                    executeStep(
+                        config.stepTemplate.copy(id = "${step.id}[$index]"),
+                        base.put(config.itemKey, item),
+                        retryPolicy
+                    )
+                }
+            }
+        }.awaitAll()
+
+        results.map { result ->
+            if (result.status != StepStatus.COMPLETED) {
+                throw IllegalStateException("Batch item ${result.stepId} failed: ${result.error}")
+            }
+            result.output ?: emptyMap<String, Any>()
+        }
+    }
+
+    private fun batchItems(input: Any?): List<Any> = when (input) {
+        null -> emptyList()
+        is List<*> -> input.filterNotNull()
+        is Array<*> -> input.filterNotNull()
+        is String -> input.lines().filter { it.isNotBlank() }
+        else -> listOf(input)
+    }
+
     private fun executeAggregation(
         step: WorkflowStep,
         context: Map<String, Any>
@@ -606,40 +1007,139 @@ class WorkflowExecutorImpl @Inject constructor(
         )
     }
 
-    private fun buildPrompt(template: String, context: Map<String, Any>): String {
-        var prompt = template
-        context.forEach { (key, value) ->
-            prompt = prompt.replace("{{${key}}}", value.toString())
+    /**
+     * 步骤结果的缓存键：步骤类型、配置、所用模型和步骤实际读取的输入值
+     */
+    private fun cacheKey(step: WorkflowStep, context: Map<String, Any>): String {
+        val inputKeys: Collection<String> = when (val config = step.config) {
+            is StepConfig.LocalInference -> PromptTemplate.compile(config.promptTemplate).placeholders
+            is StepConfig.ParallelBatch -> when (val template = config.stepTemplate.config) {
+                is StepConfig.LocalInference ->
+                    PromptTemplate.compile(template.promptTemplate).placeholders - config.itemKey + config.inputKey
+                else -> context.keys
+            }
+            else -> context.keys
+        }
+
+        val parts = ArrayList<String>(inputKeys.size * 2 + 3)
+        parts.add(step.type.name)
+        parts.add(step.config.toString())
+        parts.add(llmInference.getModelInfo()?.let { "${it.name}/${it.quantization}/${it.fileSizeMB}" } ?: "")
+        for (key in inputKeys.sorted()) {
+            parts.add(key)
+            parts.add(context[key]?.toString() ?: "\u0000")
+        }
+        return StepResultCache.hash(parts)
+    }
+
+    private fun buildPrompt(template: String, context: Map<String, Any>): String =
+        PromptTemplate.compile(template).render(context)
+
+    /**
+     * 提示词的 token 预算（不含 BOS），与原生生成的截断规则一致：
+     * 原生侧把 maxTokens 限制在上下文的一半以内，提示词连同 BOS 占用其余部分
+     */
+    private fun promptBudget(maxTokens: Int): Int {
+        val contextLength = llmInference.getModelInfo()?.contextLength ?: DEFAULT_CONTEXT_LENGTH
+        val reserved = maxTokens.coerceIn(1, maxOf(1, contextLength / 2))
+        return (contextLength - reserved - BOS_TOKENS).coerceAtLeast(MIN_PROMPT_TOKENS)
+    }
+
+    /**
+     * 在 token 预算内构建 prompt
+     *
+     * 超出预算时按 token 截断最长的变量值，模板本身保持完整；
+     * 计数使用模型词表，常见模板片段命中原生分词缓存
+     */
+    private fun buildPromptWithinBudget(
+        template: String,
+        context: Map<String, Any>,
+        budget: Int
+    ): String {
+        val compiled = PromptTemplate.compile(template)
+        var prompt = compiled.render(context)
+        var overflow = llmInference.countTokens(prompt) - budget
+        if (overflow <= 0) return prompt
+
+        // 只有模板引用到的变量参与截断
+        val values = compiled.placeholders
+            .mapNotNull { key -> context[key]?.let { key to it.toString() } }
+            .toMap(HashMap())
+
+        while (overflow > 0) {
+            val (key, value) = values.entries
+                .filter { it.value.isNotEmpty() }
+                .maxByOrNull { it.value.length }
+                ?.toPair()
+                ?: break
+            val tokens = llmInference.tokenize(value)
+            val keep = tokens.size - overflow
+            values[key] = if (keep > 0) llmInference.detokenize(tokens.copyOf(keep)) else ""
+            prompt = compiled.render(values)
+            overflow = llmInference.countTokens(prompt) - budget
         }
         return prompt
     }
 
-    private fun evaluateCondition(condition: String, context: Map<String, Any>): Boolean {
-        // 简单的条件评估
-        // 支持: key == value, key != value, key > value, key < value
-        val patterns = listOf(
-            "(\\w+)\\s*==\\s*(.+)".toRegex(),
-            "(\\w+)\\s*!=\\s*(.+)".toRegex(),
-            "(\\w+)\\s*>\\s*(.+)".toRegex(),
-            "(\\w+)\\s*<\\s*(.+)".toRegex()
-        )
+    private suspend inline fun <T> traced(
+        name: String,
+        category: String,
+        args: Map<String, String> = emptyMap(),
+        block: () -> T
+    ): T {
+        val traceId = currentCoroutineContext()[TraceContext]?.workflowId ?: ""
+        return tracer.trace(traceId, name, category, args, block)
+    }
 
-        for (pattern in patterns) {
-            val match = pattern.find(condition) ?: continue
-            val key = match.groupValues[1]
-            val expectedValue = match.groupValues[2].trim().removeSurrounding("\"", "\"")
-            val actualValue = context[key]?.toString() ?: continue
-
-            return when {
-                condition.contains("==") -> actualValue == expectedValue
-                condition.contains("!=") -> actualValue != expectedValue
-                condition.contains(">") -> (actualValue.toDoubleOrNull() ?: 0.0) > (expectedValue.toDoubleOrNull() ?: 0.0)
-                condition.contains("<") -> (actualValue.toDoubleOrNull() ?: 0.0) < (expectedValue.toDoubleOrNull() ?: 0.0)
-                else -> false
-            }
+    /**
+     * 原生生成计时，并按该次调用返回的原生统计拆出预填充和解码两个子区间
+     * @param block 返回生成结果及其统计，并行步骤同时生成时统计不会错配
+     */
+    private suspend inline fun <T> tracedGeneration(name: String, block: () -> Pair<T, GenerationStats?>): T {
+        val traceId = currentCoroutineContext()[TraceContext]?.workflowId ?: ""
+        val start = tracer.nowMicros()
+        val threadId = Thread.currentThread().id
+        val (result, generationStats) = tracer.trace(traceId, name, "llm", emptyMap(), block)
+
+        generationStats?.let { stats ->
+            val prefill = (stats.prefillMs * 1000).toLong()
+            tracer.record(
+                TraceSpan(traceId, "prefill", "llm", start, prefill, threadId,
+                    mapOf("tokens" to stats.promptTokens.toString()))
+            )
+            tracer.record(
+                TraceSpan(traceId, "decode", "llm", start + prefill, (stats.decodeMs * 1000).toLong(), threadId,
+                    mapOf("tokens" to stats.generatedTokens.toString()))
+            )
         }
+        return result
+    }
+
+    private fun latencyKey(workflow: ExecutableWorkflow, step: WorkflowStep) = "${workflow.name}/${step.id}"
+
+    /**
+     * 记录真正执行过的步骤耗时；缓存命中和检查点恢复不代表实际耗时
+     */
+    private fun recordLatency(workflow: ExecutableWorkflow, step: WorkflowStep, result: StepResult) {
+        if (result.status != StepStatus.COMPLETED || result.executedBy == "cache") return
+        latencyStats.record(latencyKey(workflow, step), result.executionTimeMs)
+        latencyStats.record(step.type.name, result.executionTimeMs)
+    }
 
-        return false
+    /**
+     * 步骤预估耗时：同一工作流中该步骤的历史耗时，其次同类步骤，最后按资源类别的默认值
+     */
+    private fun estimateMs(workflow: ExecutableWorkflow, step: WorkflowStep): Long =
+        latencyStats.estimate(latencyKey(workflow, step))
+            ?: latencyStats.estimate(step.type.name)
+            ?: StepGraph.defaultCost(step)
+
+    /**
+     * 暂停时挂起直到状态变化，不轮询；恢复或取消都会立即唤醒
+     */
+    private suspend fun awaitNotPaused(progressFlow: MutableStateFlow<ExecutionProgress>) {
+        if (progressFlow.value.status != ExecutionStatus.PAUSED) return
+        progressFlow.first { it.status != ExecutionStatus.PAUSED }
     }
 
     private inline fun updateProgress(
@@ -4,6 +4,8 @@ import com.pulsenetwork.domain.workflow.*
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
+import org.json.JSONArray
+import org.json.JSONObject
 import java.util.*
 import javax.inject.Inject
 import javax.inject.Singleton
@@ -16,9 +18,15 @@ import javax.inject.Singleton
  */
 @Singleton
 class WorkflowInterviewerImpl @Inject constructor(
+    private val coreCipher: WorkflowCoreCipher
     // 后续注入 LLM 服务
 ) : WorkflowInterviewer {
 
+    companion object {
+        // 生成的步骤在本地模型上执行
+        private const val LOCAL_MODEL = "local"
+    }
+
     // 活跃的访谈会话
     private val sessions = mutableMapOf<String, InterviewSession>()
 
@@ -154,11 +162,9 @@ class WorkflowInterviewerImpl @Inject constructor(
         // 生成工作流步骤
         val steps = generateProcessSteps(session.extractedInfo)
 
-        // 创建工作流定义
-        val workflowJson = createWorkflowJson(session.extractedInfo, steps)
-
-        // 加密（简化实现）
-        val encryptedCore = encryptWorkflow(workflowJson)
+        // 创建工作流定义，概要一段、每个步骤一段，分段加密
+        val segments = createWorkflowSegments(session.extractedInfo, steps)
+        val encryptedCore = coreCipher.seal(segments)
 
         return EncryptedWorkflow(
             id = UUID.randomUUID().toString(),
@@ -353,7 +359,7 @@ class WorkflowInterviewerImpl @Inject constructor(
                     id = "main",
                     name = "主处理",
                     description = extractedInfo.problemStatement,
-                    promptTemplate = "处理输入: \${input}"
+                    promptTemplate = "处理输入: {{input}}"
                 )
             )
         } else {
@@ -361,24 +367,42 @@ class WorkflowInterviewerImpl @Inject constructor(
         }
     }
 
-    private fun createWorkflowJson(
+    /**
+     * 第 0 段为概要（含步骤 ID、名称、类型和依赖，供调度），之后每个步骤一段，
+     * 存放完整的步骤配置和执行条件，执行时只需解密当前步骤（见 WorkflowCoreCipher.load）。
+     * 访谈得到的步骤都在本地模型上执行
+     */
+    private fun createWorkflowSegments(
         extractedInfo: ExtractedWorkflowInfo,
         steps: List<ProcessStep>
-    ): ByteArray {
-        val json = """
-            {
-                "problem": "${extractedInfo.problemStatement}",
-                "inputs": ${extractedInfo.inputs.map { it.name }},
-                "outputs": ${extractedInfo.outputs.map { it.name }},
-                "steps": ${steps.map { it.name }}
-            }
-        """.trimIndent()
-        return json.toByteArray()
-    }
+    ): List<ByteArray> {
+        val type = StepType.LOCAL_INFERENCE
+        val header = JSONObject()
+            .put("problem", extractedInfo.problemStatement)
+            .put("inputs", JSONArray(extractedInfo.inputs.map { it.name }))
+            .put("outputs", JSONArray(extractedInfo.outputs.map { it.name }))
+            .put("stepCount", steps.size)
+            .put("steps", JSONArray(steps.map { step ->
+                JSONObject()
+                    .put("id", step.id)
+                    .put("name", step.name)
+                    .put("type", type.name)
+                    .put("dependencies", JSONArray(step.dependencies))
+            }))
+
+        val stepSegments = steps.map { step ->
+            val config = StepConfig.LocalInference(
+                modelType = LOCAL_MODEL,
+                promptTemplate = step.promptTemplate
+            )
+            JSONObject()
+                .put("id", step.id)
+                .put("type", type.name)
+                .put("config", StepConfigJson.encode(config))
+                .put("condition", step.condition ?: JSONObject.NULL)
+        }
 
-    private fun encryptWorkflow(data: ByteArray): ByteArray {
-        // 简化实现，实际应使用加密服务
-        return data
+        return (listOf(header) + stepSegments).map { it.toString().toByteArray() }
     }
 
     private fun createPublicInterface(extractedInfo: ExtractedWorkflowInfo): WorkflowInterface {
@@ -0,0 +1,52 @@
+package com.pulsenetwork.data.workflow
+
+import com.pulsenetwork.domain.workflow.AggregationType
+import com.pulsenetwork.domain.workflow.OutputFormat
+import com.pulsenetwork.domain.workflow.StepConfig
+import com.pulsenetwork.domain.workflow.StepType
+import com.pulsenetwork.domain.workflow.WorkflowStep
+import org.json.JSONException
+import org.json.JSONObject
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * 加密步骤配置编解码测试
+ */
+class StepConfigJsonTest {
+
+    private fun roundTrip(type: StepType, config: StepConfig): StepConfig =
+        StepConfigJson.decode(type, JSONObject(StepConfigJson.encode(config).toString()))
+
+    @Test
+    fun `every config field survives a round trip`() {
+        val local = StepConfig.LocalInference(
+            modelType = "local",
+            promptTemplate = "总结: {{input}}",
+            maxTokens = 128,
+            temperature = 0f,
+            outputFormat = OutputFormat.JSON,
+            seed = 7
+        )
+        assertEquals(local, roundTrip(StepType.LOCAL_INFERENCE, local))
+
+        val check = StepConfig.ConditionCheck("score > 0.5", trueBranch = "b", falseBranch = null)
+        assertEquals(check, roundTrip(StepType.CONDITION_CHECK, check))
+
+        val batch = StepConfig.ParallelBatch(
+            batchSize = 4,
+            stepTemplate = WorkflowStep("t", "t", StepType.LOCAL_INFERENCE, local, order = 0),
+            itemKey = "line"
+        )
+        assertEquals(batch, roundTrip(StepType.PARALLEL_BATCH, batch))
+
+        val aggregation = StepConfig.Aggregation(AggregationType.VOTE, listOf("a", "b"))
+        assertEquals(aggregation, roundTrip(StepType.AGGREGATION, aggregation))
+    }
+
+    @Test(expected = JSONException::class)
+    fun `unknown enum value is rejected`() {
+        val json = StepConfigJson.encode(StepConfig.LocalInference("local", "x")).put("outputFormat", "XML")
+        StepConfigJson.decode(StepType.LOCAL_INFERENCE, json)
+    }
+}
@@ -0,0 +1,95 @@
+package com.pulsenetwork.data.workflow
+
+import com.pulsenetwork.domain.workflow.ExecutableWorkflow
+import com.pulsenetwork.domain.workflow.StepConfig
+import com.pulsenetwork.domain.workflow.StepResult
+import com.pulsenetwork.domain.workflow.StepStatus
+import com.pulsenetwork.domain.workflow.StepType
+import com.pulsenetwork.domain.workflow.WorkflowStep
+import kotlinx.coroutines.test.runTest
+import org.junit.Assert.*
+import org.junit.Rule
+import org.junit.Test
+import org.junit.rules.TemporaryFolder
+import java.io.File
+
+/**
+ * 工作流检查点日志测试
+ */
+class WorkflowCheckpointLogTest {
+
+    @get:Rule
+    val folder = TemporaryFolder()
+
+    private val workflow = ExecutableWorkflow(
+        id = "wf/1",
+        name = "wf",
+        description = "",
+        steps = listOf("a", "b", "c").mapIndexed { index, id ->
+            WorkflowStep(
+                id = id,
+                name = id,
+                type = StepType.DATA_TRANSFORM,
+                config = StepConfig.DataTransform("copy", emptyMap(), emptyMap()),
+                order = index
+            )
+        },
+        inputs = mapOf("text" to "hello")
+    )
+
+    @Test
+    fun `truncated last record is ignored and later records still replay`() = runTest {
+        val log = WorkflowCheckpointLog(folder.root)
+        assertTrue(log.open(workflow).isEmpty())
+        log.record(workflow.id, completed("a", mapOf("summary" to "first", "items" to listOf(1, 2))))
+        log.record(workflow.id, completed("b", mapOf("summary" to "second")))
+
+        // 模拟写 b 时进程被杀：末行只写了一半，也没有换行
+        val file = logFile()
+        val bytes = file.readBytes()
+        file.writeBytes(bytes.copyOf(bytes.size - 12))
+
+        val restored = WorkflowCheckpointLog(folder.root).open(workflow)
+        assertEquals(listOf("a"), restored.map { it.stepId })
+        assertEquals("first", restored[0].output?.get("summary"))
+        assertEquals(listOf(1, 2), restored[0].output?.get("items"))
+
+        // 续跑后追加的记录不会和写了一半的末行粘在一起
+        val resumed = WorkflowCheckpointLog(folder.root)
+        resumed.record(workflow.id, completed("b", mapOf("summary" to "again")))
+        assertEquals(listOf("a", "b"), resumed.open(workflow).map { it.stepId })
+        assertEquals(listOf(workflow.id), resumed.interruptedWorkflowIds())
+    }
+
+    @Test
+    fun `changed inputs invalidate the log`() = runTest {
+        val log = WorkflowCheckpointLog(folder.root)
+        log.open(workflow)
+        log.record(workflow.id, completed("a", null))
+
+        assertTrue(log.open(workflow.copy(inputs = mapOf("text" to "other"))).isEmpty())
+    }
+
+    @Test
+    fun `discarded and failed steps are not replayed`() = runTest {
+        val log = WorkflowCheckpointLog(folder.root)
+        log.open(workflow)
+        log.record(workflow.id, completed("a", null).copy(status = StepStatus.FAILED))
+        assertTrue(log.open(workflow).isEmpty())
+
+        log.discard(workflow.id)
+        assertTrue(log.interruptedWorkflowIds().isEmpty())
+    }
+
+    private fun logFile(): File = folder.root.listFiles { file -> file.name.endsWith(".log") }!!.single()
+
+    private fun completed(stepId: String, output: Map<String, Any>?) = StepResult(
+        stepId = stepId,
+        status = StepStatus.COMPLETED,
+        output = output,
+        error = null,
+        executionTimeMs = 5,
+        executedBy = null,
+        timestamp = 1_000L
+    )
+}
@@ -38,6 +38,13 @@ android {
             "-opt-in=kotlinx.coroutines.FlowPreview"
         )
     }
+
+    testOptions {
+        unitTests.all {
+            // 微基准默认跳过，-Ppulse.benchmark 时运行（见 EvictionHeapTest）
+            it.systemProperty("pulse.benchmark", project.hasProperty("pulse.benchmark"))
+        }
+    }
 }
 
 dependencies {
@@ -47,6 +47,11 @@ interface Governor {
      */
     fun statusFlow(): kotlinx.coroutines.flow.Flow<GovernorStatus>
 
+    /**
+     * 内存压力流（系统回收内存时推送，用于淘汰常驻模型）
+     */
+    fun memoryPressureFlow(): kotlinx.coroutines.flow.Flow<MemoryPressure>
+
     /**
      * 强制进入保护模式（如检测到过热）
      */
@@ -96,6 +101,15 @@ enum class ThermalState {
     CRITICAL     // 危急（严重过热，需立即降频）
 }
 
+/**
+ * 内存压力等级
+ */
+enum class MemoryPressure {
+    MODERATE,   // 系统开始回收内存
+    LOW,        // 内存紧张
+    CRITICAL    // 内存严重不足，进程随时可能被杀
+}
+
 /**
  * 任务执行决策
  */
@@ -0,0 +1,138 @@
+package com.pulsenetwork.domain.swarm
+
+/**
+ * 可按键更新优先级的二叉最小堆（索引堆）
+ *
+ * 缓存淘汰用：堆顶是优先级最低、最先淘汰的键。
+ * 插入、更新、删除、弹出都是 O(log n)，查看堆顶 O(1)
+ */
+class EvictionHeap<K : Any>(initialCapacity: Int = 16) {
+
+    private var keys = arrayOfNulls<Any>(initialCapacity.coerceAtLeast(1))
+    private var priorities = DoubleArray(initialCapacity.coerceAtLeast(1))
+    private val positions = HashMap<K, Int>(initialCapacity.coerceAtLeast(1))
+    private var count = 0
+
+    val size: Int
+        get() = count
+
+    fun isEmpty(): Boolean = count == 0
+
+    operator fun contains(key: K): Boolean = positions.containsKey(key)
+
+    fun priorityOf(key: K): Double? = positions[key]?.let { priorities[it] }
+
+    /**
+     * 插入键，已存在时更新其优先级
+     */
+    fun offer(key: K, priority: Double) {
+        val index = positions[key]
+        if (index != null) {
+            val old = priorities[index]
+            priorities[index] = priority
+            if (priority < old) siftUp(index) else siftDown(index)
+            return
+        }
+
+        if (count == keys.size) grow()
+        keys[count] = key
+        priorities[count] = priority
+        positions[key] = count
+        siftUp(count)
+        count++
+    }
+
+    /**
+     * 优先级最低的键，堆为空时返回 null
+     */
+    fun peek(): K? = if (count > 0) keyAt(0) else null
+
+    /**
+     * 弹出优先级最低的键
+     */
+    fun poll(): K? {
+        if (count == 0) return null
+        val key = keyAt(0)
+        removeAt(0)
+        return key
+    }
+
+    fun remove(key: K): Boolean {
+        val index = positions[key] ?: return false
+        removeAt(index)
+        return true
+    }
+
+    fun clear() {
+        keys.fill(null, 0, count)
+        positions.clear()
+        count = 0
+    }
+
+    // ========== 私有方法 ==========
+
+    @Suppress("UNCHECKED_CAST")
+    private fun keyAt(index: Int): K = keys[index] as K
+
+    private fun removeAt(index: Int) {
+        positions.remove(keyAt(index))
+        count--
+        if (index == count) {
+            keys[count] = null
+            return
+        }
+
+        // 末尾元素补位后可能需要上浮或下沉
+        move(count, index)
+        keys[count] = null
+        val parent = (index - 1) / 2
+        if (index > 0 && priorities[index] < priorities[parent]) siftUp(index) else siftDown(index)
+    }
+
+    private fun siftUp(start: Int) {
+        var index = start
+        val key = keys[index]
+        val priority = priorities[index]
+        while (index > 0) {
+            val parent = (index - 1) / 2
+            if (priorities[parent] <= priority) break
+            move(parent, index)
+            index = parent
+        }
+        place(index, key, priority)
+    }
+
+    private fun siftDown(start: Int) {
+        var index = start
+        val key = keys[index]
+        val priority = priorities[index]
+        while (true) {
+            var child = 2 * index + 1
+            if (child >= count) break
+            if (child + 1 < count && priorities[child + 1] < priorities[child]) child++
+            if (priorities[child] >= priority) break
+            move(child, index)
+            index = child
+        }
+        place(index, key, priority)
+    }
+
+    private fun move(from: Int, to: Int) {
+        keys[to] = keys[from]
+        priorities[to] = priorities[from]
+        positions[keyAt(to)] = to
+    }
+
+    @Suppress("UNCHECKED_CAST")
+    private fun place(index: Int, key: Any?, priority: Double) {
+        keys[index] = key
+        priorities[index] = priority
+        positions[key as K] = index
+    }
+
+    private fun grow() {
+        val capacity = keys.size * 2
+        keys = keys.copyOf(capacity)
+        priorities = priorities.copyOf(capacity)
+    }
+}
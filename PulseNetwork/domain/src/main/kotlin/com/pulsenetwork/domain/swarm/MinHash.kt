@@ -0,0 +1,145 @@
+package com.pulsenetwork.domain.swarm
+
+import java.util.concurrent.ConcurrentHashMap
+import kotlin.random.Random
+
+/**
+ * 字符 n-gram 的 MinHash 签名
+ *
+ * 文本先归一化（小写，去掉空白和标点），再切成字符 n-gram。
+ * 中文没有空格分词，按字切分的二元组正好覆盖词语，中英文用同一套规则。
+ * 两个签名相同位置取值相等的比例即 n-gram 集合 Jaccard 相似度的无偏估计
+ */
+class MinHasher(
+    val numHashes: Int = 64,
+    private val ngram: Int = 2,
+    seed: Long = 0x5EED_CAFEL
+) {
+
+    private val multipliers: LongArray
+    private val offsets: LongArray
+
+    init {
+        require(numHashes > 0 && ngram > 0)
+        val random = Random(seed)
+        multipliers = LongArray(numHashes) { random.nextLong() or 1L }
+        offsets = LongArray(numHashes) { random.nextLong() }
+    }
+
+    /**
+     * 计算签名
+     * @return 没有任何字母或数字的文本返回 null
+     */
+    fun signature(text: String): IntArray? {
+        val normalized = normalize(text)
+        if (normalized.isEmpty()) return null
+        val signature = IntArray(numHashes) { Int.MAX_VALUE }
+
+        // 短于 n 的文本整体作为一个 n-gram
+        val last = maxOf(0, normalized.length - ngram)
+        for (start in 0..last) {
+            var shingle = 0L
+            val end = minOf(start + ngram, normalized.length)
+            for (i in start until end) shingle = shingle * 31 + normalized[i].code
+            for (h in 0 until numHashes) {
+                val value = mix(shingle * multipliers[h] + offsets[h])
+                if (value < signature[h]) signature[h] = value
+            }
+        }
+        return signature
+    }
+
+    /**
+     * 签名估计的 Jaccard 相似度
+     */
+    fun similarity(a: IntArray, b: IntArray): Float {
+        require(a.size == b.size)
+        var equal = 0
+        for (i in a.indices) if (a[i] == b[i]) equal++
+        return equal.toFloat() / a.size
+    }
+
+    // ========== 私有方法 ==========
+
+    private fun normalize(text: String): String {
+        val builder = StringBuilder(text.length)
+        for (char in text) {
+            if (char.isLetterOrDigit()) builder.append(char.lowercaseChar())
+        }
+        return builder.toString()
+    }
+
+    /**
+     * 64 位混合（splitmix64 的终结函数）后取高 32 位
+     */
+    private fun mix(value: Long): Int {
+        var z = value
+        z = (z xor (z ushr 30)) * -0x40a7b892e31b1a47L
+        z = (z xor (z ushr 27)) * -0x6b2fb644ecceee15L
+        z = z xor (z ushr 31)
+        return (z ushr 32).toInt()
+    }
+}
+
+/**
+ * MinHash 签名的 LSH 分带索引
+ *
+ * 签名切成 bands 段、每段 rows 个值，任一段完全相同即成为候选。
+ * Jaccard 为 s 的两段文本成为候选的概率是 1 - (1 - s^rows)^bands，
+ * 默认 16 × 4 时 s = 0.5 约 64%、s = 0.8 超过 99.9%，查询只需比较少量候选。
+ * 线程安全：桶是并发集合，读写互不阻塞
+ */
+class LshIndex<K : Any>(
+    private val bands: Int = 16,
+    private val rows: Int = 4
+) {
+
+    private val buckets = Array(bands) { ConcurrentHashMap<Long, MutableSet<K>>() }
+
+    val signatureSize: Int
+        get() = bands * rows
+
+    fun add(key: K, signature: IntArray) {
+        require(signature.size >= signatureSize)
+        for (band in 0 until bands) {
+            // 在 compute 内加入，避免与 remove 删除空桶交错
+            buckets[band].compute(bandHash(signature, band)) { _, keys ->
+                (keys ?: ConcurrentHashMap.newKeySet<K>()).apply { add(key) }
+            }
+        }
+    }
+
+    fun remove(key: K, signature: IntArray) {
+        for (band in 0 until bands) {
+            val hash = bandHash(signature, band)
+            buckets[band].computeIfPresent(hash) { _, keys ->
+                keys.remove(key)
+                if (keys.isEmpty()) null else keys
+            }
+        }
+    }
+
+    /**
+     * 至少有一段签名相同的键
+     */
+    fun candidates(signature: IntArray): Set<K> {
+        val result = HashSet<K>()
+        for (band in 0 until bands) {
+            buckets[band][bandHash(signature, band)]?.let { result.addAll(it) }
+        }
+        return result
+    }
+
+    fun clear() {
+        buckets.forEach { it.clear() }
+    }
+
+    // ========== 私有方法 ==========
+
+    private fun bandHash(signature: IntArray, band: Int): Long {
+        var hash = 1125899906842597L
+        val start = band * rows
+        for (i in start until start + rows) hash = hash * 1099511628211L + signature[i]
+        return hash
+    }
+}
@@ -244,18 +244,33 @@ data class SemanticCacheEntry(
     val sourceNodeId: String,
     val createdAt: Long,
     val lastAccessedAt: Long,
-    val hitCount: Int = 0
+    val hitCount: Int = 0,
+    val vectorModel: String? = null  // 生成 queryVector 的嵌入模型，不同模型的向量不可比较
 ) {
     /**
      * 计算有效分数（考虑时间和热度衰减）
+     * @param hits 命中次数，缓存中原地计数的条目传入当前值，无需复制条目
      */
-    fun effectiveScore(): Float {
+    fun effectiveScore(hits: Int = hitCount): Float {
         val ageHours = (System.currentTimeMillis() - createdAt) / (1000 * 60 * 60)
         val decay = kotlin.math.exp(-ageHours / 24.0).toFloat()  // 24小时半衰期
-        val hotnessBoost = 1 + kotlin.math.ln(hitCount + 1.0).toFloat() / 10
+        val hotnessBoost = 1 + kotlin.math.ln(hits + 1.0).toFloat() / 10
         return qualityScore * decay * hotnessBoost
     }
 
+    /**
+     * 淘汰排序键，与 effectiveScore 同序（小时取整带来的误差除外）
+     *
+     * ln(effectiveScore) = ln(质量 × 热度) + createdAt / 24h - now / 24h，
+     * 最后一项对所有条目相同，去掉后键不随时间变化，索引堆中无需定期重算；
+     * 只有命中次数变化时需要更新
+     */
+    fun evictionKey(hits: Int = hitCount): Double {
+        val hotnessBoost = 1 + kotlin.math.ln(hits + 1.0) / 10
+        val quality = qualityScore.toDouble().coerceAtLeast(MIN_QUALITY)
+        return kotlin.math.ln(quality * hotnessBoost) + createdAt.toDouble() / DECAY_MILLIS
+    }
+
     override fun equals(other: Any?): Boolean {
         if (this === other) return true
         if (other !is SemanticCacheEntry) return false
@@ -263,6 +278,11 @@ data class SemanticCacheEntry(
     }
 
     override fun hashCode(): Int = id.hashCode()
+
+    companion object {
+        private const val DECAY_MILLIS = 24.0 * 60 * 60 * 1000
+        private const val MIN_QUALITY = 1e-6
+    }
 }
 
 /**
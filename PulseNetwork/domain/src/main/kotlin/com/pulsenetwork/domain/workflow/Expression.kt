@@ -0,0 +1,543 @@
+package com.pulsenetwork.domain.workflow
+
+/**
+ * 条件表达式解析失败
+ * @param position 出错位置（字符下标）
+ */
+class ExpressionException(
+    message: String,
+    val position: Int
+) : IllegalArgumentException("$message at $position")
+
+/**
+ * 编译后的条件表达式
+ *
+ * 语法（优先级从低到高）：
+ * - 逻辑：`a || b`、`a && b`、`!a`，也可写作 or / and / not
+ * - 比较：`==` `!=` `<` `<=` `>` `>=`，两边都能转为数字时按数值比较，否则按字符串比较；
+ *   右侧是未加引号的单个标识符且上下文中没有该键时按字符串处理（兼容旧写法 `status == done`）
+ * - 算术：`+` `-` `*` `/` `%`，`+` 有一边是非数字字符串时为拼接
+ * - 字面量：数字、'单引号' 或 "双引号" 字符串、true / false / null
+ * - 键路径：`score`、`result.label`、`items[0]`、`data["key"]`，逐级进入 Map / List；
+ *   上下文中存在完整的带点键名（如 "step1.response"）时优先使用
+ * - 函数：len lower upper trim contains startsWith endsWith abs min max num str exists empty
+ *
+ * 源码只解析一次得到语法树，求值直接遍历语法树，不使用正则。
+ * 真值规则：null、false、0、空字符串和空集合为假
+ */
+class Expression private constructor(
+    val source: String,
+    private val root: Node
+) {
+
+    fun evaluate(context: Map<String, Any?>): Any? = root.eval(context)
+
+    fun test(context: Map<String, Any?>): Boolean = truthy(root.eval(context))
+
+    override fun toString(): String = source
+
+    companion object {
+        /**
+         * @throws ExpressionException 语法错误或未知函数
+         */
+        fun compile(source: String): Expression = Expression(source, Parser(source).parse())
+
+        fun truthy(value: Any?): Boolean = when (value) {
+            null -> false
+            is Boolean -> value
+            is Number -> value.toDouble().let { it != 0.0 && !it.isNaN() }
+            is CharSequence -> value.isNotEmpty()
+            is Collection<*> -> value.isNotEmpty()
+            is Map<*, *> -> value.isNotEmpty()
+            else -> true
+        }
+    }
+}
+
+// ========== 语法树 ==========
+
+private abstract class Node {
+    abstract fun eval(context: Map<String, Any?>): Any?
+}
+
+private class Literal(private val value: Any?) : Node() {
+    override fun eval(context: Map<String, Any?>): Any? = value
+}
+
+/**
+ * 键路径；segments 为空时即普通变量
+ */
+private class Path(
+    private val fullName: String,
+    private val head: String,
+    private val segments: Array<String>,
+    private val indices: IntArray
+) : Node() {
+
+    /**
+     * 不带 . 或 [] 的单个标识符
+     */
+    val bareName: String?
+        get() = if (segments.isEmpty()) head else null
+
+    override fun eval(context: Map<String, Any?>): Any? {
+        if (segments.isNotEmpty()) {
+            context[fullName]?.let { return it }
+        }
+        var value = context[head]
+        for (i in segments.indices) {
+            val current = value
+            val index = indices[i]
+            value = when (current) {
+                is Map<*, *> -> current[segments[i]]
+                is List<*> -> if (index in current.indices) current[index] else null
+                is Array<*> -> if (index in current.indices) current[index] else null
+                else -> null
+            } ?: return null
+        }
+        return value
+    }
+}
+
+/**
+ * 比较右侧未加引号的单个标识符：上下文中有该键时取值，否则就是标识符本身的字符串
+ */
+private class BareWord(private val name: String) : Node() {
+    override fun eval(context: Map<String, Any?>): Any? =
+        if (context.containsKey(name)) context[name] else name
+}
+
+private class Not(private val operand: Node) : Node() {
+    override fun eval(context: Map<String, Any?>): Any? = !Expression.truthy(operand.eval(context))
+}
+
+private class Negate(private val operand: Node) : Node() {
+    override fun eval(context: Map<String, Any?>): Any? = -toNumber(operand.eval(context))
+}
+
+private class And(private val left: Node, private val right: Node) : Node() {
+    override fun eval(context: Map<String, Any?>): Any? =
+        Expression.truthy(left.eval(context)) && Expression.truthy(right.eval(context))
+}
+
+private class Or(private val left: Node, private val right: Node) : Node() {
+    override fun eval(context: Map<String, Any?>): Any? =
+        Expression.truthy(left.eval(context)) || Expression.truthy(right.eval(context))
+}
+
+private enum class CompareOp { EQ, NE, LT, LE, GT, GE }
+
+private class Compare(
+    private val op: CompareOp,
+    private val left: Node,
+    private val right: Node
+) : Node() {
+
+    override fun eval(context: Map<String, Any?>): Any? {
+        val a = left.eval(context)
+        val b = right.eval(context)
+        return when (op) {
+            CompareOp.EQ -> valuesEqual(a, b)
+            CompareOp.NE -> !valuesEqual(a, b)
+            else -> {
+                if (a == null || b == null) return false
+                val x = toNumber(a)
+                val y = toNumber(b)
+                val order = if (!x.isNaN() && !y.isNaN()) x.compareTo(y) else a.toString().compareTo(b.toString())
+                when (op) {
+                    CompareOp.LT -> order < 0
+                    CompareOp.LE -> order <= 0
+                    CompareOp.GT -> order > 0
+                    else -> order >= 0
+                }
+            }
+        }
+    }
+}
+
+private class Arithmetic(
+    private val op: Char,
+    private val left: Node,
+    private val right: Node
+) : Node() {
+
+    override fun eval(context: Map<String, Any?>): Any? {
+        val a = left.eval(context)
+        val b = right.eval(context)
+        val x = toNumber(a)
+        val y = toNumber(b)
+        if (op == '+' && (x.isNaN() || y.isNaN()) && (a is CharSequence || b is CharSequence)) {
+            return stringOf(a) + stringOf(b)
+        }
+        return when (op) {
+            '+' -> x + y
+            '-' -> x - y
+            '*' -> x * y
+            '/' -> x / y
+            else -> x % y
+        }
+    }
+}
+
+private class Call(
+    private val function: Builtin,
+    private val args: Array<Node>
+) : Node() {
+
+    override fun eval(context: Map<String, Any?>): Any? {
+        val a = args[0].eval(context)
+        return when (function) {
+            Builtin.LEN -> when (a) {
+                null -> 0
+                is CharSequence -> a.length
+                is Collection<*> -> a.size
+                is Map<*, *> -> a.size
+                is Array<*> -> a.size
+                else -> a.toString().length
+            }
+            Builtin.LOWER -> stringOf(a).lowercase()
+            Builtin.UPPER -> stringOf(a).uppercase()
+            Builtin.TRIM -> stringOf(a).trim()
+            Builtin.CONTAINS -> {
+                val b = args[1].eval(context)
+                when (a) {
+                    null -> false
+                    is Collection<*> -> a.any { valuesEqual(it, b) }
+                    is Map<*, *> -> a.containsKey(stringOf(b))
+                    else -> a.toString().contains(stringOf(b))
+                }
+            }
+            Builtin.STARTS_WITH -> stringOf(a).startsWith(stringOf(args[1].eval(context)))
+            Builtin.ENDS_WITH -> stringOf(a).endsWith(stringOf(args[1].eval(context)))
+            Builtin.ABS -> kotlin.math.abs(toNumber(a))
+            Builtin.MIN -> minOf(toNumber(a), toNumber(args[1].eval(context)))
+            Builtin.MAX -> maxOf(toNumber(a), toNumber(args[1].eval(context)))
+            Builtin.NUM -> toNumber(a)
+            Builtin.STR -> stringOf(a)
+            Builtin.EXISTS -> a != null
+            Builtin.EMPTY -> when (a) {
+                null -> true
+                is CharSequence -> a.isEmpty()
+                is Collection<*> -> a.isEmpty()
+                is Map<*, *> -> a.isEmpty()
+                else -> false
+            }
+        }
+    }
+}
+
+private enum class Builtin(val functionName: String, val arity: Int) {
+    LEN("len", 1),
+    LOWER("lower", 1),
+    UPPER("upper", 1),
+    TRIM("trim", 1),
+    CONTAINS("contains", 2),
+    STARTS_WITH("startsWith", 2),
+    ENDS_WITH("endsWith", 2),
+    ABS("abs", 1),
+    MIN("min", 2),
+    MAX("max", 2),
+    NUM("num", 1),
+    STR("str", 1),
+    EXISTS("exists", 1),
+    EMPTY("empty", 1);
+
+    companion object {
+        private val byName = values().associateBy { it.functionName }
+
+        fun find(name: String): Builtin? = byName[name]
+    }
+}
+
+// ========== 值转换 ==========
+
+private fun stringOf(value: Any?): String = value?.toString() ?: ""
+
+/**
+ * 转为数值，不能转换时返回 NaN；字符串先做字符检查，避免异常和正则
+ */
+private fun toNumber(value: Any?): Double = when (value) {
+    is Number -> value.toDouble()
+    is Boolean -> if (value) 1.0 else 0.0
+    is String -> if (isNumeric(value)) value.trim().toDouble() else Double.NaN
+    else -> Double.NaN
+}
+
+private fun isNumeric(text: String): Boolean {
+    var i = 0
+    var end = text.length
+    while (i < end && text[i] == ' ') i++
+    while (end > i && text[end - 1] == ' ') end--
+    if (i < end && (text[i] == '-' || text[i] == '+')) i++
+
+    var digits = 0
+    while (i < end && text[i].isAsciiDigit()) { i++; digits++ }
+    if (i < end && text[i] == '.') {
+        i++
+        while (i < end && text[i].isAsciiDigit()) { i++; digits++ }
+    }
+    if (digits == 0) return false
+
+    if (i < end && (text[i] == 'e' || text[i] == 'E')) {
+        i++
+        if (i < end && (text[i] == '-' || text[i] == '+')) i++
+        val start = i
+        while (i < end && text[i].isAsciiDigit()) i++
+        if (i == start) return false
+    }
+    return i == end
+}
+
+private fun Char.isAsciiDigit(): Boolean = this in '0'..'9'
+
+private fun valuesEqual(a: Any?, b: Any?): Boolean {
+    if (a == null || b == null) return a == null && b == null
+    if (a is Number || b is Number) {
+        val x = toNumber(a)
+        val y = toNumber(b)
+        if (!x.isNaN() && !y.isNaN()) return x == y
+    }
+    if (a is Boolean && b is Boolean) return a == b
+    return a.toString() == b.toString()
+}
+
+// ========== 解析 ==========
+
+private class Parser(private val source: String) {
+
+    private var pos = 0
+
+    fun parse(): Node {
+        val node = parseOr()
+        skipWhitespace()
+        if (pos < source.length) fail("Unexpected '${source[pos]}'")
+        return node
+    }
+
+    private fun parseOr(): Node {
+        var node = parseAnd()
+        while (match("||") || matchWord("or")) node = Or(node, parseAnd())
+        return node
+    }
+
+    private fun parseAnd(): Node {
+        var node = parseNot()
+        while (match("&&") || matchWord("and")) node = And(node, parseNot())
+        return node
+    }
+
+    private fun parseNot(): Node {
+        if (matchWord("not")) return Not(parseNot())
+        skipWhitespace()
+        if (peek() == '!' && peek(1) != '=') {
+            pos++
+            return Not(parseNot())
+        }
+        return parseComparison()
+    }
+
+    private fun parseComparison(): Node {
+        val left = parseAdditive()
+        val op = when {
+            match("==") -> CompareOp.EQ
+            match("!=") -> CompareOp.NE
+            match("<=") -> CompareOp.LE
+            match(">=") -> CompareOp.GE
+            match("<") -> CompareOp.LT
+            match(">") -> CompareOp.GT
+            else -> return left
+        }
+        val right = parseAdditive()
+        val bareName = (right as? Path)?.bareName
+        return Compare(op, left, if (bareName != null) BareWord(bareName) else right)
+    }
+
+    private fun parseAdditive(): Node {
+        var node = parseMultiplicative()
+        while (true) {
+            skipWhitespace()
+            val c = peek()
+            if (c != '+' && c != '-') return node
+            pos++
+            node = Arithmetic(c, node, parseMultiplicative())
+        }
+    }
+
+    private fun parseMultiplicative(): Node {
+        var node = parseUnary()
+        while (true) {
+            skipWhitespace()
+            val c = peek()
+            if (c != '*' && c != '/' && c != '%') return node
+            pos++
+            node = Arithmetic(c, node, parseUnary())
+        }
+    }
+
+    private fun parseUnary(): Node {
+        skipWhitespace()
+        if (peek() == '-') {
+            pos++
+            return Negate(parseUnary())
+        }
+        return parsePrimary()
+    }
+
+    private fun parsePrimary(): Node {
+        skipWhitespace()
+        val c = peek() ?: fail("Unexpected end of expression")
+        return when {
+            c == '(' -> {
+                pos++
+                val node = parseOr()
+                expect(')')
+                node
+            }
+            c == '"' || c == '\'' -> Literal(readString())
+            c.isAsciiDigit() || (c == '.' && peek(1)?.isAsciiDigit() == true) -> Literal(readNumber())
+            isIdentifierStart(c) -> parseIdentifier()
+            else -> fail("Unexpected '$c'")
+        }
+    }
+
+    private fun parseIdentifier(): Node {
+        val start = pos
+        val name = readIdentifier()
+        when (name) {
+            "true" -> return Literal(true)
+            "false" -> return Literal(false)
+            "null" -> return Literal(null)
+        }
+
+        skipWhitespace()
+        if (peek() == '(') {
+            val function = Builtin.find(name) ?: fail("Unknown function '$name'", start)
+            pos++
+            val args = ArrayList<Node>(function.arity)
+            skipWhitespace()
+            if (peek() != ')') {
+                args.add(parseOr())
+                while (match(",")) args.add(parseOr())
+            }
+            expect(')')
+            if (args.size != function.arity) {
+                fail("$name expects ${function.arity} argument(s), got ${args.size}", start)
+            }
+            return Call(function, args.toTypedArray())
+        }
+
+        // 键路径
+        val segments = ArrayList<String>()
+        val fullName = StringBuilder(name)
+        while (true) {
+            if (peek() == '.' && peek(1)?.let(::isIdentifierStart) == true) {
+                pos++
+                val segment = readIdentifier()
+                segments.add(segment)
+                fullName.append('.').append(segment)
+            } else if (peek() == '[') {
+                pos++
+                skipWhitespace()
+                val key = when (peek()) {
+                    '"', '\'' -> readString()
+                    else -> {
+                        val number = readNumber()
+                        if (number % 1.0 != 0.0) fail("Index must be an integer")
+                        number.toInt().toString()
+                    }
+                }
+                expect(']')
+                segments.add(key)
+                fullName.append('.').append(key)
+            } else {
+                break
+            }
+        }
+        val indices = IntArray(segments.size) { segments[it].toIntOrNull() ?: -1 }
+        return Path(fullName.toString(), name, segments.toTypedArray(), indices)
+    }
+
+    // ========== 词法 ==========
+
+    private fun peek(offset: Int = 0): Char? = source.getOrNull(pos + offset)
+
+    private fun skipWhitespace() {
+        while (pos < source.length && source[pos].isWhitespace()) pos++
+    }
+
+    private fun match(token: String): Boolean {
+        skipWhitespace()
+        if (!source.startsWith(token, pos)) return false
+        pos += token.length
+        return true
+    }
+
+    /**
+     * 关键字后面不能紧跟标识符字符，避免把 order 的前缀当成 or
+     */
+    private fun matchWord(word: String): Boolean {
+        skipWhitespace()
+        if (!source.startsWith(word, pos)) return false
+        val next = source.getOrNull(pos + word.length)
+        if (next != null && isIdentifierPart(next)) return false
+        pos += word.length
+        return true
+    }
+
+    private fun expect(c: Char) {
+        skipWhitespace()
+        if (peek() != c) fail("Expected '$c'")
+        pos++
+    }
+
+    private fun readIdentifier(): String {
+        val start = pos
+        while (pos < source.length && isIdentifierPart(source[pos])) pos++
+        return source.substring(start, pos)
+    }
+
+    private fun readNumber(): Double {
+        val start = pos
+        while (pos < source.length && (source[pos].isAsciiDigit() || source[pos] == '.')) pos++
+        if (pos < source.length && (source[pos] == 'e' || source[pos] == 'E')) {
+            pos++
+            if (pos < source.length && (source[pos] == '-' || source[pos] == '+')) pos++
+            while (pos < source.length && source[pos].isAsciiDigit()) pos++
+        }
+        val text = source.substring(start, pos)
+        if (!isNumeric(text)) fail("Invalid number '$text'", start)
+        return text.toDouble()
+    }
+
+    private fun readString(): String {
+        val quote = source[pos]
+        val start = pos
+        pos++
+        val builder = StringBuilder()
+        while (true) {
+            val c = peek() ?: fail("Unterminated string", start)
+            pos++
+            when (c) {
+                quote -> return builder.toString()
+                '\\' -> {
+                    val escaped = peek() ?: fail("Unterminated string", start)
+                    pos++
+                    builder.append(
+                        when (escaped) {
+                            'n' -> '\n'
+                            't' -> '\t'
+                            else -> escaped
+                        }
+                    )
+                }
+                else -> builder.append(c)
+            }
+        }
+    }
+
+    private fun isIdentifierStart(c: Char): Boolean = c == '_' || c.isLetter()
+
+    private fun isIdentifierPart(c: Char): Boolean = c == '_' || c.isLetterOrDigit()
+
+    private fun fail(message: String, at: Int = pos): Nothing = throw ExpressionException(message, at)
+}
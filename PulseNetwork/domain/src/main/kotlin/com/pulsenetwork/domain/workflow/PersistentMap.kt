@@ -0,0 +1,310 @@
+package com.pulsenetwork.domain.workflow
+
+/**
+ * 不可变持久化 Map（CHAMP 结构的哈希数组映射前缀树）
+ *
+ * put / remove 返回新 Map，只复制从根到被改节点的一条路径（每层最多 32 个槽），
+ * 其余子树与旧版本共享，复杂度 O(log32 n)。旧版本永远不变，
+ * 作为快照传给其他协程或放进进度状态都不需要复制。
+ * 同一个键的新旧值相同（===）时返回原实例
+ */
+class PersistentMap<K : Any, V : Any> private constructor(
+    private val root: Node,
+    override val size: Int
+) : AbstractMap<K, V>() {
+
+    @Suppress("UNCHECKED_CAST")
+    override fun get(key: K): V? = root.get(key, key.hashCode(), 0) as V?
+
+    override fun containsKey(key: K): Boolean = get(key) != null
+
+    override fun isEmpty(): Boolean = size == 0
+
+    fun put(key: K, value: V): PersistentMap<K, V> {
+        val change = Change()
+        val newRoot = root.put(key, value, key.hashCode(), 0, change)
+        return if (newRoot === root) this else PersistentMap(newRoot, size + change.sizeDelta)
+    }
+
+    fun putAll(from: Map<out K, V>): PersistentMap<K, V> {
+        if (isEmpty() && from is PersistentMap<*, *>) {
+            @Suppress("UNCHECKED_CAST")
+            return from as PersistentMap<K, V>
+        }
+        var map = this
+        for ((key, value) in from) map = map.put(key, value)
+        return map
+    }
+
+    fun remove(key: K): PersistentMap<K, V> {
+        val change = Change()
+        val newRoot = root.remove(key, key.hashCode(), 0, change) ?: EMPTY_NODE
+        return if (newRoot === root) this else PersistentMap(newRoot, size + change.sizeDelta)
+    }
+
+    override val entries: Set<Map.Entry<K, V>>
+        get() = object : AbstractSet<Map.Entry<K, V>>() {
+            override val size: Int
+                get() = this@PersistentMap.size
+
+            override fun iterator(): Iterator<Map.Entry<K, V>> = kotlin.sequences.iterator { visit(root) }
+        }
+
+    @Suppress("UNCHECKED_CAST")
+    private suspend fun SequenceScope<Map.Entry<K, V>>.visit(node: Node) {
+        when (node) {
+            is BitmapNode -> {
+                for (i in 0 until node.dataCount) {
+                    yield(java.util.AbstractMap.SimpleImmutableEntry(node.keyAt(i) as K, node.valueAt(i) as V))
+                }
+                for (i in 0 until node.nodeCount) visit(node.nodeAt(i))
+            }
+            is CollisionNode -> {
+                for (i in node.keys.indices) {
+                    yield(java.util.AbstractMap.SimpleImmutableEntry(node.keys[i] as K, node.values[i] as V))
+                }
+            }
+        }
+    }
+
+    companion object {
+        private val EMPTY = PersistentMap<Any, Any>(EMPTY_NODE, 0)
+
+        @Suppress("UNCHECKED_CAST")
+        fun <K : Any, V : Any> empty(): PersistentMap<K, V> = EMPTY as PersistentMap<K, V>
+
+        fun <K : Any, V : Any> of(map: Map<out K, V>): PersistentMap<K, V> = empty<K, V>().putAll(map)
+    }
+}
+
+/**
+ * 已经是持久化 Map 时直接返回，否则复制一次
+ */
+fun <K : Any, V : Any> Map<K, V>.toPersistentMap(): PersistentMap<K, V> =
+    this as? PersistentMap<K, V> ?: PersistentMap.of(this)
+
+// ========== 节点 ==========
+
+private const val BITS = 5
+private const val MASK = (1 shl BITS) - 1
+private const val HASH_BITS = 32
+
+private fun fragment(hash: Int, shift: Int): Int = (hash ushr shift) and MASK
+
+private class Change {
+    var sizeDelta = 0
+}
+
+private abstract class Node {
+    abstract fun get(key: Any, hash: Int, shift: Int): Any?
+    abstract fun put(key: Any, value: Any, hash: Int, shift: Int, change: Change): Node
+    abstract fun remove(key: Any, hash: Int, shift: Int, change: Change): Node?
+
+    /** 只剩一个键值对时由父节点内联，保持结构规范 */
+    abstract val isSingleEntry: Boolean
+    abstract fun singleKey(): Any
+    abstract fun singleValue(): Any
+}
+
+private val EMPTY_NODE: Node = BitmapNode(0, 0, emptyArray())
+
+/**
+ * 内部节点：content 前部为 dataCount 个键值对（键、值交替），后部为子节点，
+ * 两部分各自按 5 位哈希片段升序排列
+ */
+private class BitmapNode(
+    private val dataMap: Int,
+    private val nodeMap: Int,
+    private val content: Array<Any?>
+) : Node() {
+
+    val dataCount: Int get() = Integer.bitCount(dataMap)
+    val nodeCount: Int get() = Integer.bitCount(nodeMap)
+
+    fun keyAt(index: Int): Any = content[2 * index]!!
+    fun valueAt(index: Int): Any = content[2 * index + 1]!!
+    fun nodeAt(index: Int): Node = content[2 * dataCount + index] as Node
+
+    override val isSingleEntry: Boolean
+        get() = nodeMap == 0 && Integer.bitCount(dataMap) == 1
+
+    override fun singleKey(): Any = keyAt(0)
+    override fun singleValue(): Any = valueAt(0)
+
+    override fun get(key: Any, hash: Int, shift: Int): Any? {
+        val bit = 1 shl fragment(hash, shift)
+        if (dataMap and bit != 0) {
+            val index = dataIndex(bit)
+            return if (keyAt(index) == key) valueAt(index) else null
+        }
+        if (nodeMap and bit != 0) {
+            return nodeAt(nodeIndex(bit)).get(key, hash, shift + BITS)
+        }
+        return null
+    }
+
+    override fun put(key: Any, value: Any, hash: Int, shift: Int, change: Change): Node {
+        val bit = 1 shl fragment(hash, shift)
+
+        if (dataMap and bit != 0) {
+            val index = dataIndex(bit)
+            val existingKey = keyAt(index)
+            if (existingKey == key) {
+                if (valueAt(index) === value) return this
+                val copy = content.copyOf()
+                copy[2 * index + 1] = value
+                return BitmapNode(dataMap, nodeMap, copy)
+            }
+            // 片段冲突：两个键下沉为子节点
+            change.sizeDelta = 1
+            val child = merge(existingKey, valueAt(index), existingKey.hashCode(), key, value, hash, shift + BITS)
+            return migrateDataToNode(bit, index, child)
+        }
+
+        if (nodeMap and bit != 0) {
+            val index = nodeIndex(bit)
+            val child = content[index] as Node
+            val newChild = child.put(key, value, hash, shift + BITS, change)
+            if (newChild === child) return this
+            val copy = content.copyOf()
+            copy[index] = newChild
+            return BitmapNode(dataMap, nodeMap, copy)
+        }
+
+        change.sizeDelta = 1
+        val index = 2 * dataIndex(bit)
+        val copy = arrayOfNulls<Any?>(content.size + 2)
+        System.arraycopy(content, 0, copy, 0, index)
+        copy[index] = key
+        copy[index + 1] = value
+        System.arraycopy(content, index, copy, index + 2, content.size - index)
+        return BitmapNode(dataMap or bit, nodeMap, copy)
+    }
+
+    override fun remove(key: Any, hash: Int, shift: Int, change: Change): Node? {
+        val bit = 1 shl fragment(hash, shift)
+
+        if (dataMap and bit != 0) {
+            val index = dataIndex(bit)
+            if (keyAt(index) != key) return this
+            change.sizeDelta = -1
+            if (content.size == 2) return null
+            val start = 2 * index
+            val copy = arrayOfNulls<Any?>(content.size - 2)
+            System.arraycopy(content, 0, copy, 0, start)
+            System.arraycopy(content, start + 2, copy, start, content.size - start - 2)
+            return BitmapNode(dataMap xor bit, nodeMap, copy)
+        }
+
+        if (nodeMap and bit != 0) {
+            val index = nodeIndex(bit)
+            val child = content[index] as Node
+            val newChild = child.remove(key, hash, shift + BITS, change)
+            if (newChild === child) return this
+            // 子节点至少有两个键值对，删除一个后不会为空
+            if (newChild!!.isSingleEntry) {
+                return migrateNodeToData(bit, index, newChild.singleKey(), newChild.singleValue())
+            }
+            val copy = content.copyOf()
+            copy[index] = newChild
+            return BitmapNode(dataMap, nodeMap, copy)
+        }
+
+        return this
+    }
+
+    // ========== 私有方法 ==========
+
+    private fun dataIndex(bit: Int): Int = Integer.bitCount(dataMap and (bit - 1))
+
+    private fun nodeIndex(bit: Int): Int = 2 * dataCount + Integer.bitCount(nodeMap and (bit - 1))
+
+    private fun migrateDataToNode(bit: Int, dataIndex: Int, child: Node): Node {
+        val oldStart = 2 * dataIndex
+        val newNodeMap = nodeMap or bit
+        // 新数组中子节点的位置：去掉一个键值对后的数据区长度 + 该位之前的子节点数
+        val newIndex = 2 * (dataCount - 1) + Integer.bitCount(newNodeMap and (bit - 1))
+        val copy = arrayOfNulls<Any?>(content.size - 1)
+        System.arraycopy(content, 0, copy, 0, oldStart)
+        System.arraycopy(content, oldStart + 2, copy, oldStart, newIndex - oldStart)
+        copy[newIndex] = child
+        System.arraycopy(content, newIndex + 2, copy, newIndex + 1, content.size - newIndex - 2)
+        return BitmapNode(dataMap xor bit, newNodeMap, copy)
+    }
+
+    private fun migrateNodeToData(bit: Int, nodeIndex: Int, key: Any, value: Any): Node {
+        val newDataMap = dataMap or bit
+        val newStart = 2 * Integer.bitCount(newDataMap and (bit - 1))
+        val copy = arrayOfNulls<Any?>(content.size + 1)
+        System.arraycopy(content, 0, copy, 0, newStart)
+        copy[newStart] = key
+        copy[newStart + 1] = value
+        System.arraycopy(content, newStart, copy, newStart + 2, nodeIndex - newStart)
+        System.arraycopy(content, nodeIndex + 1, copy, nodeIndex + 2, content.size - nodeIndex - 1)
+        return BitmapNode(newDataMap, nodeMap xor bit, copy)
+    }
+}
+
+/**
+ * 32 位哈希完全相同的键，线性查找
+ */
+private class CollisionNode(
+    val keys: Array<Any>,
+    val values: Array<Any>
+) : Node() {
+
+    override val isSingleEntry: Boolean
+        get() = keys.size == 1
+
+    override fun singleKey(): Any = keys[0]
+    override fun singleValue(): Any = values[0]
+
+    override fun get(key: Any, hash: Int, shift: Int): Any? {
+        val index = keys.indexOf(key)
+        return if (index >= 0) values[index] else null
+    }
+
+    override fun put(key: Any, value: Any, hash: Int, shift: Int, change: Change): Node {
+        val index = keys.indexOf(key)
+        if (index >= 0) {
+            if (values[index] === value) return this
+            return CollisionNode(keys, values.copyOf().also { it[index] = value })
+        }
+        change.sizeDelta = 1
+        return CollisionNode(keys + key, values + value)
+    }
+
+    override fun remove(key: Any, hash: Int, shift: Int, change: Change): Node? {
+        val index = keys.indexOf(key)
+        if (index < 0) return this
+        change.sizeDelta = -1
+        if (keys.size == 1) return null
+        val remaining = keys.indices.filter { it != index }
+        return CollisionNode(
+            remaining.map { keys[it] }.toTypedArray(),
+            remaining.map { values[it] }.toTypedArray()
+        )
+    }
+}
+
+private fun merge(
+    key1: Any, value1: Any, hash1: Int,
+    key2: Any, value2: Any, hash2: Int,
+    shift: Int
+): Node {
+    if (shift >= HASH_BITS) {
+        return CollisionNode(arrayOf(key1, key2), arrayOf(value1, value2))
+    }
+    val fragment1 = fragment(hash1, shift)
+    val fragment2 = fragment(hash2, shift)
+    if (fragment1 != fragment2) {
+        val content: Array<Any?> = if (fragment1 < fragment2) {
+            arrayOf(key1, value1, key2, value2)
+        } else {
+            arrayOf(key2, value2, key1, value1)
+        }
+        return BitmapNode((1 shl fragment1) or (1 shl fragment2), 0, content)
+    }
+    val child = merge(key1, value1, hash1, key2, value2, hash2, shift + BITS)
+    return BitmapNode(0, 1 shl fragment1, arrayOf(child))
+}
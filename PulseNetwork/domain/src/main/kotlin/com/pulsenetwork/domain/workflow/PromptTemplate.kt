@@ -0,0 +1,84 @@
+package com.pulsenetwork.domain.workflow
+
+import java.util.concurrent.ConcurrentHashMap
+
+/**
+ * 预编译的提示词模板
+ *
+ * 模板只解析一次，拆成字面量和 {{key}} 占位符交替的片段列表，
+ * 渲染时单遍写入预先定好容量的 StringBuilder。
+ * 上下文中没有的占位符原样保留；替换进来的值不会再被当作模板解析
+ */
+class PromptTemplate private constructor(
+    val source: String,
+    private val literals: Array<String>,
+    private val slots: Array<String>
+) {
+
+    /** 模板中引用的变量名（去重，按首次出现顺序） */
+    val placeholders: Set<String> = slots.toCollection(LinkedHashSet())
+
+    private val literalLength = literals.sumOf { it.length }
+
+    fun render(values: Map<String, Any>): String {
+        if (slots.isEmpty()) return source
+
+        // 先取出各占位符的值，以便一次分配足够的容量
+        val resolved = arrayOfNulls<String>(slots.size)
+        var length = literalLength
+        for (i in slots.indices) {
+            val value = values[slots[i]]?.toString() ?: "{{${slots[i]}}}"
+            resolved[i] = value
+            length += value.length
+        }
+
+        val builder = StringBuilder(length)
+        for (i in slots.indices) {
+            builder.append(literals[i]).append(resolved[i])
+        }
+        builder.append(literals[slots.size])
+        return builder.toString()
+    }
+
+    companion object {
+        // 模板来自工作流配置，数量有限；超过上限时整体清空
+        private const val MAX_CACHED_TEMPLATES = 256
+
+        private val cache = ConcurrentHashMap<String, PromptTemplate>()
+
+        /**
+         * 编译模板，相同的模板字符串复用同一个实例
+         */
+        fun compile(template: String): PromptTemplate {
+            cache[template]?.let { return it }
+            if (cache.size >= MAX_CACHED_TEMPLATES) cache.clear()
+            return cache.computeIfAbsent(template, ::parse)
+        }
+
+        // ========== 私有方法 ==========
+
+        /**
+         * literals 总比 slots 多一个：literals[i] 位于 slots[i] 之前，最后一个是结尾
+         */
+        private fun parse(template: String): PromptTemplate {
+            val literals = ArrayList<String>()
+            val slots = ArrayList<String>()
+            var literalStart = 0
+            var index = 0
+
+            while (true) {
+                val open = template.indexOf("{{", index)
+                if (open < 0) break
+                val close = template.indexOf("}}", open + 2)
+                if (close < 0) break
+                literals.add(template.substring(literalStart, open))
+                slots.add(template.substring(open + 2, close))
+                literalStart = close + 2
+                index = literalStart
+            }
+            literals.add(template.substring(literalStart))
+
+            return PromptTemplate(template, literals.toTypedArray(), slots.toTypedArray())
+        }
+    }
+}
@@ -0,0 +1,170 @@
+package com.pulsenetwork.domain.workflow
+
+import java.nio.ByteBuffer
+
+/**
+ * 单段的认证加密（AES-GCM 等 AEAD），nonce 12 字节，输出为密文 + 16 字节 tag
+ */
+interface SegmentCipher {
+    fun seal(nonce: ByteArray, aad: ByteArray, input: ByteArray, offset: Int, length: Int): ByteArray
+
+    /**
+     * @return 明文；校验失败时为 null
+     */
+    fun open(nonce: ByteArray, aad: ByteArray, input: ByteArray, offset: Int, length: Int): ByteArray?
+}
+
+class SealedStreamException(message: String) : Exception(message)
+
+/**
+ * 分段认证加密（STREAM 构造）
+ *
+ * 数据分成若干段，每段单独加密，可以只解密需要的那一段：
+ * 工作流核心逻辑按步骤分段，执行到哪一步解密哪一步；大数据按固定大小分块，边读边解密。
+ *
+ * 格式：头部 [魔数 "PWSE" | 版本 1 | nonce 前缀 7 字节]，
+ * 之后每段 [明文长度 u32 | 密文 | tag 16 字节]。
+ * 第 i 段的 nonce = 前缀 | i (u32) | 是否最后一段 (1 字节)，附加数据 = 头部 | 该段长度。
+ * 段被篡改、调换顺序、截断（末段不再带最后一段标记）都会在解密该段时校验失败
+ */
+object SealedStream {
+
+    const val NONCE_PREFIX_BYTES = 7
+    const val DEFAULT_CHUNK_BYTES = 64 * 1024
+
+    private val MAGIC = byteArrayOf('P'.code.toByte(), 'W'.code.toByte(), 'S'.code.toByte(), 'E'.code.toByte())
+    private const val VERSION: Byte = 1
+    private const val HEADER_BYTES = 12
+    private const val LENGTH_BYTES = 4
+    private const val TAG_BYTES = 16
+
+    /**
+     * 每个元素加密为一段（至少一段）
+     * @param noncePrefix 7 字节随机数，同一密钥下不可重复
+     */
+    fun seal(cipher: SegmentCipher, segments: List<ByteArray>, noncePrefix: ByteArray): ByteArray {
+        require(segments.isNotEmpty()) { "At least one segment is required" }
+        require(noncePrefix.size == NONCE_PREFIX_BYTES) { "Nonce prefix must be $NONCE_PREFIX_BYTES bytes" }
+
+        val header = MAGIC + VERSION + noncePrefix
+        val sealed = segments.mapIndexed { index, segment ->
+            cipher.seal(
+                nonce(header, index, index == segments.lastIndex),
+                aad(header, segment.size),
+                segment, 0, segment.size
+            )
+        }
+
+        val buffer = ByteBuffer.allocate(HEADER_BYTES + sealed.sumOf { LENGTH_BYTES + it.size })
+        buffer.put(header)
+        for (segment in sealed) {
+            buffer.putInt(segment.size - TAG_BYTES)
+            buffer.put(segment)
+        }
+        return buffer.array()
+    }
+
+    /**
+     * 按固定大小分块加密（不复制分块，直接按偏移加密）
+     */
+    fun sealChunked(
+        cipher: SegmentCipher,
+        data: ByteArray,
+        noncePrefix: ByteArray,
+        chunkBytes: Int = DEFAULT_CHUNK_BYTES
+    ): ByteArray {
+        require(chunkBytes > 0)
+        require(noncePrefix.size == NONCE_PREFIX_BYTES) { "Nonce prefix must be $NONCE_PREFIX_BYTES bytes" }
+
+        val header = MAGIC + VERSION + noncePrefix
+        val count = maxOf(1, (data.size + chunkBytes - 1) / chunkBytes)
+        val buffer = ByteBuffer.allocate(HEADER_BYTES + data.size + count * (LENGTH_BYTES + TAG_BYTES))
+        buffer.put(header)
+        for (index in 0 until count) {
+            val offset = index * chunkBytes
+            val length = minOf(chunkBytes, data.size - offset)
+            buffer.putInt(length)
+            buffer.put(cipher.seal(nonce(header, index, index == count - 1), aad(header, length), data, offset, length))
+        }
+        return buffer.array()
+    }
+
+    /**
+     * 解析分段结构（不解密）
+     * @throws SealedStreamException 格式不对
+     */
+    fun open(cipher: SegmentCipher, sealed: ByteArray): Reader {
+        if (sealed.size < HEADER_BYTES || !sealed.copyOfRange(0, MAGIC.size).contentEquals(MAGIC)) {
+            throw SealedStreamException("Not a sealed stream")
+        }
+        if (sealed[MAGIC.size] != VERSION) {
+            throw SealedStreamException("Unsupported version ${sealed[MAGIC.size]}")
+        }
+
+        val offsets = ArrayList<Int>()
+        val buffer = ByteBuffer.wrap(sealed)
+        var position = HEADER_BYTES
+        while (position < sealed.size) {
+            if (sealed.size - position < LENGTH_BYTES + TAG_BYTES) throw SealedStreamException("Truncated segment")
+            val length = buffer.getInt(position)
+            if (length < 0 || length > sealed.size - position - LENGTH_BYTES - TAG_BYTES) {
+                throw SealedStreamException("Truncated segment")
+            }
+            offsets.add(position)
+            position += LENGTH_BYTES + length + TAG_BYTES
+        }
+        if (offsets.isEmpty()) throw SealedStreamException("No segments")
+
+        return Reader(cipher, sealed, sealed.copyOfRange(0, HEADER_BYTES), offsets)
+    }
+
+    /**
+     * 按需解密各段
+     */
+    class Reader internal constructor(
+        private val cipher: SegmentCipher,
+        private val sealed: ByteArray,
+        private val header: ByteArray,
+        private val offsets: List<Int>
+    ) {
+        val size: Int
+            get() = offsets.size
+
+        /**
+         * @throws SealedStreamException 校验失败（篡改、截断、密钥不符）
+         */
+        fun segment(index: Int): ByteArray {
+            val offset = offsets[index]
+            val length = ByteBuffer.wrap(sealed).getInt(offset)
+            return cipher.open(
+                nonce(header, index, index == offsets.lastIndex),
+                aad(header, length),
+                sealed, offset + LENGTH_BYTES, length + TAG_BYTES
+            ) ?: throw SealedStreamException("Segment $index failed authentication")
+        }
+
+        /**
+         * 依次解密，只在取到某一段时才解密该段
+         */
+        fun segments(): Sequence<ByteArray> = (0 until size).asSequence().map { segment(it) }
+
+        fun readAll(): ByteArray {
+            val parts = segments().toList()
+            val buffer = ByteBuffer.allocate(parts.sumOf { it.size })
+            parts.forEach { buffer.put(it) }
+            return buffer.array()
+        }
+    }
+
+    // ========== 私有方法 ==========
+
+    private fun nonce(header: ByteArray, index: Int, last: Boolean): ByteArray =
+        ByteBuffer.allocate(12)
+            .put(header, MAGIC.size + 1, NONCE_PREFIX_BYTES)
+            .putInt(index)
+            .put((if (last) 1 else 0).toByte())
+            .array()
+
+    private fun aad(header: ByteArray, length: Int): ByteArray =
+        ByteBuffer.allocate(HEADER_BYTES + LENGTH_BYTES).put(header).putInt(length).array()
+}
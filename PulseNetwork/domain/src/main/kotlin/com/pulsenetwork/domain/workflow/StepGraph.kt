@@ -0,0 +1,100 @@
+package com.pulsenetwork.domain.workflow
+
+/**
+ * 步骤占用的资源类别，并行执行时按类别限制并发
+ */
+enum class ResourceClass {
+    LOCAL_LLM,    // 本机推理，原生会话同一时间只能服务一个请求
+    REMOTE,       // 网络节点或外部接口，主要耗时在等待
+    CPU           // 本地轻量计算
+}
+
+val StepType.resourceClass: ResourceClass
+    get() = when (this) {
+        StepType.LOCAL_INFERENCE, StepType.PARALLEL_BATCH -> ResourceClass.LOCAL_LLM
+        StepType.REMOTE_INFERENCE, StepType.EXTERNAL_API -> ResourceClass.REMOTE
+        StepType.DATA_TRANSFORM, StepType.CONDITION_CHECK,
+        StepType.AGGREGATION, StepType.USER_INPUT -> ResourceClass.CPU
+    }
+
+/**
+ * 工作流步骤的依赖图（DAG）
+ *
+ * - 构造时校验：步骤 ID 唯一、依赖都存在、没有环，不满足时抛出 IllegalArgumentException
+ * - priority：从该步骤到任一终点的最长路径耗时（含自身），越大越靠近关键路径，应越早启动
+ *
+ * @param cost 步骤预估耗时（毫秒），默认按资源类别估计
+ */
+class StepGraph(
+    steps: List<WorkflowStep>,
+    cost: (WorkflowStep) -> Long = ::defaultCost
+) {
+
+    val steps: Map<String, WorkflowStep>
+
+    /** 拓扑序，同一层内按 order */
+    val topologicalOrder: List<WorkflowStep>
+
+    val priority: Map<String, Long>
+
+    private val dependents: Map<String, List<String>>
+
+    init {
+        val byId = LinkedHashMap<String, WorkflowStep>()
+        for (step in steps.sortedBy { it.order }) {
+            require(byId.put(step.id, step) == null) { "Duplicate step id: ${step.id}" }
+        }
+        this.steps = byId
+
+        val children = byId.keys.associateWith { mutableListOf<String>() }
+        for (step in byId.values) {
+            for (dependency in step.dependencies.distinct()) {
+                val list = children[dependency]
+                    ?: throw IllegalArgumentException("Step ${step.id} depends on unknown step $dependency")
+                list.add(step.id)
+            }
+        }
+        dependents = children
+
+        // Kahn 算法；输入已按 order 排好，先入先出即保持同层顺序
+        val indegree = byId.mapValuesTo(HashMap()) { it.value.dependencies.distinct().size }
+        val queue = ArrayDeque(byId.values.filter { indegree[it.id] == 0 })
+        val order = ArrayList<WorkflowStep>(byId.size)
+        while (queue.isNotEmpty()) {
+            val step = queue.removeFirst()
+            order.add(step)
+            for (child in dependents.getValue(step.id)) {
+                val remaining = indegree.getValue(child) - 1
+                indegree[child] = remaining
+                if (remaining == 0) queue.addLast(byId.getValue(child))
+            }
+        }
+        require(order.size == byId.size) {
+            "Workflow has a dependency cycle among: ${indegree.filterValues { it > 0 }.keys}"
+        }
+        topologicalOrder = order
+
+        // 逆拓扑序累加最长路径
+        val longest = HashMap<String, Long>(byId.size)
+        for (step in order.asReversed()) {
+            val tail = dependents.getValue(step.id).maxOfOrNull { longest.getValue(it) } ?: 0L
+            longest[step.id] = cost(step) + tail
+        }
+        priority = longest
+    }
+
+    fun dependents(stepId: String): List<String> = dependents[stepId] ?: emptyList()
+
+    /**
+     * 关键路径的预估耗时，即无限并发时的理论最短完成时间
+     */
+    fun criticalPathMs(): Long = priority.values.maxOrNull() ?: 0L
+
+    companion object {
+        fun defaultCost(step: WorkflowStep): Long = when (step.type.resourceClass) {
+            ResourceClass.LOCAL_LLM -> 3000L
+            ResourceClass.REMOTE -> 2000L
+            ResourceClass.CPU -> 10L
+        }
+    }
+}
@@ -0,0 +1,153 @@
+package com.pulsenetwork.domain.workflow
+
+/**
+ * 一段已结束的计时区间
+ *
+ * @param traceId 所属工作流 ID
+ * @param category 类别：step / attempt / cache / llm / remote 等
+ * @param startMicros 开始时间（Unix 微秒）
+ * @param threadId 开始时所在线程，导出时作为泳道
+ */
+data class TraceSpan(
+    val traceId: String,
+    val name: String,
+    val category: String,
+    val startMicros: Long,
+    val durationMicros: Long,
+    val threadId: Long,
+    val args: Map<String, String> = emptyMap()
+)
+
+/**
+ * 环形缓冲的追踪存储
+ *
+ * 只保留最近 capacity 个区间，写满后覆盖最旧的，内存占用固定。
+ * 时间戳以 nanoTime 为基准换算到 Unix 微秒，同一进程内单调且精确到微秒。
+ * 可导出为 Chrome trace JSON（chrome://tracing、Perfetto 直接打开，火焰图视图）
+ */
+class Tracer(private val capacity: Int = 4096) {
+
+    private val buffer = arrayOfNulls<TraceSpan>(capacity)
+    private var next = 0L
+    private val lock = Any()
+
+    private val baseNanos = System.nanoTime()
+    private val baseMicros = System.currentTimeMillis() * 1000
+
+    init {
+        require(capacity > 0)
+    }
+
+    fun nowMicros(): Long = baseMicros + (System.nanoTime() - baseNanos) / 1000
+
+    fun record(span: TraceSpan) {
+        synchronized(lock) {
+            buffer[(next % capacity).toInt()] = span
+            next++
+        }
+    }
+
+    /**
+     * 对 block 计时并记录；block 抛出异常时同样记录，args 中加上 error
+     */
+    inline fun <T> trace(
+        traceId: String,
+        name: String,
+        category: String,
+        args: Map<String, String> = emptyMap(),
+        block: () -> T
+    ): T {
+        val start = nowMicros()
+        val threadId = Thread.currentThread().id
+        var failed: Throwable? = null
+        try {
+            return block()
+        } catch (e: Throwable) {
+            failed = e
+            throw e
+        } finally {
+            val spanArgs = failed?.let { args + ("error" to (it.message ?: it.javaClass.simpleName)) } ?: args
+            record(TraceSpan(traceId, name, category, start, nowMicros() - start, threadId, spanArgs))
+        }
+    }
+
+    /**
+     * 按开始时间排序的区间
+     * @param traceId 为 null 时返回全部
+     */
+    fun spans(traceId: String? = null): List<TraceSpan> {
+        val snapshot = synchronized(lock) {
+            val count = minOf(next, capacity.toLong()).toInt()
+            val first = next - count
+            List(count) { buffer[((first + it) % capacity).toInt()]!! }
+        }
+        return snapshot
+            .filter { traceId == null || it.traceId == traceId }
+            .sortedBy { it.startMicros }
+    }
+
+    fun clear() {
+        synchronized(lock) {
+            buffer.fill(null)
+            next = 0
+        }
+    }
+
+    /**
+     * 导出 Chrome trace 格式（Trace Event Format 的完整事件 "X"）
+     */
+    fun exportChromeTrace(traceId: String? = null): String {
+        val builder = StringBuilder()
+        builder.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[")
+        spans(traceId).forEachIndexed { index, span ->
+            if (index > 0) builder.append(',')
+            builder.append("{\"name\":").appendJsonString(span.name)
+                .append(",\"cat\":").appendJsonString(span.category)
+                .append(",\"ph\":\"X\",\"ts\":").append(span.startMicros)
+                .append(",\"dur\":").append(span.durationMicros)
+                .append(",\"pid\":1,\"tid\":").append(span.threadId)
+                .append(",\"args\":{\"traceId\":").appendJsonString(span.traceId)
+            span.args.forEach { (key, value) ->
+                builder.append(',').appendJsonString(key).append(':').appendJsonString(value)
+            }
+            builder.append("}}")
+        }
+        builder.append("]}")
+        return builder.toString()
+    }
+
+    // ========== 私有方法 ==========
+
+    private fun StringBuilder.appendJsonString(value: String): StringBuilder {
+        append('"')
+        for (c in value) {
+            when {
+                c == '"' -> append("\\\"")
+                c == '\\' -> append("\\\\")
+                c == '\n' -> append("\\n")
+                c == '\r' -> append("\\r")
+                c == '\t' -> append("\\t")
+                c < ' ' -> append("\\u%04x".format(c.code))
+                else -> append(c)
+            }
+        }
+        return append('"')
+    }
+}
+
+/**
+ * 步骤耗时的指数加权移动平均
+ *
+ * 用历史耗时代替按步骤序号的线性外推来估计剩余时间；
+ * 新样本权重 alpha，越大越跟随最近的变化
+ */
+class StepLatencyStats(private val alpha: Double = 0.3) {
+
+    private val averages = java.util.concurrent.ConcurrentHashMap<String, Double>()
+
+    fun record(key: String, durationMs: Long) {
+        averages.merge(key, durationMs.toDouble()) { old, sample -> old + alpha * (sample - old) }
+    }
+
+    fun estimate(key: String): Long? = averages[key]?.toLong()
+}
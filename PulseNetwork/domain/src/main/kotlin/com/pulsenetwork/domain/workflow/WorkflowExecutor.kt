@@ -15,18 +15,29 @@ interface WorkflowExecutor {
 
     /**
      * 执行工作流
+     *
+     * 调用方协程被取消时抛出 CancellationException，已完成步骤的检查点保留，之后可以续跑
      * @param workflow 要执行的工作流
-     * @return 执行结果
+     * @return 执行结果；经 cancel 取消时为 Cancelled
      */
     suspend fun execute(workflow: ExecutableWorkflow): WorkflowExecutionResult
 
+    /**
+     * 执行加密工作流
+     *
+     * 载入时只解密概要段（步骤与依赖关系），各步骤的配置在执行到该步骤时才解密
+     * @param inputs 按 publicInterface.inputs 中的名称提供
+     * @throws SealedStreamException 核心逻辑损坏或不是本设备加密的
+     */
+    suspend fun execute(workflow: EncryptedWorkflow, inputs: Map<String, Any>): WorkflowExecutionResult
+
     /**
      * 获取执行进度流
      */
     fun executionProgressFlow(workflowId: String): Flow<ExecutionProgress>
 
     /**
-     * 取消执行
+     * 取消执行，同时丢弃检查点
      */
     suspend fun cancel(workflowId: String): Boolean
 
@@ -49,6 +60,19 @@ interface WorkflowExecutor {
      * 恢复执行
      */
     suspend fun resume(workflowId: String): Boolean
+
+    /**
+     * 导出执行追踪（Chrome trace JSON，可在 chrome://tracing 或 Perfetto 中打开）
+     * @param workflowId 为 null 时导出缓冲区内全部工作流
+     */
+    fun exportTrace(workflowId: String? = null): String
+
+    /**
+     * 上次未正常结束（如进程被杀）的工作流 ID
+     *
+     * 用相同的工作流再次调用 execute 会从最后完成的步骤继续
+     */
+    suspend fun getInterruptedWorkflowIds(): List<String>
 }
 
 /**
@@ -63,8 +87,20 @@ data class ExecutableWorkflow(
     val timeout: Long = 300000,  // 5分钟默认超时
     val retryPolicy: RetryPolicy = RetryPolicy(),
     val executionMode: ExecutionMode = ExecutionMode.SEQUENTIAL,
-    val createdAt: Long = System.currentTimeMillis()
-)
+    val createdAt: Long = System.currentTimeMillis(),
+    val sealedCore: SealedStream.Reader? = null  // StepConfig.Sealed 步骤的配置来源
+) {
+    /**
+     * ConditionCheck 步骤编译后的条件，按步骤 ID 索引，整个工作流只解析一次；
+     * 有语法错误的条件不在其中，执行到该步骤时再报告
+     */
+    val conditions: Map<String, Expression> by lazy {
+        steps.mapNotNull { step ->
+            val config = step.config as? StepConfig.ConditionCheck ?: return@mapNotNull null
+            runCatching { step.id to Expression.compile(config.condition) }.getOrNull()
+        }.toMap()
+    }
+}
 
 /**
  * 工作流步骤
@@ -77,9 +113,43 @@ data class WorkflowStep(
     val dependencies: List<String> = emptyList(),  // 依赖的步骤ID
     val timeout: Long = 60000,
     val retryCount: Int = 3,
-    val order: Int
+    val order: Int,
+    val cache: CachePolicy = CachePolicy(),
+    val condition: String? = null  // 执行条件（语法见 Expression），不成立时跳过本步骤
 )
 
+/**
+ * 步骤结果缓存策略
+ *
+ * 只对结果由配置和输入决定的步骤生效（见 WorkflowStep.memoizable），
+ * 键为步骤配置与其实际读取的输入值的哈希，与步骤 ID 和所在工作流无关
+ * @param enabled false 表示每次都重新执行
+ * @param ttlMs 结果有效期
+ */
+data class CachePolicy(
+    val enabled: Boolean = true,
+    val ttlMs: Long = 24 * 60 * 60 * 1000L
+) {
+    companion object {
+        val DISABLED = CachePolicy(enabled = false)
+    }
+}
+
+/**
+ * 结果可以复用的步骤
+ *
+ * 本地推理只在贪心解码（temperature <= 0）或固定种子时由输入决定；批处理按其模板判断。
+ * 远程推理、外部调用和用户输入有副作用或依赖外部状态，从不复用
+ */
+val WorkflowStep.memoizable: Boolean
+    get() = when (type) {
+        StepType.LOCAL_INFERENCE ->
+            (config as? StepConfig.LocalInference)?.let { it.temperature <= 0f || it.seed >= 0 } == true
+        StepType.PARALLEL_BATCH ->
+            (config as? StepConfig.ParallelBatch)?.stepTemplate?.memoizable == true
+        else -> false
+    }
+
 /**
  * 步骤类型
  */
@@ -102,7 +172,9 @@ sealed class StepConfig {
         val modelType: String,
         val promptTemplate: String,
         val maxTokens: Int = 512,
-        val temperature: Float = 0.7f
+        val temperature: Float = 0.7f,
+        val outputFormat: OutputFormat = OutputFormat.TEXT,
+        val seed: Int = -1          // 非负时采样可复现，-1 表示随机种子
     ) : StepConfig()
 
     data class RemoteInference(
@@ -119,14 +191,23 @@ sealed class StepConfig {
     ) : StepConfig()
 
     data class ConditionCheck(
-        val condition: String,  // 表达式
+        val condition: String,  // 表达式，语法见 Expression
         val trueBranch: String?,  // 步骤ID
         val falseBranch: String?
     ) : StepConfig()
 
+    /**
+     * 对 context[inputKey] 中的每一项执行 stepTemplate，结果按输入顺序收集
+     *
+     * 输入为 List 或按行分隔的字符串；模板中用 {{itemKey}} 引用当前项。
+     * 本地推理模板每 batchSize 项合成一次批量解码，其他模板最多 maxConcurrency 项同时执行
+     */
     data class ParallelBatch(
         val batchSize: Int,
-        val stepTemplate: WorkflowStep
+        val stepTemplate: WorkflowStep,
+        val inputKey: String = "items",
+        val itemKey: String = "item",
+        val maxConcurrency: Int = 4
     ) : StepConfig()
 
     data class Aggregation(
@@ -146,6 +227,13 @@ sealed class StepConfig {
         val inputType: InputType,
         val timeout: Long = 300000
     ) : StepConfig()
+
+    /**
+     * 配置加密存放在 ExecutableWorkflow.sealedCore 的第 segment 段，执行到该步骤时才解密
+     */
+    data class Sealed(
+        val segment: Int
+    ) : StepConfig()
 }
 
 /**
@@ -158,6 +246,14 @@ enum class TrustLevelRequirement {
     INTIMATE    // 仅亲密节点
 }
 
+/**
+ * 推理输出格式
+ */
+enum class OutputFormat {
+    TEXT,           // 自由文本
+    JSON            // 约束解码，一次生成合法 JSON
+}
+
 /**
  * 聚合类型
  */
@@ -0,0 +1,159 @@
+package com.pulsenetwork.domain.swarm
+
+import org.junit.Assert.*
+import org.junit.Assume.assumeTrue
+import org.junit.Test
+import kotlin.random.Random
+
+/**
+ * 淘汰堆测试
+ */
+class EvictionHeapTest {
+
+    @Test
+    fun `poll returns keys in ascending priority order`() {
+        val random = Random(42)
+        val heap = EvictionHeap<Int>()
+        val priorities = (0 until 500).associateWith { random.nextDouble() }
+        priorities.forEach { (key, priority) -> heap.offer(key, priority) }
+
+        val expected = priorities.entries.sortedBy { it.value }.map { it.key }
+        val actual = generateSequence { heap.poll() }.toList()
+
+        assertEquals(expected, actual)
+        assertTrue(heap.isEmpty())
+    }
+
+    @Test
+    fun `offer updates priority of an existing key`() {
+        val heap = EvictionHeap<String>()
+        heap.offer("a", 1.0)
+        heap.offer("b", 2.0)
+        heap.offer("c", 3.0)
+
+        heap.offer("a", 5.0)
+        assertEquals(3, heap.size)
+        assertEquals("b", heap.peek())
+
+        heap.offer("c", 0.5)
+        assertEquals("c", heap.poll())
+        assertEquals("b", heap.poll())
+        assertEquals("a", heap.poll())
+        assertNull(heap.poll())
+    }
+
+    @Test
+    fun `remove keeps heap order`() {
+        val heap = EvictionHeap<Int>(initialCapacity = 2)
+        for (i in 0 until 100) heap.offer(i, ((i * 37) % 100).toDouble())
+        for (i in 0 until 100 step 3) assertTrue(heap.remove(i))
+        assertFalse(heap.remove(0))
+
+        var last = Double.NEGATIVE_INFINITY
+        while (!heap.isEmpty()) {
+            val key = heap.peek()!!
+            val priority = heap.priorityOf(key)!!
+            assertTrue(priority >= last)
+            assertNotEquals(0, key % 3)
+            last = priority
+            heap.poll()
+        }
+    }
+
+    @Test
+    fun `evictionKey orders entries like effectiveScore`() {
+        val now = System.currentTimeMillis()
+        val hour = 60 * 60 * 1000L
+        val entries = listOf(
+            entry("fresh", 0.9f, now, 0),
+            entry("old", 0.9f, now - 48 * hour, 0),
+            entry("hot", 0.5f, now - 12 * hour, 200),
+            entry("poor", 0.2f, now - 2 * hour, 3),
+            entry("stale", 1.0f, now - 96 * hour, 50)
+        )
+
+        val byScore = entries.sortedBy { it.effectiveScore() }.map { it.id }
+        val byKey = entries.sortedBy { it.evictionKey() }.map { it.id }
+
+        assertEquals(byScore, byKey)
+    }
+
+    @Test
+    fun `steady-state eviction keeps the highest priorities`() {
+        val n = 10_000
+        val random = Random(n)
+        val heap = EvictionHeap<Int>(n + 1)
+        val priorities = DoubleArray(2 * n) { random.nextDouble() }
+        for (i in 0 until n) heap.offer(i, priorities[i])
+
+        // 满载后每次插入都伴随一次淘汰，与缓存写满后的 addToLocalCache 相同
+        for (i in n until 2 * n) {
+            heap.offer(i, priorities[i])
+            heap.poll()
+        }
+
+        val survivors = generateSequence { heap.poll() }.toList()
+        assertEquals(n, survivors.size)
+        assertEquals(
+            priorities.indices.sortedBy { priorities[it] }.takeLast(n).toSet(),
+            survivors.toSet()
+        )
+        assertTrue(survivors.zipWithNext().all { (a, b) -> priorities[a] <= priorities[b] })
+    }
+
+    /**
+     * 微基准：满载后每次插入伴随一次淘汰，与每次全量排序的旧做法对比。
+     * 计时受机器负载影响，不做断言；默认跳过，用
+     * ./gradlew :domain:testDebugUnitTest -Ppulse.benchmark --tests '*EvictionHeapTest*' 运行
+     */
+    @Test
+    fun `benchmark insert and evict at 10k and 100k entries`() {
+        assumeTrue(System.getProperty("pulse.benchmark") == "true")
+
+        for (n in listOf(10_000, 100_000)) {
+            val random = Random(n)
+            val heap = EvictionHeap<Int>(n + 1)
+            for (i in 0 until n) heap.offer(i, random.nextDouble())
+
+            // 预热，让 JIT 编译完热点路径再计时
+            var next = n
+            repeat(n) {
+                heap.offer(next++, random.nextDouble())
+                heap.poll()
+            }
+            val start = System.nanoTime()
+            repeat(n) {
+                heap.offer(next++, random.nextDouble())
+                heap.poll()
+            }
+            val heapNs = (System.nanoTime() - start) / n
+
+            // 全量排序每次 O(n log n)，只跑少量几次
+            val scores = HashMap<Int, Double>(n * 2)
+            for (i in 0 until n) scores[i] = random.nextDouble()
+            val sortOps = 20
+            val sortStart = System.nanoTime()
+            repeat(sortOps) {
+                scores[next++] = random.nextDouble()
+                val evicted = scores.entries.sortedBy { it.value }.first().key
+                scores.remove(evicted)
+            }
+            val sortNs = (System.nanoTime() - sortStart) / sortOps
+
+            println("EvictionHeap n=$n: heap $heapNs ns, full sort $sortNs ns per insert+evict")
+            assertEquals(n, heap.size)
+        }
+    }
+
+    private fun entry(id: String, quality: Float, createdAt: Long, hits: Int) = SemanticCacheEntry(
+        id = id,
+        query = id,
+        queryVector = null,
+        answer = id,
+        qualityScore = quality,
+        sourceNodeId = "node1",
+        createdAt = createdAt,
+        lastAccessedAt = createdAt,
+        hitCount = hits
+    )
+}
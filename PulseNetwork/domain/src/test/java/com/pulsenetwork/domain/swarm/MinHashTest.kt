@@ -0,0 +1,58 @@
+package com.pulsenetwork.domain.swarm
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * MinHash 与 LSH 索引测试
+ */
+class MinHashTest {
+
+    private val hasher = MinHasher()
+
+    @Test
+    fun `Chinese paraphrases without spaces clear the text lookup threshold`() {
+        // 二元组 Jaccard 为 10/11，64 个哈希的估计标准差约 0.036，离 0.7 有五倍以上余量
+        val a = hasher.signature("怎么设置手机的省电模式？")!!
+        val b = hasher.signature("怎么设置手机的省电模式呢")!!
+        val unrelated = hasher.signature("推荐一部好看的电影")!!
+
+        assertTrue(hasher.similarity(a, b) >= TEXT_SIMILARITY_THRESHOLD)
+        assertTrue(hasher.similarity(a, unrelated) < 0.2f)
+    }
+
+    @Test
+    fun `normalization ignores case whitespace and punctuation`() {
+        val a = hasher.signature("What is the capital of France?")!!
+        val b = hasher.signature("what is the capital of france")!!
+
+        assertEquals(1.0f, hasher.similarity(a, b), 0.0f)
+        assertNull(hasher.signature(" ？！... "))
+    }
+
+    @Test
+    fun `LSH returns near duplicates as candidates`() {
+        val index = LshIndex<String>()
+        index.add("power", hasher.signature("怎么设置手机的省电模式？")!!)
+        index.add("movie", hasher.signature("推荐一部好看的电影")!!)
+
+        val candidates = index.candidates(hasher.signature("怎么设置手机的省电模式呢")!!)
+        assertTrue("power" in candidates)
+        assertFalse("movie" in candidates)
+    }
+
+    @Test
+    fun `removed keys are no longer candidates`() {
+        val index = LshIndex<String>()
+        val signature = hasher.signature("今天北京的天气怎么样")!!
+        index.add("weather", signature)
+        index.remove("weather", signature)
+
+        assertTrue(index.candidates(signature).isEmpty())
+    }
+
+    companion object {
+        // 与 SemanticCacheService 的文本查询阈值一致
+        private const val TEXT_SIMILARITY_THRESHOLD = 0.7f
+    }
+}
@@ -0,0 +1,105 @@
+package com.pulsenetwork.domain.workflow
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * 条件表达式测试
+ */
+class ExpressionTest {
+
+    private val context = mapOf<String, Any?>(
+        "score" to "0.85",
+        "count" to 3,
+        "label" to "Positive",
+        "tags" to listOf("a", "b"),
+        "result" to mapOf("label" to "spam", "items" to listOf(10, 20)),
+        "step1.response" to "ok",
+        "empty" to ""
+    )
+
+    @Test
+    fun `comparison operators including two-character ones`() {
+        assertTrue(test("score >= 0.85"))
+        assertTrue(test("score <= 0.85"))
+        assertFalse(test("score > 0.85"))
+        assertTrue(test("count != 4"))
+        assertTrue(test("count == 3.0"))
+        assertTrue(test("label == 'Positive'"))
+    }
+
+    @Test
+    fun `boolean operators and precedence`() {
+        assertTrue(test("count > 1 && score > 0.5"))
+        assertTrue(test("count > 5 || label == \"Positive\""))
+        assertFalse(test("not (count > 1 and score > 0.5)"))
+        assertTrue(test("count + 2 * 3 == 9"))
+        assertTrue(test("!missing && -count < 0"))
+    }
+
+    @Test
+    fun `key paths and functions`() {
+        assertTrue(test("result.label == 'spam'"))
+        assertTrue(test("result.items[1] == 20"))
+        assertTrue(test("result[\"label\"] == 'spam'"))
+        assertTrue(test("step1.response == 'ok'"))
+        assertTrue(test("len(tags) == 2 && contains(tags, 'b')"))
+        assertTrue(test("lower(label) == 'positive' && startsWith(label, 'Pos')"))
+        assertTrue(test("empty(empty) && !exists(result.missing)"))
+        assertTrue(test("max(count, num(score)) == 3"))
+    }
+
+    @Test
+    fun `unquoted right-hand words fall back to strings`() {
+        assertTrue(test("label == Positive"))
+        assertTrue(test("result.label != ham"))
+        assertFalse(test("missing == Positive"))
+        // 上下文中存在的键仍按变量取值
+        assertTrue(test("count == count"))
+        assertFalse(test("label == result"))
+    }
+
+    @Test
+    fun `syntax errors are reported with position`() {
+        for (source in listOf("count >", "len(a, b)", "unknown(1)", "'open", "a == 1 b")) {
+            try {
+                Expression.compile(source)
+                fail("Expected ExpressionException for $source")
+            } catch (e: ExpressionException) {
+                assertTrue(e.position >= 0)
+            }
+        }
+    }
+
+    @Test
+    fun `workflow compiles each condition once`() {
+        val workflow = ExecutableWorkflow(
+            id = "wf",
+            name = "wf",
+            description = "",
+            steps = listOf(
+                WorkflowStep(
+                    id = "check",
+                    name = "check",
+                    type = StepType.CONDITION_CHECK,
+                    config = StepConfig.ConditionCheck("count >= 3", "next", null),
+                    order = 0
+                ),
+                WorkflowStep(
+                    id = "broken",
+                    name = "broken",
+                    type = StepType.CONDITION_CHECK,
+                    config = StepConfig.ConditionCheck("count >=", null, null),
+                    order = 1
+                )
+            ),
+            inputs = emptyMap()
+        )
+
+        assertSame(workflow.conditions["check"], workflow.conditions["check"])
+        assertTrue(workflow.conditions.getValue("check").test(context))
+        assertNull(workflow.conditions["broken"])
+    }
+
+    private fun test(source: String) = Expression.compile(source).test(context)
+}
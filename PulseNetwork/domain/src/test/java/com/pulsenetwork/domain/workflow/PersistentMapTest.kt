@@ -0,0 +1,70 @@
+package com.pulsenetwork.domain.workflow
+
+import org.junit.Assert.*
+import org.junit.Test
+import kotlin.random.Random
+
+/**
+ * 持久化 Map 测试
+ */
+class PersistentMapTest {
+
+    @Test
+    fun `random puts and removes match HashMap`() {
+        val random = Random(7)
+        val expected = HashMap<Int, Int>()
+        var map = PersistentMap.empty<Int, Int>()
+
+        repeat(20_000) {
+            val key = random.nextInt(2_000)
+            if (random.nextInt(3) == 0) {
+                expected.remove(key)
+                map = map.remove(key)
+            } else {
+                val value = random.nextInt()
+                expected[key] = value
+                map = map.put(key, value)
+            }
+        }
+
+        assertEquals(expected.size, map.size)
+        assertEquals(expected, map)
+        assertEquals(expected, HashMap(map))
+        assertEquals(expected.hashCode(), map.hashCode())
+    }
+
+    @Test
+    fun `old versions are unchanged`() {
+        val v1 = PersistentMap.of(mapOf("a" to 1, "b" to 2))
+        val v2 = v1.put("c", 3).remove("a")
+
+        assertEquals(mapOf("a" to 1, "b" to 2), v1)
+        assertEquals(mapOf("b" to 2, "c" to 3), v2)
+        assertSame(v1, v1.put("a", 1))
+        assertSame(v1, v1.remove("missing"))
+        assertSame(v1, v1.toPersistentMap())
+    }
+
+    @Test
+    fun `keys with identical hash codes`() {
+        val keys = (0 until 50).map { CollidingKey(it) }
+        var map = PersistentMap.empty<CollidingKey, Int>()
+        keys.forEach { map = map.put(it, it.id) }
+
+        assertEquals(50, map.size)
+        keys.forEach { assertEquals(it.id, map[it]) }
+
+        for (key in keys.filter { it.id % 2 == 0 }) map = map.remove(key)
+        assertEquals(25, map.size)
+        assertNull(map[CollidingKey(0)])
+        assertEquals(1, map[CollidingKey(1)])
+
+        for (key in keys) map = map.remove(key)
+        assertTrue(map.isEmpty())
+        assertTrue(map.entries.isEmpty())
+    }
+
+    private data class CollidingKey(val id: Int) {
+        override fun hashCode(): Int = 42
+    }
+}
@@ -0,0 +1,38 @@
+package com.pulsenetwork.domain.workflow
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * 预编译提示词模板测试
+ */
+class PromptTemplateTest {
+
+    @Test
+    fun `renders placeholders in one pass`() {
+        val template = PromptTemplate.compile("请把{{text}}翻译成{{lang}}：{{text}}")
+
+        assertEquals(setOf("text", "lang"), template.placeholders)
+        assertEquals("请把你好翻译成英文：你好", template.render(mapOf("text" to "你好", "lang" to "英文")))
+    }
+
+    @Test
+    fun `missing keys stay as placeholders and values are not re-expanded`() {
+        val template = PromptTemplate.compile("{{a}} / {{b}}")
+
+        assertEquals("{{b}} / {{b}}", template.render(mapOf("a" to "{{b}}")))
+        assertEquals("1 / {{b}}", template.render(mapOf("a" to 1)))
+    }
+
+    @Test
+    fun `templates without placeholders and unclosed braces are literal`() {
+        assertEquals("plain", PromptTemplate.compile("plain").render(mapOf("x" to "y")))
+        assertEquals("x{{y", PromptTemplate.compile("x{{y").render(mapOf("y" to "z")))
+    }
+
+    @Test
+    fun `compile reuses cached templates`() {
+        val source = "summarize {{doc}}"
+        assertSame(PromptTemplate.compile(source), PromptTemplate.compile(source))
+    }
+}
@@ -0,0 +1,93 @@
+package com.pulsenetwork.domain.workflow
+
+import org.junit.Assert.*
+import org.junit.Test
+import javax.crypto.AEADBadTagException
+import javax.crypto.Cipher
+import javax.crypto.spec.GCMParameterSpec
+import javax.crypto.spec.SecretKeySpec
+import kotlin.random.Random
+
+/**
+ * 分段认证加密测试（以 JCA 的 AES-GCM 作为单段加密）
+ */
+class SealedStreamTest {
+
+    private class JcaCipher(key: ByteArray) : SegmentCipher {
+        private val key = SecretKeySpec(key, "AES")
+
+        override fun seal(nonce: ByteArray, aad: ByteArray, input: ByteArray, offset: Int, length: Int): ByteArray =
+            cipher(Cipher.ENCRYPT_MODE, nonce, aad).doFinal(input, offset, length)
+
+        override fun open(nonce: ByteArray, aad: ByteArray, input: ByteArray, offset: Int, length: Int): ByteArray? =
+            try {
+                cipher(Cipher.DECRYPT_MODE, nonce, aad).doFinal(input, offset, length)
+            } catch (e: AEADBadTagException) {
+                null
+            }
+
+        private fun cipher(mode: Int, nonce: ByteArray, aad: ByteArray) =
+            Cipher.getInstance("AES/GCM/NoPadding").apply {
+                init(mode, key, GCMParameterSpec(128, nonce))
+                updateAAD(aad)
+            }
+    }
+
+    private val random = Random(11)
+    private val cipher = JcaCipher(random.nextBytes(32))
+    private val prefix = random.nextBytes(SealedStream.NONCE_PREFIX_BYTES)
+
+    @Test
+    fun `segments decrypt independently`() {
+        val steps = listOf("概要", "步骤一", "", "步骤三").map { it.toByteArray() }
+        val reader = SealedStream.open(cipher, SealedStream.seal(cipher, steps, prefix))
+
+        assertEquals(4, reader.size)
+        assertEquals("步骤三", String(reader.segment(3)))
+        assertEquals("步骤一", String(reader.segment(1)))
+        assertEquals(steps.map { String(it) }, reader.segments().map { String(it) }.toList())
+    }
+
+    @Test
+    fun `chunked data round trips`() {
+        val data = random.nextBytes(10_000)
+        val sealed = SealedStream.sealChunked(cipher, data, prefix, chunkBytes = 4096)
+        val reader = SealedStream.open(cipher, sealed)
+
+        assertEquals(3, reader.size)
+        assertArrayEquals(data, reader.readAll())
+        assertArrayEquals(ByteArray(0), SealedStream.open(cipher, SealedStream.sealChunked(cipher, ByteArray(0), prefix)).readAll())
+    }
+
+    @Test
+    fun `tampered segment fails only that segment`() {
+        val sealed = SealedStream.seal(cipher, listOf("a", "b").map { it.toByteArray() }, prefix)
+        sealed[sealed.size - 1] = (sealed[sealed.size - 1].toInt() xor 1).toByte()
+        val reader = SealedStream.open(cipher, sealed)
+
+        assertEquals("a", String(reader.segment(0)))
+        assertThrows(SealedStreamException::class.java) { reader.segment(1) }
+    }
+
+    @Test
+    fun `dropping trailing segments is detected`() {
+        val data = random.nextBytes(3 * 100)
+        val sealed = SealedStream.sealChunked(cipher, data, prefix, chunkBytes = 100)
+        // 头部 12 字节，每段 4 + 100 + 16 字节
+        val truncated = sealed.copyOf(12 + 2 * 120)
+        val reader = SealedStream.open(cipher, truncated)
+
+        assertEquals(2, reader.size)
+        assertArrayEquals(data.copyOf(100), reader.segment(0))
+        assertThrows(SealedStreamException::class.java) { reader.segment(1) }
+    }
+
+    @Test
+    fun `wrong key or garbage is rejected`() {
+        val sealed = SealedStream.seal(cipher, listOf("secret".toByteArray()), prefix)
+        val other = JcaCipher(random.nextBytes(32))
+
+        assertThrows(SealedStreamException::class.java) { SealedStream.open(other, sealed).segment(0) }
+        assertThrows(SealedStreamException::class.java) { SealedStream.open(cipher, "plain json".toByteArray()) }
+    }
+}
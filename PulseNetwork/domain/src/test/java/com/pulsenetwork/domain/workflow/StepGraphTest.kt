@@ -0,0 +1,75 @@
+package com.pulsenetwork.domain.workflow
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * 步骤依赖图测试
+ */
+class StepGraphTest {
+
+    @Test
+    fun `topological order respects dependencies`() {
+        val graph = StepGraph(
+            listOf(
+                step("merge", 3, "left", "right"),
+                step("right", 2, "source"),
+                step("left", 1, "source"),
+                step("source", 0)
+            )
+        )
+
+        val order = graph.topologicalOrder.map { it.id }
+        assertEquals(listOf("source", "left", "right", "merge"), order)
+        assertEquals(listOf("left", "right"), graph.dependents("source"))
+    }
+
+    @Test
+    fun `priority is the longest remaining path`() {
+        // source -> slow(LLM) -> merge, source -> fast(CPU) -> merge
+        val graph = StepGraph(
+            listOf(
+                step("source", 0),
+                step("slow", 1, "source", type = StepType.LOCAL_INFERENCE),
+                step("fast", 2, "source"),
+                step("merge", 3, "slow", "fast")
+            )
+        )
+
+        val cpu = StepGraph.defaultCost(step("x", 0))
+        val llm = StepGraph.defaultCost(step("y", 0, type = StepType.LOCAL_INFERENCE))
+        assertEquals(cpu, graph.priority["merge"])
+        assertEquals(llm + cpu, graph.priority["slow"])
+        assertTrue(graph.priority.getValue("slow") > graph.priority.getValue("fast"))
+        assertEquals(cpu + llm + cpu, graph.criticalPathMs())
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun `cycles are rejected`() {
+        StepGraph(
+            listOf(
+                step("a", 0, "b"),
+                step("b", 1, "a")
+            )
+        )
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun `unknown dependencies are rejected`() {
+        StepGraph(listOf(step("a", 0, "missing")))
+    }
+
+    private fun step(
+        id: String,
+        order: Int,
+        vararg dependencies: String,
+        type: StepType = StepType.DATA_TRANSFORM
+    ) = WorkflowStep(
+        id = id,
+        name = id,
+        type = type,
+        config = StepConfig.DataTransform("noop", emptyMap(), emptyMap()),
+        dependencies = dependencies.toList(),
+        order = order
+    )
+}
@@ -0,0 +1,56 @@
+package com.pulsenetwork.domain.workflow
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * 追踪与耗时统计测试
+ */
+class TracerTest {
+
+    @Test
+    fun `ring buffer keeps the most recent spans`() {
+        val tracer = Tracer(capacity = 3)
+        repeat(5) { tracer.record(TraceSpan("wf", "s$it", "step", it.toLong(), 1, 1)) }
+
+        assertEquals(listOf("s2", "s3", "s4"), tracer.spans().map { it.name })
+    }
+
+    @Test
+    fun `failed block is recorded with error`() {
+        val tracer = Tracer()
+        try {
+            tracer.trace("wf", "boom", "step") { throw IllegalStateException("bad") }
+            fail()
+        } catch (e: IllegalStateException) {
+            // 期望
+        }
+
+        val span = tracer.spans("wf").single()
+        assertEquals("bad", span.args["error"])
+        assertTrue(tracer.spans("other").isEmpty())
+    }
+
+    @Test
+    fun `chrome trace export escapes names`() {
+        val tracer = Tracer()
+        tracer.record(TraceSpan("wf", "say \"hi\"", "llm", 10, 5, 2, mapOf("tokens" to "3")))
+
+        assertEquals(
+            "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[{\"name\":\"say \\\"hi\\\"\",\"cat\":\"llm\"," +
+                "\"ph\":\"X\",\"ts\":10,\"dur\":5,\"pid\":1,\"tid\":2," +
+                "\"args\":{\"traceId\":\"wf\",\"tokens\":\"3\"}}]}",
+            tracer.exportChromeTrace()
+        )
+    }
+
+    @Test
+    fun `latency estimate follows recent samples`() {
+        val stats = StepLatencyStats(alpha = 0.5)
+        assertNull(stats.estimate("a"))
+
+        stats.record("a", 100)
+        stats.record("a", 200)
+        assertEquals(150L, stats.estimate("a"))
+    }
+}